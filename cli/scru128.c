@@ -0,0 +1,640 @@
+/**
+ * @file scru128.c
+ *
+ * Command-line tool that generates and converts SCRU128 IDs in bulk
+ *
+ * Every command streams IDs through stdin and stdout (or reads a file given as
+ * an argument) in blocks of tens of thousands of IDs, so that shell pipelines
+ * can process hundreds of millions of IDs in constant memory (except `sort`).
+ * With `-j`, the text encoding and decoding of each block is split among
+ * threads while the output keeps the input order. See `usage()` for the
+ * commands and options.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _DEFAULT_SOURCE
+#define SCRU128_ENABLE_MMAP
+#define SCRU128_ENABLE_THREADS
+#include "scru128.h"
+#include "scru128_chacha20.h"
+#include "scru128_clock.h"
+#include "scru128_lines.h"
+#include "scru128_sort.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+
+/** The number of IDs converted and written at a time. */
+#define BLOCK_LEN ((size_t)1 << 16)
+
+/** The size in bytes of text decoded at a time. */
+#define CHUNK_SIZE ((size_t)1 << 24)
+
+/** The minimum number of IDs per thread worth starting a thread for. */
+#define MIN_SLICE_LEN ((size_t)1 << 12)
+
+/** The maximum number of threads. */
+#define MAX_THREADS (64)
+
+/** The status code returned for invalid input and I/O errors. */
+#define EXIT_INVALID (1)
+
+/** The status code returned for invalid command-line arguments. */
+#define EXIT_USAGE (2)
+
+/** Represents the command-line options. */
+typedef struct Options {
+  uint64_t n;
+  int binary;
+  int crlf;
+  int unique;
+  int n_threads;
+  const char *path;
+} Options;
+
+/**
+ * Represents a part of a block converted by a thread, which holds the fields of
+ * either direction.
+ */
+typedef struct Slice {
+  const uint8_t *ids;
+  size_t n;
+  char *text_out;
+  int crlf;
+
+  const char *text;
+  size_t len;
+  int is_last;
+  uint8_t *ids_out;
+  size_t n_out;
+  uint64_t n_lines;
+  uint64_t *errors;
+  size_t n_errors;
+} Slice;
+
+/** Represents the progress of decoding text input across chunks. */
+typedef struct TextInput {
+  /** The number of lines decoded so far. */
+  uint64_t line;
+
+  /** The number of invalid lines found so far. */
+  uint64_t n_errors;
+
+  /** Set while skipping a line longer than a chunk. */
+  int is_skipping;
+
+  /** The function that receives the decoded IDs. */
+  void (*sink)(const uint8_t *ids, size_t n, const Options *opts);
+} TextInput;
+
+/** The name of the input reported in error messages. */
+static const char *input_name = "-";
+
+static uint8_t id_buf[SCRU128_LEN * BLOCK_LEN];
+static char text_buf[SCRU128_LINES_MAX_ENCODED_SIZE(BLOCK_LEN)];
+
+/** Prints an error message and exits. */
+static void die(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  fputs("scru128: ", stderr);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+  exit(EXIT_INVALID);
+}
+
+static void *xmalloc(size_t size) {
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == NULL) {
+    die("out of memory");
+  }
+  return p;
+}
+
+static void write_all(const void *buf, size_t len) {
+  if (len > 0 && fwrite(buf, 1, len, stdout) < len) {
+    die("write error: %s", strerror(errno));
+  }
+}
+
+/**
+ * Runs `fn` on each of `n` slices, the first one in the calling thread and the
+ * others in new threads, and waits for all of them.
+ */
+static void run_slices(void *(*fn)(void *), Slice *slices, int n) {
+  pthread_t threads[MAX_THREADS];
+  int is_started[MAX_THREADS] = {0};
+  for (int i = 1; i < n; i++) {
+    is_started[i] = pthread_create(&threads[i], NULL, fn, &slices[i]) == 0;
+    if (!is_started[i]) {
+      (*fn)(&slices[i]);
+    }
+  }
+  (*fn)(&slices[0]);
+  for (int i = 1; i < n; i++) {
+    if (is_started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+}
+
+/** Returns the number of threads to split `n` items among. */
+static int count_slices(size_t n, const Options *opts) {
+  size_t n_slices = (n + MIN_SLICE_LEN - 1) / MIN_SLICE_LEN;
+  n_slices = n_slices < (size_t)opts->n_threads ? n_slices
+                                                 : (size_t)opts->n_threads;
+  return n_slices > 0 ? (int)n_slices : 1;
+}
+
+static void *encode_slice(void *arg) {
+  Slice *s = (Slice *)arg;
+  scru128_lines_encode(s->ids, s->n, s->crlf, s->text_out);
+  return NULL;
+}
+
+/** Writes IDs as text lines. */
+static void write_text(const uint8_t *ids, size_t n, const Options *opts) {
+  size_t line_len = opts->crlf ? SCRU128_STR_LEN + 1 : SCRU128_STR_LEN;
+  while (n > 0) {
+    size_t block_len = n < BLOCK_LEN ? n : BLOCK_LEN;
+    Slice slices[MAX_THREADS];
+    int n_slices = count_slices(block_len, opts);
+    for (int i = 0; i < n_slices; i++) {
+      size_t begin = block_len * (size_t)i / (size_t)n_slices;
+      size_t end = block_len * (size_t)(i + 1) / (size_t)n_slices;
+      slices[i].ids = ids + SCRU128_LEN * begin;
+      slices[i].n = end - begin;
+      slices[i].text_out = text_buf + line_len * begin;
+      slices[i].crlf = opts->crlf;
+    }
+    run_slices(&encode_slice, slices, n_slices);
+    write_all(text_buf, line_len * block_len);
+    ids += SCRU128_LEN * block_len;
+    n -= block_len;
+  }
+}
+
+/** Writes IDs as text lines or binary. */
+static void write_ids(const uint8_t *ids, size_t n, const Options *opts) {
+  if (opts->binary) {
+    write_all(ids, SCRU128_LEN * n);
+  } else {
+    write_text(ids, n, opts);
+  }
+}
+
+/** Records the line number of an invalid line in a slice. */
+static void add_error(Slice *s, uint64_t line) {
+  // grow the array at each power of two
+  if ((s->n_errors & (s->n_errors - 1)) == 0) {
+    size_t cap = s->n_errors > 0 ? s->n_errors * 2 : 1;
+    s->errors = (uint64_t *)realloc(s->errors, sizeof(uint64_t) * cap);
+    if (s->errors == NULL) {
+      die("out of memory");
+    }
+  }
+  s->errors[s->n_errors++] = line;
+}
+
+static void *decode_slice(void *arg) {
+  Slice *s = (Slice *)arg;
+  Scru128LineDecoder d;
+  scru128_line_decoder_init(&d);
+  size_t max_n = s->len / SCRU128_STR_LEN + 1;
+  s->n_out = 0;
+  s->n_errors = 0;
+  s->errors = NULL;
+  for (size_t pos = 0; pos < s->len;) {
+    size_t consumed;
+    ptrdiff_t n = scru128_line_decoder_feed(
+        &d, s->text + pos, s->len - pos, &consumed,
+        s->ids_out + SCRU128_LEN * s->n_out, max_n - s->n_out);
+    if (n < 0) {
+      add_error(s, d.line);
+    } else if (consumed == 0) {
+      break;
+    } else {
+      s->n_out += (size_t)n;
+    }
+    pos += consumed;
+  }
+  if (s->is_last) {
+    int status =
+        scru128_line_decoder_finish(&d, s->ids_out + SCRU128_LEN * s->n_out);
+    if (status < 0) {
+      add_error(s, d.line);
+    } else {
+      s->n_out += (size_t)status;
+    }
+  }
+  s->n_lines = d.line;
+  return NULL;
+}
+
+static void report_invalid_line(TextInput *in, uint64_t line) {
+  fprintf(stderr, "scru128: %s:%" PRIu64 ": invalid SCRU128 string\n",
+          input_name, line);
+  in->n_errors++;
+}
+
+/**
+ * Decodes the complete lines of `data` (and the last line without LF if
+ * `is_eof`) and returns the number of bytes consumed.
+ */
+static size_t decode_text(TextInput *in, const char *data, size_t len,
+                          int is_eof, const Options *opts) {
+  static uint8_t *ids_out = NULL;
+  if (ids_out == NULL) {
+    ids_out = (uint8_t *)xmalloc(SCRU128_LEN *
+                                 (CHUNK_SIZE / SCRU128_STR_LEN + MAX_THREADS));
+  }
+
+  size_t pos = 0;
+  if (in->is_skipping) {
+    const char *lf = (const char *)memchr(data, '\n', len);
+    if (lf == NULL) {
+      in->is_skipping = !is_eof;
+      return len;
+    }
+    in->is_skipping = 0;
+    pos = (size_t)(lf - data) + 1;
+  }
+
+  size_t end = len;
+  if (!is_eof) {
+    while (end > pos && data[end - 1] != '\n') {
+      end--;
+    }
+    if (end == pos) {
+      if (len - pos < CHUNK_SIZE / 2) {
+        return pos; // wait for the rest of the line
+      }
+      // a line longer than a chunk cannot be valid
+      report_invalid_line(in, ++in->line);
+      in->is_skipping = 1;
+      return len;
+    }
+  }
+
+  // split the lines among threads at line boundaries
+  Slice slices[MAX_THREADS];
+  int n_slices = count_slices((end - pos) / SCRU128_STR_LEN, opts);
+  uint8_t *dst = ids_out;
+  size_t begin = pos;
+  for (int i = 0; i < n_slices; i++) {
+    size_t stop = end;
+    if (i < n_slices - 1) {
+      stop = begin + (end - begin) / (size_t)(n_slices - i);
+      const char *lf = (const char *)memchr(data + stop, '\n', end - stop);
+      stop = lf == NULL ? end : (size_t)(lf - data) + 1;
+    }
+    slices[i].text = data + begin;
+    slices[i].len = stop - begin;
+    slices[i].is_last = is_eof && i == n_slices - 1;
+    slices[i].ids_out = dst;
+    dst += SCRU128_LEN * (slices[i].len / SCRU128_STR_LEN + 1);
+    begin = stop;
+  }
+  run_slices(&decode_slice, slices, n_slices);
+
+  for (int i = 0; i < n_slices; i++) {
+    for (size_t j = 0; j < slices[i].n_errors; j++) {
+      report_invalid_line(in, in->line + slices[i].errors[j]);
+    }
+    free(slices[i].errors);
+    in->line += slices[i].n_lines;
+    (*in->sink)(slices[i].ids_out, slices[i].n_out, opts);
+  }
+  return end;
+}
+
+/** Decodes text lines from the input and passes the IDs to `in->sink`. */
+static void read_text(TextInput *in, const Options *opts) {
+  if (opts->path != NULL) {
+    const char *data;
+    size_t len;
+    if (scru128_lines_map(opts->path, &data, &len) != 0) {
+      die("%s: %s", opts->path, strerror(errno));
+    }
+    for (size_t pos = 0; pos < len;) {
+      size_t n_bytes = len - pos < CHUNK_SIZE ? len - pos : CHUNK_SIZE;
+      pos += decode_text(in, data + pos, n_bytes, pos + n_bytes == len, opts);
+    }
+    scru128_lines_unmap(data, len);
+    return;
+  }
+
+  char *buf = (char *)xmalloc(CHUNK_SIZE);
+  size_t len = 0;
+  int is_eof = 0;
+  while (!is_eof) {
+    len += fread(buf + len, 1, CHUNK_SIZE - len, stdin);
+    if (len < CHUNK_SIZE) {
+      if (ferror(stdin)) {
+        die("read error: %s", strerror(errno));
+      }
+      is_eof = 1;
+    }
+    size_t consumed = decode_text(in, buf, len, is_eof, opts);
+    memmove(buf, buf + consumed, len - consumed);
+    len -= consumed;
+  }
+  free(buf);
+}
+
+/** Reads 16-byte binary IDs from the input and passes them to `sink`. */
+static void read_binary(void (*sink)(const uint8_t *, size_t, const Options *),
+                        const Options *opts) {
+  FILE *fp = stdin;
+  if (opts->path != NULL && (fp = fopen(opts->path, "rb")) == NULL) {
+    die("%s: %s", opts->path, strerror(errno));
+  }
+  for (;;) {
+    size_t len = fread(id_buf, 1, sizeof(id_buf), fp);
+    if (len < sizeof(id_buf) && ferror(fp)) {
+      die("read error: %s", strerror(errno));
+    }
+    if (len % SCRU128_LEN != 0) {
+      die("%s: truncated binary ID at the end", input_name);
+    }
+    (*sink)(id_buf, len / SCRU128_LEN, opts);
+    if (len < sizeof(id_buf)) {
+      break;
+    }
+  }
+  if (fp != stdin) {
+    fclose(fp);
+  }
+}
+
+static void fill_random(void *rng, void *buf, size_t nbytes) {
+  if (scru128_chacha20_buf((Scru128ChaCha20 *)rng, buf, nbytes,
+                           &getentropy) != 0) {
+    die("failed to read system entropy");
+  }
+}
+
+static int cmd_generate(const Options *opts) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  Scru128ChaCha20 rng;
+  scru128_chacha20_init(&rng);
+  Scru128RandomSource src = {&rng, &fill_random};
+
+  // generate IDs in one thread to keep them monotonic and convert them to text
+  // in parallel
+  for (uint64_t n = opts->n; n > 0;) {
+    size_t block_len = n < BLOCK_LEN ? (size_t)n : BLOCK_LEN;
+    uint64_t timestamp = scru128_clock_realtime(NULL);
+    if (scru128_generate_batch_or_reset_core_src(&g, id_buf, block_len,
+                                                 timestamp, &src, 10000) < 0) {
+      die("failed to read system clock");
+    }
+    write_ids(id_buf, block_len, opts);
+    n -= block_len;
+  }
+  return 0;
+}
+
+static void write_binary_sink(const uint8_t *ids, size_t n,
+                              const Options *opts) {
+  (void)opts;
+  write_all(ids, SCRU128_LEN * n);
+}
+
+static int cmd_decode(const Options *opts) {
+  TextInput in = {0, 0, 0, &write_binary_sink};
+  read_text(&in, opts);
+  return in.n_errors > 0 ? EXIT_INVALID : 0;
+}
+
+static int cmd_encode(const Options *opts) {
+  read_binary(&write_text, opts);
+  return 0;
+}
+
+static void inspect_sink(const uint8_t *ids, size_t n, const Options *opts) {
+  (void)opts;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *id = ids + SCRU128_LEN * i;
+    char str[SCRU128_STR_LEN];
+    scru128_to_str(id, str);
+    uint64_t timestamp = scru128_timestamp(id);
+    time_t seconds = (time_t)(timestamp / 1000);
+    struct tm tm;
+    char time_str[32] = "-";
+    if (gmtime_r(&seconds, &tm) != NULL) {
+      size_t len = strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S",
+                            &tm);
+      snprintf(time_str + len, sizeof(time_str) - len, ".%03uZ",
+               (unsigned)(timestamp % 1000));
+    }
+    printf("%s\t%" PRIu64 "\t%s\t%" PRIu32 "\t%" PRIu32 "\t%" PRIu32 "\n", str,
+           timestamp, time_str, scru128_counter_hi(id), scru128_counter_lo(id),
+           scru128_entropy(id));
+  }
+  if (ferror(stdout)) {
+    die("write error: %s", strerror(errno));
+  }
+}
+
+static int cmd_inspect(const Options *opts) {
+  printf("id\ttimestamp\ttime\tcounter_hi\tcounter_lo\tentropy\n");
+  if (opts->binary) {
+    read_binary(&inspect_sink, opts);
+    return 0;
+  }
+  TextInput in = {0, 0, 0, &inspect_sink};
+  read_text(&in, opts);
+  return in.n_errors > 0 ? EXIT_INVALID : 0;
+}
+
+/** The IDs collected by `cmd_sort()`. */
+static uint8_t *sort_ids = NULL;
+static size_t sort_n = 0, sort_cap = 0;
+
+static void append_sink(const uint8_t *ids, size_t n, const Options *opts) {
+  (void)opts;
+  if (sort_cap - sort_n < n) {
+    while (sort_cap - sort_n < n) {
+      sort_cap = sort_cap > 0 ? sort_cap * 2 : BLOCK_LEN;
+    }
+    sort_ids = (uint8_t *)realloc(sort_ids, SCRU128_LEN * sort_cap);
+    if (sort_ids == NULL) {
+      die("out of memory");
+    }
+  }
+  memcpy(sort_ids + SCRU128_LEN * sort_n, ids, SCRU128_LEN * n);
+  sort_n += n;
+}
+
+static int cmd_sort(const Options *opts) {
+  int status = 0;
+  if (opts->binary) {
+    read_binary(&append_sink, opts);
+  } else {
+    TextInput in = {0, 0, 0, &append_sink};
+    read_text(&in, opts);
+    status = in.n_errors > 0 ? EXIT_INVALID : 0;
+  }
+
+  // fall back to the in-place sort if the scratch buffer is unavailable
+  uint8_t *scratch = (uint8_t *)malloc(SCRU128_LEN * sort_n);
+  scru128_sort_parallel(sort_ids, sort_n, scratch, opts->n_threads);
+  free(scratch);
+
+  if (opts->unique && sort_n > 0) {
+    size_t n = 1;
+    for (size_t i = 1; i < sort_n; i++) {
+      uint8_t *last = sort_ids + SCRU128_LEN * (n - 1);
+      const uint8_t *curr = sort_ids + SCRU128_LEN * i;
+      if (memcmp(last, curr, SCRU128_LEN) != 0) {
+        memmove(last + SCRU128_LEN, curr, SCRU128_LEN);
+        n++;
+      }
+    }
+    sort_n = n;
+  }
+  write_ids(sort_ids, sort_n, opts);
+  free(sort_ids);
+  return status;
+}
+
+static void usage(FILE *fp) {
+  fputs(
+      "usage: scru128 <command> [options] [file]\n"
+      "\n"
+      "commands:\n"
+      "  generate [-n count] [-b] [-c] [-j threads]\n"
+      "      generate new IDs in ascending order\n"
+      "  encode [-c] [-j threads] [file]\n"
+      "      convert 16-byte binary IDs to text lines\n"
+      "  decode [-j threads] [file]\n"
+      "      convert text lines to 16-byte binary IDs\n"
+      "  inspect [-b] [file]\n"
+      "      print the field values of IDs as tab-separated values\n"
+      "  sort [-b] [-c] [-u] [-j threads] [file]\n"
+      "      sort IDs in ascending order\n"
+      "\n"
+      "options:\n"
+      "  -n count    number of IDs to generate (default: 1)\n"
+      "  -b          use 16-byte binary IDs instead of text lines\n"
+      "  -c          terminate output lines with CRLF instead of LF\n"
+      "  -u          remove duplicate IDs\n"
+      "  -j threads  number of threads, or 0 for all processors (default: 1)\n"
+      "\n"
+      "Input is read from file if given or from stdin otherwise, and output\n"
+      "is written to stdout. Text input accepts LF and CRLF.\n",
+      fp);
+}
+
+int main(int argc, char **argv) {
+  static const struct {
+    const char *name;
+    const char *optstring;
+    int (*run)(const Options *);
+  } commands[] = {
+      {"generate", "n:bcj:", &cmd_generate}, {"encode", "cj:", &cmd_encode},
+      {"decode", "j:", &cmd_decode},         {"inspect", "b", &cmd_inspect},
+      {"sort", "bcuj:", &cmd_sort},
+  };
+
+  if (argc < 2 || strcmp(argv[1], "-h") == 0 ||
+      strcmp(argv[1], "--help") == 0) {
+    usage(argc < 2 ? stderr : stdout);
+    return argc < 2 ? EXIT_USAGE : 0;
+  }
+  size_t cmd = 0;
+  while (cmd < sizeof(commands) / sizeof(commands[0]) &&
+         strcmp(argv[1], commands[cmd].name) != 0) {
+    cmd++;
+  }
+  if (cmd == sizeof(commands) / sizeof(commands[0])) {
+    fprintf(stderr, "scru128: unknown command: %s\n", argv[1]);
+    usage(stderr);
+    return EXIT_USAGE;
+  }
+
+  Options opts = {1, 0, 0, 0, 1, NULL};
+  int opt;
+  char *end;
+  while ((opt = getopt(argc - 1, argv + 1, commands[cmd].optstring)) != -1) {
+    switch (opt) {
+    case 'n':
+      errno = 0;
+      opts.n = strtoull(optarg, &end, 10);
+      if (errno != 0 || *end != '\0' || optarg[0] == '-') {
+        fprintf(stderr, "scru128: invalid count: %s\n", optarg);
+        return EXIT_USAGE;
+      }
+      break;
+    case 'b':
+      opts.binary = 1;
+      break;
+    case 'c':
+      opts.crlf = 1;
+      break;
+    case 'u':
+      opts.unique = 1;
+      break;
+    case 'j':
+      opts.n_threads = (int)strtol(optarg, &end, 10);
+      if (*end != '\0' || opts.n_threads < 0) {
+        fprintf(stderr, "scru128: invalid number of threads: %s\n", optarg);
+        return EXIT_USAGE;
+      }
+      if (opts.n_threads == 0) {
+        long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        opts.n_threads = n_cpus > 0 ? (int)n_cpus : 1;
+      }
+      opts.n_threads =
+          opts.n_threads < MAX_THREADS ? opts.n_threads : MAX_THREADS;
+      break;
+    default:
+      usage(stderr);
+      return EXIT_USAGE;
+    }
+  }
+  if (optind + 1 < argc - 1 ||
+      (optind + 1 == argc - 1 && commands[cmd].run == &cmd_generate)) {
+    usage(stderr);
+    return EXIT_USAGE;
+  }
+  if (optind + 1 == argc - 1 && strcmp(argv[optind + 1], "-") != 0) {
+    opts.path = argv[optind + 1];
+    input_name = opts.path;
+  }
+
+  setvbuf(stdout, NULL, _IOFBF, (size_t)1 << 20);
+  int status = (*commands[cmd].run)(&opts);
+  if (fflush(stdout) != 0) {
+    die("write error: %s", strerror(errno));
+  }
+  return status;
+}
@@ -1,15 +1,77 @@
 #include "scru128.h"
+#include "scru128_clock.h"
 
 #include <stdlib.h> // or <bsd/stdlib.h> on Linux with libbsd
-#include <time.h>
+
+/**
+ * The clock used by generator functions, which defaults to `CLOCK_REALTIME`.
+ */
+static Scru128Clock clock_hook = {NULL, &scru128_clock_realtime};
+
+void scru128_set_clock(const Scru128Clock *clock) { clock_hook = *clock; }
+
+/** Returns the current Unix time in milliseconds, or zero on error. */
+static uint64_t get_timestamp(void) { return scru128_clock_now(&clock_hook); }
+
+/** The generator of each thread, aligned to avoid false sharing. */
+static __thread Scru128Generator thread_generator __attribute__((aligned(64)));
+
+/** The greatest `timestamp` returned by `scru128_generate_tls_ordered()`. */
+static uint64_t ordered_watermark;
 
 int scru128_generate(Scru128Generator *g, uint8_t *id_out) {
-  struct timespec tp;
-  int err = clock_gettime(CLOCK_REALTIME, &tp);
-  if (err) {
-    return SCRU128_GENERATOR_STATUS_ERROR;
-  }
-  uint64_t timestamp = (uint64_t)tp.tv_sec * 1000 + tp.tv_nsec / 1000000;
+  uint64_t timestamp = get_timestamp();
   return scru128_generate_or_reset_core(g, id_out, timestamp, &arc4random,
                                         10000);
 }
+
+int scru128_generate_batch(Scru128Generator *g, uint8_t *ids_out, size_t n) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generate_batch_or_reset_core(g, ids_out, n, timestamp,
+                                              &arc4random_buf, 10000);
+}
+
+int scru128_generator_reserve(Scru128Generator *g, size_t n,
+                              Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generator_reserve_or_reset_core(g, n, block_out, timestamp,
+                                                 &arc4random, 10000);
+}
+
+int scru128_atomic_generate(Scru128AtomicGenerator *g, uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generate_or_reset_core(g, id_out, timestamp,
+                                               &arc4random, 10000);
+}
+
+int scru128_atomic_generator_reserve(Scru128AtomicGenerator *g, size_t n,
+                                     Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generator_reserve_or_reset_core(
+      g, n, block_out, timestamp, &arc4random, 10000);
+}
+
+int scru128_generate_tls(uint8_t *id_out) {
+  return scru128_generate(&thread_generator, id_out);
+}
+
+#ifdef SCRU128_ENABLE_STATS
+void scru128_tls_generator_stats(Scru128GeneratorStats *stats_out) {
+  scru128_generator_stats(&thread_generator, stats_out);
+}
+#endif
+
+int scru128_generate_tls_ordered(uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  if (timestamp == 0) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  }
+  timestamp = scru128_atomic_raise_watermark(&ordered_watermark, timestamp);
+  int status = scru128_generate_or_reset_core(&thread_generator, id_out,
+                                              timestamp, &arc4random, 10000);
+  if (status >= 0) {
+    scru128_atomic_raise_watermark(&ordered_watermark,
+                                   scru128_timestamp(id_out));
+  }
+  return status;
+}
@@ -0,0 +1,133 @@
+#include "scru128.h"
+#include "scru128_chacha20.h"
+#include "scru128_clock.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+
+static __thread Scru128ChaCha20 *thread_rng;
+
+static pthread_key_t rng_key;
+
+static pthread_once_t rng_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Releases the state at thread exit. `thread_rng` is cleared so that IDs
+ * generated by later TLS destructors allocate a new state instead of writing to
+ * the unmapped page.
+ */
+static void free_rng(void *rng) {
+  thread_rng = NULL;
+  munmap(rng, sizeof(Scru128ChaCha20));
+}
+
+static void create_rng_key(void) { pthread_key_create(&rng_key, &free_rng); }
+
+/** Returns the random number generator of the current thread, or aborts. */
+static Scru128ChaCha20 *get_rng(void) {
+  if (thread_rng == NULL) {
+    void *page = mmap(NULL, sizeof(Scru128ChaCha20), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+      abort();
+    }
+    // zero-fill the state in child processes so that they reseed themselves
+    if (madvise(page, sizeof(Scru128ChaCha20), MADV_WIPEONFORK) != 0 ||
+        pthread_once(&rng_key_once, &create_rng_key) != 0 ||
+        pthread_setspecific(rng_key, page) != 0) {
+      abort();
+    }
+    thread_rng = (Scru128ChaCha20 *)page;
+  }
+  return thread_rng;
+}
+
+static void fill_random(void *rng, void *buf, size_t nbytes) {
+  if (scru128_chacha20_buf((Scru128ChaCha20 *)rng, buf, nbytes,
+                           &getentropy) != 0) {
+    abort();
+  }
+}
+
+static uint32_t get_random_uint32(void) {
+  uint32_t n;
+  fill_random(get_rng(), &n, sizeof(uint32_t));
+  return n;
+}
+
+/**
+ * The clock used by generator functions, which defaults to `CLOCK_REALTIME`.
+ */
+static Scru128Clock clock_hook = {NULL, &scru128_clock_realtime};
+
+void scru128_set_clock(const Scru128Clock *clock) { clock_hook = *clock; }
+
+/** Returns the current Unix time in milliseconds, or zero on error. */
+static uint64_t get_timestamp(void) { return scru128_clock_now(&clock_hook); }
+
+/** The generator of each thread, aligned to avoid false sharing. */
+static __thread Scru128Generator thread_generator __attribute__((aligned(64)));
+
+/** The greatest `timestamp` returned by `scru128_generate_tls_ordered()`. */
+static uint64_t ordered_watermark;
+
+int scru128_generate(Scru128Generator *g, uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  Scru128RandomSource src = {get_rng(), &fill_random};
+  return scru128_generate_or_reset_core_src(g, id_out, timestamp, &src, 10000);
+}
+
+int scru128_generate_batch(Scru128Generator *g, uint8_t *ids_out, size_t n) {
+  uint64_t timestamp = get_timestamp();
+  Scru128RandomSource src = {get_rng(), &fill_random};
+  return scru128_generate_batch_or_reset_core_src(g, ids_out, n, timestamp,
+                                                  &src, 10000);
+}
+
+int scru128_generator_reserve(Scru128Generator *g, size_t n,
+                              Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generator_reserve_or_reset_core(g, n, block_out, timestamp,
+                                                 &get_random_uint32, 10000);
+}
+
+int scru128_atomic_generate(Scru128AtomicGenerator *g, uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generate_or_reset_core(g, id_out, timestamp,
+                                               &get_random_uint32, 10000);
+}
+
+int scru128_atomic_generator_reserve(Scru128AtomicGenerator *g, size_t n,
+                                     Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generator_reserve_or_reset_core(
+      g, n, block_out, timestamp, &get_random_uint32, 10000);
+}
+
+int scru128_generate_tls(uint8_t *id_out) {
+  return scru128_generate(&thread_generator, id_out);
+}
+
+#ifdef SCRU128_ENABLE_STATS
+void scru128_tls_generator_stats(Scru128GeneratorStats *stats_out) {
+  scru128_generator_stats(&thread_generator, stats_out);
+}
+#endif
+
+int scru128_generate_tls_ordered(uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  if (timestamp == 0) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  }
+  timestamp = scru128_atomic_raise_watermark(&ordered_watermark, timestamp);
+  Scru128RandomSource src = {get_rng(), &fill_random};
+  int status = scru128_generate_or_reset_core_src(&thread_generator, id_out,
+                                                  timestamp, &src, 10000);
+  if (status >= 0) {
+    scru128_atomic_raise_watermark(&ordered_watermark,
+                                   scru128_timestamp(id_out));
+  }
+  return status;
+}
@@ -0,0 +1,174 @@
+#include "scru128.h"
+#include "scru128_clock.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+
+/**
+ * A page-sized per-thread buffer of random bytes refilled by a single
+ * `getrandom()` call.
+ *
+ * The page is marked with `MADV_WIPEONFORK` so that a child process sees a
+ * zero-filled page (i.e., an empty pool) and never reuses the parent's bytes.
+ */
+typedef struct EntropyPool {
+  /** The number of unconsumed bytes at the end of `bytes`. */
+  size_t n_avail;
+
+  uint8_t bytes[4096 - sizeof(size_t)];
+} EntropyPool;
+
+static __thread EntropyPool *thread_pool;
+
+static pthread_key_t pool_key;
+
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Releases the pool at thread exit. `thread_pool` is cleared so that IDs
+ * generated by later TLS destructors allocate a new pool instead of writing to
+ * the unmapped page.
+ */
+static void free_pool(void *pool) {
+  thread_pool = NULL;
+  munmap(pool, sizeof(EntropyPool));
+}
+
+static void create_pool_key(void) { pthread_key_create(&pool_key, &free_pool); }
+
+/** Fills `buf` with random bytes directly from the kernel, or aborts. */
+static void fill_from_kernel(void *buf, size_t nbytes) {
+  for (size_t i = 0; i < nbytes;) {
+    ssize_t n = getrandom((uint8_t *)buf + i, nbytes - i, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      abort();
+    }
+    i += (size_t)n;
+  }
+}
+
+/** Returns the pool of the current thread, or `NULL` if unavailable. */
+static EntropyPool *get_pool(void) {
+  if (thread_pool == NULL) {
+    void *page = mmap(NULL, sizeof(EntropyPool), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+      return NULL;
+    }
+    // never buffer random bytes if they could be inherited by child processes
+    if (madvise(page, sizeof(EntropyPool), MADV_WIPEONFORK) != 0 ||
+        pthread_once(&pool_key_once, &create_pool_key) != 0 ||
+        pthread_setspecific(pool_key, page) != 0) {
+      munmap(page, sizeof(EntropyPool));
+      return NULL;
+    }
+    thread_pool = (EntropyPool *)page;
+  }
+  return thread_pool;
+}
+
+static void get_random_buf(void *buf, size_t nbytes) {
+  EntropyPool *pool = get_pool();
+  if (pool == NULL || nbytes > sizeof(pool->bytes)) {
+    fill_from_kernel(buf, nbytes);
+    return;
+  }
+
+  if (pool->n_avail < nbytes) {
+    fill_from_kernel(pool->bytes, sizeof(pool->bytes));
+    pool->n_avail = sizeof(pool->bytes);
+  }
+
+  // copy and wipe consumed bytes so that they do not remain in memory
+  uint8_t *src = pool->bytes + sizeof(pool->bytes) - pool->n_avail;
+  memcpy(buf, src, nbytes);
+  memset(src, 0, nbytes);
+  pool->n_avail -= nbytes;
+}
+
+static uint32_t get_random_uint32(void) {
+  uint32_t n;
+  get_random_buf(&n, sizeof(uint32_t));
+  return n;
+}
+
+/**
+ * The clock used by generator functions, which defaults to `CLOCK_REALTIME`.
+ */
+static Scru128Clock clock_hook = {NULL, &scru128_clock_realtime};
+
+void scru128_set_clock(const Scru128Clock *clock) { clock_hook = *clock; }
+
+/** Returns the current Unix time in milliseconds, or zero on error. */
+static uint64_t get_timestamp(void) { return scru128_clock_now(&clock_hook); }
+
+/** The generator of each thread, aligned to avoid false sharing. */
+static __thread Scru128Generator thread_generator __attribute__((aligned(64)));
+
+/** The greatest `timestamp` returned by `scru128_generate_tls_ordered()`. */
+static uint64_t ordered_watermark;
+
+int scru128_generate(Scru128Generator *g, uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generate_or_reset_core(g, id_out, timestamp,
+                                        &get_random_uint32, 10000);
+}
+
+int scru128_generate_batch(Scru128Generator *g, uint8_t *ids_out, size_t n) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generate_batch_or_reset_core(g, ids_out, n, timestamp,
+                                              &get_random_buf, 10000);
+}
+
+int scru128_generator_reserve(Scru128Generator *g, size_t n,
+                              Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_generator_reserve_or_reset_core(g, n, block_out, timestamp,
+                                                 &get_random_uint32, 10000);
+}
+
+int scru128_atomic_generate(Scru128AtomicGenerator *g, uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generate_or_reset_core(g, id_out, timestamp,
+                                               &get_random_uint32, 10000);
+}
+
+int scru128_atomic_generator_reserve(Scru128AtomicGenerator *g, size_t n,
+                                     Scru128CounterBlock *block_out) {
+  uint64_t timestamp = get_timestamp();
+  return scru128_atomic_generator_reserve_or_reset_core(
+      g, n, block_out, timestamp, &get_random_uint32, 10000);
+}
+
+int scru128_generate_tls(uint8_t *id_out) {
+  return scru128_generate(&thread_generator, id_out);
+}
+
+#ifdef SCRU128_ENABLE_STATS
+void scru128_tls_generator_stats(Scru128GeneratorStats *stats_out) {
+  scru128_generator_stats(&thread_generator, stats_out);
+}
+#endif
+
+int scru128_generate_tls_ordered(uint8_t *id_out) {
+  uint64_t timestamp = get_timestamp();
+  if (timestamp == 0) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  }
+  timestamp = scru128_atomic_raise_watermark(&ordered_watermark, timestamp);
+  int status =
+      scru128_generate_or_reset_core(&thread_generator, id_out, timestamp,
+                                     &get_random_uint32, 10000);
+  if (status >= 0) {
+    scru128_atomic_raise_watermark(&ordered_watermark,
+                                   scru128_timestamp(id_out));
+  }
+  return status;
+}
@@ -0,0 +1,70 @@
+// Link this file together with another platform example that implements
+// `scru128_atomic_generate()`.
+#include "scru128.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __x86_64__
+#include <cpuid.h>
+#endif
+
+/**
+ * Returns true if atomic operations on `g` do not depend on a lock private to
+ * the process, which does not work across processes.
+ */
+static int is_address_free(Scru128AtomicGenerator *g) {
+#if defined(__x86_64__)
+  // libatomic uses CMPXCHG16B for 16-byte objects if the CPU supports it and
+  // process-private locks otherwise, while `__atomic_is_lock_free()` and
+  // `__atomic_always_lock_free()` report false in both cases (even with
+  // `-mcx16`), so check the same CPUID flag as libatomic does
+  unsigned eax, ebx, ecx, edx;
+  (void)g;
+  return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_CMPXCHG16B) != 0;
+#elif defined(__aarch64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+  // 16-byte compare-and-swap is native (LDXP/STXP or CASP) on every AArch64
+  // CPU, and libatomic uses it when the compiler provides it
+  (void)g;
+  return 1;
+#else
+  return __atomic_is_lock_free(sizeof(*g), g);
+#endif
+}
+
+Scru128AtomicGenerator *scru128_shared_generator_open(const char *name) {
+  int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  // a newly created object is extended with zeros, which represent an
+  // initialized generator, while an existing one is left untouched because
+  // some systems (e.g., macOS) reject `ftruncate()` on a sized object
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (st.st_size < (off_t)sizeof(Scru128AtomicGenerator) &&
+       ftruncate(fd, sizeof(Scru128AtomicGenerator)) != 0)) {
+    close(fd);
+    return NULL;
+  }
+  void *addr = mmap(NULL, sizeof(Scru128AtomicGenerator),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return NULL;
+  }
+
+  Scru128AtomicGenerator *g = (Scru128AtomicGenerator *)addr;
+  if (!is_address_free(g)) {
+    munmap(addr, sizeof(Scru128AtomicGenerator));
+    return NULL;
+  }
+  return g;
+}
+
+void scru128_shared_generator_close(Scru128AtomicGenerator *g) {
+  munmap(g, sizeof(Scru128AtomicGenerator));
+}
@@ -26,8 +26,19 @@
 #ifndef SCRU128_H_AVJRBJQI
 #define SCRU128_H_AVJRBJQI
 
+#include <stddef.h>
 #include <stdint.h>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+
+/**
+ * Defined if the batch string conversion functions have x86 SIMD kernels,
+ * which are selected at run time according to the CPU features.
+ */
+#define SCRU128_HAS_X86_SIMD (1)
+#endif
+
 /**
  * The size in bytes of a SCRU128 ID in the binary representation (16 bytes).
  */
@@ -87,11 +98,64 @@
 
 /** @} */
 
+#ifdef SCRU128_ENABLE_STATS
+/**
+ * Represents the statistics collected by a generator, which are available if
+ * `SCRU128_ENABLE_STATS` is defined before including this header.
+ *
+ * Each status counter counts the calls of the generator functions (including
+ * batch generation and reservation functions) that resulted in the status, so
+ * the counters sum up to the number of calls. A call that resets a generator
+ * upon significant timestamp rollback is counted only by `n_rollback_reset`.
+ *
+ * @note `SCRU128_ENABLE_STATS` changes the layout of `Scru128Generator`, so it
+ * must be defined consistently in all translation units sharing generators.
+ */
+typedef struct Scru128GeneratorStats {
+  /** The number of `SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP` results. */
+  uint64_t n_new_timestamp;
+
+  /** The number of `SCRU128_GENERATOR_STATUS_COUNTER_LO_INC` results. */
+  uint64_t n_counter_lo_inc;
+
+  /** The number of `SCRU128_GENERATOR_STATUS_COUNTER_HI_INC` results. */
+  uint64_t n_counter_hi_inc;
+
+  /**
+   * The number of `SCRU128_GENERATOR_STATUS_TIMESTAMP_INC` results, which
+   * indicate that the generator ran ahead of the clock.
+   */
+  uint64_t n_timestamp_inc;
+
+  /** The number of `SCRU128_GENERATOR_STATUS_ROLLBACK_RESET` results. */
+  uint64_t n_rollback_reset;
+
+  /** The number of `SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT` results. */
+  uint64_t n_rollback_abort;
+
+  /** The number of `SCRU128_GENERATOR_STATUS_ERROR` results. */
+  uint64_t n_error;
+
+  /**
+   * The greatest amount in milliseconds by which the generator's `timestamp`
+   * exceeded the `timestamp` supplied by the caller.
+   */
+  uint64_t max_drift;
+
+  /**
+   * The number of calls of the random number generator (`arc4random` or the
+   * `fill` function of a random source).
+   */
+  uint64_t n_rng_calls;
+} Scru128GeneratorStats;
+#endif /* #ifdef SCRU128_ENABLE_STATS */
+
 /**
  * Represents a SCRU128 ID generator that encapsulates the monotonic counter and
  * other internal states.
  *
- * A new generator must be initialized by `scru128_generator_init()` before use.
+ * A new generator must be initialized by `scru128_generator_init()` or
+ * `scru128_generator_init_sharded()` before use.
  */
 typedef struct Scru128Generator {
   /** @private */
@@ -109,8 +173,137 @@ typedef struct Scru128Generator {
    * @private
    */
   uint64_t _ts_counter_hi;
+
+  /**
+   * The node or shard ID placed in the upper bits of `counter_hi` field.
+   *
+   * @private
+   */
+  uint32_t _shard;
+
+  /**
+   * The number of the upper bits of `counter_hi` field reserved for `_shard`.
+   *
+   * @private
+   */
+  uint32_t _shard_bits;
+
+#ifdef SCRU128_ENABLE_STATS
+  /** @private */
+  Scru128GeneratorStats _stats;
+#endif
 } Scru128Generator;
 
+#if defined(__GNUC__) && defined(__ATOMIC_ACQ_REL)
+/**
+ * Defined if the compiler supports the `__atomic` builtins required by the
+ * lock-free generator (`Scru128AtomicGenerator`).
+ */
+#define SCRU128_HAS_ATOMIC_GENERATOR (1)
+
+/**
+ * Represents the 128-bit packed state of `Scru128AtomicGenerator`, which is
+ * updated as a whole by 16-byte compare-and-swap operations.
+ *
+ * @private
+ */
+typedef struct Scru128AtomicState {
+  /**
+   * The 48-bit `timestamp` in the upper bits and the 16-bit `ttl` (the number
+   * of milliseconds left until the next renewal of `counter_hi`, which is zero
+   * if `counter_hi` has never been initialized) in the lower bits.
+   *
+   * @private
+   */
+  uint64_t _timestamp_ttl;
+
+  /**
+   * The 24-bit `counter_hi` in the upper bits and the 24-bit `counter_lo` in
+   * the lower bits.
+   *
+   * @private
+   */
+  uint64_t _counters;
+} __attribute__((aligned(16))) Scru128AtomicState;
+
+/**
+ * Represents a lock-free, thread-safe SCRU128 ID generator that encapsulates
+ * the monotonic counter and other internal states in a single 128-bit word.
+ *
+ * A new generator must be initialized by `scru128_atomic_generator_init()`
+ * before use. A zero-filled struct is also an initialized generator, so a
+ * generator can be placed in zero-filled memory shared among processes.
+ *
+ * @note The generator relies on 16-byte atomic operations, which may require
+ * linking with `-latomic` (GCC) or compiling with `-mcx16` (x86-64) to be
+ * lock-free.
+ */
+typedef struct Scru128AtomicGenerator {
+  /** @private */
+  Scru128AtomicState _state;
+
+  /**
+   * The node or shard ID placed in the upper bits of `counter_hi` field.
+   *
+   * @private
+   */
+  uint32_t _shard;
+
+  /**
+   * The number of the upper bits of `counter_hi` field reserved for `_shard`.
+   *
+   * @private
+   */
+  uint32_t _shard_bits;
+} Scru128AtomicGenerator;
+#endif /* #if defined(__GNUC__) && defined(__ATOMIC_ACQ_REL) */
+
+/**
+ * Represents a source of (cryptographically strong) random bytes that carries
+ * its own context, such as a per-generator random number generator state.
+ */
+typedef struct Scru128RandomSource {
+  /** An opaque pointer passed to `fill` as the first argument. */
+  void *ctx;
+
+  /** A function that fills `buf` with `nbytes` random bytes. */
+  void (*fill)(void *ctx, void *buf, size_t nbytes);
+} Scru128RandomSource;
+
+/**
+ * Represents a contiguous range of `(timestamp, counter_hi, counter_lo)` values
+ * reserved from a generator, from which IDs can be created without accessing
+ * the generator.
+ *
+ * A block is filled by `scru128_generator_reserve()` or the related functions
+ * and consumed by `scru128_counter_block_generate()`. A zero-filled struct is
+ * an empty block.
+ */
+typedef struct Scru128CounterBlock {
+  /** @private */
+  uint64_t _timestamp;
+
+  /** @private */
+  uint32_t _counter_hi;
+
+  /** @private */
+  uint32_t _counter_lo;
+
+  /**
+   * The number of the upper bits of `counter_hi` fixed within the block.
+   *
+   * @private
+   */
+  uint32_t _shard_bits;
+
+  /**
+   * The number of values left in the block.
+   *
+   * @private
+   */
+  size_t _n_remaining;
+} Scru128CounterBlock;
+
 /** @private */
 static const uint64_t SCRU128_MAX_TIMESTAMP = 0xffffffffffff;
 
@@ -120,6 +313,37 @@ static const uint32_t SCRU128_MAX_COUNTER_HI = 0xffffff;
 /** @private */
 static const uint32_t SCRU128_MAX_COUNTER_LO = 0xffffff;
 
+/**
+ * A table that maps each byte to the value of the Base36 digit it represents
+ * (case-insensitively) or `0xff` if it is not a digit.
+ *
+ * @private
+ */
+static const uint8_t SCRU128_DECODE_MAP[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+    0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c,
+    0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
+    0x21, 0x22, 0x23, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff,
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -172,6 +396,35 @@ static inline int scru128_from_fields(uint8_t *id_out, uint64_t timestamp,
   return 0;
 }
 
+/**
+ * Creates the smallest SCRU128 ID that has the given `timestamp`, which is the
+ * inclusive lower bound of the IDs generated in the millisecond.
+ *
+ * @param id_out A 16-byte byte array where the created SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @return Zero on success or a non-zero integer if `timestamp` is out of the
+ * value range of the field.
+ */
+static inline int scru128_min_for_timestamp(uint8_t *id_out,
+                                            uint64_t timestamp) {
+  return scru128_from_fields(id_out, timestamp, 0, 0, 0);
+}
+
+/**
+ * Creates the largest SCRU128 ID that has the given `timestamp`, which is the
+ * inclusive upper bound of the IDs generated in the millisecond.
+ *
+ * @param id_out A 16-byte byte array where the created SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @return Zero on success or a non-zero integer if `timestamp` is out of the
+ * value range of the field.
+ */
+static inline int scru128_max_for_timestamp(uint8_t *id_out,
+                                            uint64_t timestamp) {
+  return scru128_from_fields(id_out, timestamp, SCRU128_MAX_COUNTER_HI,
+                             SCRU128_MAX_COUNTER_LO, 0xffffffff);
+}
+
 /**
  * Copies a SCRU128 ID from `id_src` to `id_dst`.
  *
@@ -184,224 +437,1356 @@ static inline void scru128_copy(uint8_t *id_dst, const uint8_t *id_src) {
   }
 }
 
+#ifdef SCRU128_HAS_X86_SIMD
 /**
- * Creates a SCRU128 ID from a 25-digit string representation.
+ * Returns the widest x86 SIMD instruction set extension that the CPU supports
+ * and the batch string codecs have kernels for: `3` for AVX-512BW, `2` for AVX2
+ * with FMA, `1` for SSE4.1, or `0` for none of them.
  *
- * @param id_out A 16-byte byte array where the created SCRU128 ID is stored.
- * @param str A null-terminated character array containing the 25-digit string
- * representation.
- * @return Zero on success or a non-zero integer if `str` is not a valid string
- * representation.
+ * @private
  */
-static inline int scru128_from_str(uint8_t *id_out, const char *str) {
-  uint8_t src[25];
-  for (int_fast8_t i = 0; i < 25; i++) {
-    char c = str[i];
-    // clang-format off
-    src[i] = (  c == '0' ?  0 : c == '1' ?  1 : c == '2' ?  2 : c == '3' ?  3
-              : c == '4' ?  4 : c == '5' ?  5 : c == '6' ?  6 : c == '7' ?  7
-              : c == '8' ?  8 : c == '9' ?  9 : c == 'A' ? 10 : c == 'B' ? 11
-              : c == 'C' ? 12 : c == 'D' ? 13 : c == 'E' ? 14 : c == 'F' ? 15
-              : c == 'G' ? 16 : c == 'H' ? 17 : c == 'I' ? 18 : c == 'J' ? 19
-              : c == 'K' ? 20 : c == 'L' ? 21 : c == 'M' ? 22 : c == 'N' ? 23
-              : c == 'O' ? 24 : c == 'P' ? 25 : c == 'Q' ? 26 : c == 'R' ? 27
-              : c == 'S' ? 28 : c == 'T' ? 29 : c == 'U' ? 30 : c == 'V' ? 31
-              : c == 'W' ? 32 : c == 'X' ? 33 : c == 'Y' ? 34 : c == 'Z' ? 35
-              : c == 'a' ? 10 : c == 'b' ? 11 : c == 'c' ? 12 : c == 'd' ? 13
-              : c == 'e' ? 14 : c == 'f' ? 15 : c == 'g' ? 16 : c == 'h' ? 17
-              : c == 'i' ? 18 : c == 'j' ? 19 : c == 'k' ? 20 : c == 'l' ? 21
-              : c == 'm' ? 22 : c == 'n' ? 23 : c == 'o' ? 24 : c == 'p' ? 25
-              : c == 'q' ? 26 : c == 'r' ? 27 : c == 's' ? 28 : c == 't' ? 29
-              : c == 'u' ? 30 : c == 'v' ? 31 : c == 'w' ? 32 : c == 'x' ? 33
-              : c == 'y' ? 34 : c == 'z' ? 35 : 0xff);
-    // clang-format on
-    if (src[i] == 0xff) {
-      return -1; // invalid digit
-    }
-  }
-  if (str[25] != 0) {
-    return -1; // invalid length
+static inline int scru128_x86_simd_level(void) {
+  if (__builtin_cpu_supports("avx512bw")) {
+    return 3;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return 2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    return 1;
+  } else {
+    return 0;
   }
+}
 
-  for (int_fast8_t i = 0; i < SCRU128_LEN; i++) {
-    id_out[i] = 0;
-  }
+/**
+ * The divisor of the vectorized Base36 encoder.
+ *
+ * The encoder takes the eight 3-digit groups of an ID from right to left by
+ * dividing its four 32-bit limbs by 36^3 eight times, and it does so on doubles
+ * because SIMD instruction sets lack 64-bit integer division. Every operand is
+ * an integer or half-integer below 2^48 and thus exact. A quotient is obtained
+ * by rounding `(cur + 0.5) / 36^3 - 0.5` to the nearest integer through the
+ * addition of 1.5 * 2^52; the fractional part of `(cur + 0.5) / 36^3` is never
+ * within 2^-17 of an integer, while the rounding error is below 2^-20. To save
+ * instructions, the remainder `rem` is kept as `rem + 0.5 - 36^3 / 2` and each
+ * limb `x` as `x + (36^3 / 2 - 0.5) * (2^32 - 1)`, so that `rem * 2^32 + x +
+ * 0.5 - 36^3 / 2` is a single multiply-add of the two.
+ *
+ * @private
+ */
+static const double SCRU128_ENC_DIVISOR = 46656.0; // 36^3
 
-  int_fast8_t min_index = 99; // any number greater than size of output array
-  for (int_fast8_t i = -5; i < 25; i += 10) {
-    // implement Base36 using 10-digit words
-    uint64_t carry = 0;
-    for (int_fast8_t j = i < 0 ? 0 : i; j < i + 10; j++) {
-      carry = (carry * 36) + src[j];
-    }
+/** @private */
+static const double SCRU128_ENC_INVERSE = 1.0 / 46656.0;
 
-    // iterate over output array from right to left while carry != 0 but at
-    // least up to place already filled
-    int_fast8_t j = 15;
-    for (; carry > 0 || j > min_index; j--) {
-      if (j < 0) {
-        return -1; // out of 128-bit value range
-      }
-      carry += (uint64_t)id_out[j] * 3656158440062976; // 36^10
-      id_out[j] = (uint8_t)carry;
-      carry = carry >> 8;
-    }
-    min_index = j;
-  }
-  return 0;
-}
+/** @private */
+static const double SCRU128_ENC_ROUNDER = 6755399441055744.0; // 1.5 * 2^52
+
+/** @private */
+static const double SCRU128_ENC_RADIX = 4294967296.0; // 2^32
+
+/** @private */
+static const double SCRU128_ENC_LIMB_BIAS = 100190849574112.5;
+
+/** @private */
+static const double SCRU128_ENC_REM_BIAS = -23327.5;
 
 /**
- * Returns the 48-bit `timestamp` field value of a SCRU128 ID.
+ * `pshufb` masks that arrange the digits of eight 3-digit groups into 16 + 8
+ * characters: the first two spread the first and second digits (packed as the
+ * low and high bytes of 16-bit lanes) and the third digits (the low bytes of
+ * 16-bit lanes) into the first 16 characters, and the last two do the same for
+ * the remaining 8 characters.
  *
- * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @private
  */
-static inline uint64_t scru128_timestamp(const uint8_t *id) {
-  return (uint64_t)id[0] << 40 | (uint64_t)id[1] << 32 | (uint64_t)id[2] << 24 |
-         (uint64_t)id[3] << 16 | (uint64_t)id[4] << 8 | (uint64_t)id[5];
-}
+static const int8_t SCRU128_ENC_SHUFFLE[4][16] = {
+    {0, 1, -128, 2, 3, -128, 4, 5, -128, 6, 7, -128, 8, 9, -128, 10},
+    {-128, -128, 0, -128, -128, 2, -128, -128, 4, -128, -128, 6, -128, -128, 8,
+     -128},
+    {11, -128, 12, 13, -128, 14, 15, -128, -128, -128, -128, -128, -128, -128,
+     -128, -128},
+    {-128, 10, -128, -128, 12, -128, -128, 14, -128, -128, -128, -128, -128,
+     -128, -128, -128},
+};
 
 /**
- * Returns the 24-bit `counter_hi` field value of a SCRU128 ID.
+ * `vpermt2w` indices that transpose the eight 3-digit groups of eight IDs, each
+ * group held as eight 16-bit lanes (one per ID), into the groups of the first
+ * and last four IDs.
  *
- * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @private
  */
-static inline uint32_t scru128_counter_hi(const uint8_t *id) {
-  return (uint32_t)id[6] << 16 | (uint32_t)id[7] << 8 | (uint32_t)id[8];
+static const uint16_t SCRU128_ENC_TRANSPOSE[2][32] = {
+    {0, 8,  16, 24, 32, 40, 48, 56, 1, 9,  17, 25, 33, 41, 49, 57,
+     2, 10, 18, 26, 34, 42, 50, 58, 3, 11, 19, 27, 35, 43, 51, 59},
+    {4, 12, 20, 28, 36, 44, 52, 60, 5, 13, 21, 29, 37, 45, 53, 61,
+     6, 14, 22, 30, 38, 46, 54, 62, 7, 15, 23, 31, 39, 47, 55, 63},
+};
+
+/**
+ * Stores a 25-digit string representation given the leading digit and the
+ * following 16 + 8 characters.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline void
+scru128_store_str_sse41(__m128i lo, __m128i hi, int lead, char *str_out) {
+  str_out[0] = (char)(lead < 10 ? '0' + lead : 'a' - 10 + lead);
+  _mm_storeu_si128((__m128i *)(str_out + 1), lo);
+  _mm_storel_epi64((__m128i *)(str_out + 17), hi);
+  str_out[25] = 0;
 }
 
 /**
- * Returns the 24-bit `counter_lo` field value of a SCRU128 ID.
+ * Stores the 25-digit string representation of an ID given the leading digit
+ * and the following eight 3-digit groups as 16-bit lanes.
  *
- * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @private
  */
-static inline uint32_t scru128_counter_lo(const uint8_t *id) {
-  return (uint32_t)id[9] << 16 | (uint32_t)id[10] << 8 | (uint32_t)id[11];
+__attribute__((target("sse4.1"))) static inline void
+scru128_store_groups_sse41(__m128i groups, int lead, char *str_out) {
+  // split each group into three digits with multiply-high instructions
+  __m128i x = _mm_mulhi_epu16(_mm_srli_epi16(groups, 2), _mm_set1_epi16(7282));
+  __m128i d2 = _mm_sub_epi16(groups, _mm_mullo_epi16(x, _mm_set1_epi16(36)));
+  __m128i d0 = _mm_mulhi_epu16(x, _mm_set1_epi16(1821));
+  __m128i d1 = _mm_sub_epi16(x, _mm_mullo_epi16(d0, _mm_set1_epi16(36)));
+  __m128i d01 = _mm_or_si128(d0, _mm_slli_epi16(d1, 8));
+
+  const __m128i *shuffle = (const __m128i *)SCRU128_ENC_SHUFFLE;
+  __m128i lo = _mm_or_si128(_mm_shuffle_epi8(d01, _mm_loadu_si128(shuffle)),
+                            _mm_shuffle_epi8(d2, _mm_loadu_si128(shuffle + 1)));
+  __m128i hi = _mm_or_si128(_mm_shuffle_epi8(d01, _mm_loadu_si128(shuffle + 2)),
+                            _mm_shuffle_epi8(d2, _mm_loadu_si128(shuffle + 3)));
+
+  // map digits to `[0-9a-z]`
+  const __m128i nine = _mm_set1_epi8(9), zero = _mm_set1_epi8('0');
+  const __m128i gap = _mm_set1_epi8('a' - '0' - 10);
+  lo = _mm_add_epi8(_mm_add_epi8(lo, zero),
+                    _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gap));
+  hi = _mm_add_epi8(_mm_add_epi8(hi, zero),
+                    _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gap));
+
+  scru128_store_str_sse41(lo, hi, lead, str_out);
 }
 
 /**
- * Returns the 32-bit `entropy` field value of a SCRU128 ID.
+ * Transposes the eight 3-digit groups of four IDs, each group held as four
+ * 32-bit lanes (one per ID), into four vectors each holding the groups of an
+ * ID as 16-bit lanes.
  *
- * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @private
  */
-static inline uint32_t scru128_entropy(const uint8_t *id) {
-  return (uint32_t)id[12] << 24 | (uint32_t)id[13] << 16 |
-         (uint32_t)id[14] << 8 | (uint32_t)id[15];
+__attribute__((target("sse4.1"))) static inline void
+scru128_transpose_groups_sse41(const __m128i *groups, __m128i *ids_out) {
+  __m128i p01 = _mm_packus_epi32(groups[0], groups[1]);
+  __m128i p23 = _mm_packus_epi32(groups[2], groups[3]);
+  __m128i p45 = _mm_packus_epi32(groups[4], groups[5]);
+  __m128i p67 = _mm_packus_epi32(groups[6], groups[7]);
+  __m128i a = _mm_unpacklo_epi16(p01, p23), b = _mm_unpackhi_epi16(p01, p23);
+  __m128i c = _mm_unpacklo_epi16(p45, p67), d = _mm_unpackhi_epi16(p45, p67);
+  __m128i ab0 = _mm_unpacklo_epi16(a, b), ab1 = _mm_unpackhi_epi16(a, b);
+  __m128i cd0 = _mm_unpacklo_epi16(c, d), cd1 = _mm_unpackhi_epi16(c, d);
+  ids_out[0] = _mm_unpacklo_epi64(ab0, cd0);
+  ids_out[1] = _mm_unpackhi_epi64(ab0, cd0);
+  ids_out[2] = _mm_unpacklo_epi64(ab1, cd1);
+  ids_out[3] = _mm_unpackhi_epi64(ab1, cd1);
 }
 
 /**
- * Returns the 25-digit canonical string representation of a SCRU128 ID.
+ * Divides the biased remainder `rem` and limb `limb` by 36^3, replacing `limb`
+ * with the biased quotient and returning the biased remainder.
  *
- * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
- * @param str_out A 26-byte character array where the returned string is stored.
- * The returned array is a 26-byte null-terminated string consisting of 25
- * `[0-9a-z]` characters and null.
+ * @private
  */
-static inline void scru128_to_str(const uint8_t *id, char *str_out) {
-  static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+__attribute__((target("sse4.1"))) static inline __m128d
+scru128_divide_step_sse41(__m128d rem, __m128d *limb) {
+  const __m128d rounder = _mm_set1_pd(SCRU128_ENC_ROUNDER);
+  __m128d cur =
+      _mm_add_pd(_mm_mul_pd(rem, _mm_set1_pd(SCRU128_ENC_RADIX)), *limb);
+  __m128d quo = _mm_sub_pd(
+      _mm_add_pd(_mm_mul_pd(cur, _mm_set1_pd(SCRU128_ENC_INVERSE)), rounder),
+      rounder);
+  *limb = _mm_add_pd(quo, _mm_set1_pd(SCRU128_ENC_LIMB_BIAS));
+  return _mm_sub_pd(cur, _mm_mul_pd(quo, _mm_set1_pd(SCRU128_ENC_DIVISOR)));
+}
 
-  // zero-fill 25 elements to use in process and 26th as NUL char
-  for (int_fast8_t i = 0; i < 26; i++) {
-    str_out[i] = 0;
+/**
+ * Divides the biased limbs of two pairs of IDs by 36^3, skipping the limbs
+ * before `start` that are known to be zero, and returns the remainders of the
+ * four IDs as 32-bit lanes.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline __m128i
+scru128_divide_sse41(__m128d (*limbs)[4], int start) {
+  // unrolled by hand so that the limbs stay in registers
+  __m128d rem0 = _mm_set1_pd(SCRU128_ENC_REM_BIAS), rem1 = rem0;
+  switch (start) {
+  case 0:
+    rem0 = scru128_divide_step_sse41(rem0, &limbs[0][0]);
+    rem1 = scru128_divide_step_sse41(rem1, &limbs[1][0]);
+    /* fall through */
+  case 1:
+    rem0 = scru128_divide_step_sse41(rem0, &limbs[0][1]);
+    rem1 = scru128_divide_step_sse41(rem1, &limbs[1][1]);
+    /* fall through */
+  case 2:
+    rem0 = scru128_divide_step_sse41(rem0, &limbs[0][2]);
+    rem1 = scru128_divide_step_sse41(rem1, &limbs[1][2]);
+    /* fall through */
+  default:
+    rem0 = scru128_divide_step_sse41(rem0, &limbs[0][3]);
+    rem1 = scru128_divide_step_sse41(rem1, &limbs[1][3]);
   }
 
-  int_fast8_t min_index = 99; // any number greater than size of output array
-  for (int_fast8_t i = -5; i < SCRU128_LEN; i += 7) {
-    // implement Base36 using 56-bit words
-    uint64_t carry = 0;
-    for (int_fast8_t j = i < 0 ? 0 : i; j < i + 7; j++) {
-      carry = (carry << 8) | id[j];
-    }
+  const __m128d offset = _mm_set1_pd(-SCRU128_ENC_REM_BIAS + 0.5);
+  return _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_add_pd(rem0, offset)),
+                            _mm_cvttpd_epi32(_mm_add_pd(rem1, offset)));
+}
 
-    // iterate over output array from right to left while carry != 0 but at
-    // least up to place already filled
-    int_fast8_t j = 24;
-    for (; carry > 0 || j > min_index; j--) {
-      carry += (uint64_t)str_out[j] << 56;
-      str_out[j] = carry % 36;
-      carry = carry / 36;
-    }
-    min_index = j;
+/**
+ * Encodes four consecutive IDs with SSE4.1.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline void
+scru128_to_str_x4_sse41(const uint8_t *ids, char *strs_out) {
+  const __m128i bswap =
+      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const __m128i sign = _mm_set1_epi32(-0x7fffffff - 1);
+  const __m128d limb_bias = _mm_set1_pd(SCRU128_ENC_LIMB_BIAS);
+  const __m128d signed_bias = _mm_set1_pd(SCRU128_ENC_LIMB_BIAS + 2147483648.0);
+
+  // load big-endian 32-bit limbs as biased doubles, two IDs per vector
+  __m128d limbs[2][4];
+  for (int_fast8_t v = 0; v < 2; v++) {
+    const __m128i *src = (const __m128i *)(ids + 2 * SCRU128_LEN * v);
+    __m128i x = _mm_shuffle_epi8(_mm_loadu_si128(src), bswap);
+    __m128i y = _mm_shuffle_epi8(_mm_loadu_si128(src + 1), bswap);
+    __m128i lo = _mm_xor_si128(_mm_unpacklo_epi32(x, y), sign);
+    __m128i hi = _mm_xor_si128(_mm_unpackhi_epi32(x, y), sign);
+    limbs[v][0] = _mm_add_pd(_mm_cvtepi32_pd(lo), signed_bias);
+    limbs[v][1] =
+        _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(lo, 8)), signed_bias);
+    limbs[v][2] = _mm_add_pd(_mm_cvtepi32_pd(hi), signed_bias);
+    limbs[v][3] =
+        _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(hi, 8)), signed_bias);
   }
 
-  for (int_fast8_t i = 0; i < 25; i++) {
-    str_out[i] = DIGITS[(unsigned char)str_out[i]];
+  // the upper limbs become zero as the division goes on, leaving the leading
+  // digit in the last limb
+  __m128i groups[8], per_id[4];
+  groups[7] = scru128_divide_sse41(limbs, 0);
+  groups[6] = scru128_divide_sse41(limbs, 0);
+  groups[5] = scru128_divide_sse41(limbs, 0);
+  groups[4] = scru128_divide_sse41(limbs, 1);
+  groups[3] = scru128_divide_sse41(limbs, 1);
+  groups[2] = scru128_divide_sse41(limbs, 2);
+  groups[1] = scru128_divide_sse41(limbs, 2);
+  groups[0] = scru128_divide_sse41(limbs, 3);
+  scru128_transpose_groups_sse41(groups, per_id);
+
+  int lead[4];
+  _mm_storeu_si128(
+      (__m128i *)lead,
+      _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_sub_pd(limbs[0][3], limb_bias)),
+                         _mm_cvttpd_epi32(_mm_sub_pd(limbs[1][3], limb_bias))));
+  for (int_fast8_t i = 0; i < 4; i++) {
+    scru128_store_groups_sse41(per_id[i], lead[i],
+                               strs_out + SCRU128_STR_LEN * i);
   }
 }
 
 /**
- * Returns a negative integer, zero, or positive integer if `id_lft` is less
- * than, equal to, or greater than `id_rgt`, respectively.
+ * Encodes as many leading IDs as possible in units of four with SSE4.1 and
+ * returns the number of encoded IDs.
  *
- * @param id_lft A 16-byte big-endian byte array that represents a SCRU128 ID.
- * @param id_rgt A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @private
  */
-static inline int scru128_compare(const uint8_t *id_lft,
-                                  const uint8_t *id_rgt) {
-  for (int_fast8_t i = 0; i < SCRU128_LEN; i++) {
-    if (id_lft[i] != id_rgt[i]) {
-      return id_lft[i] < id_rgt[i] ? -1 : 1;
-    }
+__attribute__((target("sse4.1"))) static inline size_t
+scru128_to_str_batch_sse41(const uint8_t *ids, size_t n, char *strs_out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    scru128_to_str_x4_sse41(ids + SCRU128_LEN * i,
+                            strs_out + SCRU128_STR_LEN * i);
   }
-  return 0;
+  return i;
 }
 
-/** @} */
-
 /**
- * @name Generator-related functions
+ * Stores the 25-digit string representations of two IDs, each given as the
+ * eight 3-digit groups in a 128-bit lane, in the same way as
+ * `scru128_store_groups_sse41()`.
  *
- * @{
+ * @private
  */
+__attribute__((target("avx2,fma"))) static inline void
+scru128_store_groups_avx2(__m256i groups, const int *lead, char *strs_out) {
+  __m256i x =
+      _mm256_mulhi_epu16(_mm256_srli_epi16(groups, 2), _mm256_set1_epi16(7282));
+  __m256i d2 =
+      _mm256_sub_epi16(groups, _mm256_mullo_epi16(x, _mm256_set1_epi16(36)));
+  __m256i d0 = _mm256_mulhi_epu16(x, _mm256_set1_epi16(1821));
+  __m256i d1 =
+      _mm256_sub_epi16(x, _mm256_mullo_epi16(d0, _mm256_set1_epi16(36)));
+  __m256i d01 = _mm256_or_si256(d0, _mm256_slli_epi16(d1, 8));
 
-/** Initializes a generator struct `g`. */
-static inline void scru128_generator_init(Scru128Generator *g) {
-  g->_timestamp = 0;
-  g->_counter_hi = 0;
-  g->_counter_lo = 0;
-  g->_ts_counter_hi = 0;
+  const __m128i *shuffle = (const __m128i *)SCRU128_ENC_SHUFFLE;
+  __m256i lo = _mm256_or_si256(
+      _mm256_shuffle_epi8(
+          d01, _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle))),
+      _mm256_shuffle_epi8(
+          d2, _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle + 1))));
+  __m256i hi = _mm256_or_si256(
+      _mm256_shuffle_epi8(
+          d01, _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle + 2))),
+      _mm256_shuffle_epi8(
+          d2, _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle + 3))));
+
+  const __m256i nine = _mm256_set1_epi8(9), zero = _mm256_set1_epi8('0');
+  const __m256i gap = _mm256_set1_epi8('a' - '0' - 10);
+  lo = _mm256_add_epi8(_mm256_add_epi8(lo, zero),
+                       _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), gap));
+  hi = _mm256_add_epi8(_mm256_add_epi8(hi, zero),
+                       _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), gap));
+
+  scru128_store_str_sse41(_mm256_castsi256_si128(lo),
+                          _mm256_castsi256_si128(hi), lead[0], strs_out);
+  scru128_store_str_sse41(_mm256_extracti128_si256(lo, 1),
+                          _mm256_extracti128_si256(hi, 1), lead[1],
+                          strs_out + SCRU128_STR_LEN);
 }
 
 /**
- * Generates a new SCRU128 ID with the given `timestamp` and random number
- * generator, or returns an error upon significant timestamp rollback.
+ * Performs a step of `scru128_divide_step_sse41()` on four IDs with FMA.
  *
- * This function returns a monotonically increasing ID by reusing the previous
- * `timestamp` even if the one provided is smaller than the immediately
- * preceding ID's. However, when such a clock rollback is considered significant
- * (by more than `rollback_allowance` milliseconds), this function aborts and
- * returns `SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT` immediately.
+ * @private
+ */
+__attribute__((target("avx2,fma"))) static inline __m256d
+scru128_divide_step_avx2(__m256d rem, __m256d *limb) {
+  const __m256d rounder = _mm256_set1_pd(SCRU128_ENC_ROUNDER);
+  __m256d cur = _mm256_fmadd_pd(rem, _mm256_set1_pd(SCRU128_ENC_RADIX), *limb);
+  __m256d quo = _mm256_sub_pd(
+      _mm256_fmadd_pd(cur, _mm256_set1_pd(SCRU128_ENC_INVERSE), rounder),
+      rounder);
+  *limb = _mm256_add_pd(quo, _mm256_set1_pd(SCRU128_ENC_LIMB_BIAS));
+  return _mm256_fnmadd_pd(quo, _mm256_set1_pd(SCRU128_ENC_DIVISOR), cur);
+}
+
+/**
+ * Divides the biased limbs of two quadruples of IDs by 36^3 in the same way as
+ * `scru128_divide_sse41()`, storing the remainders in `groups[0]` and
+ * `groups[8]`.
  *
- * See `scru128_generate_or_reset_core()` for the other mode of generation.
+ * @private
+ */
+__attribute__((target("avx2,fma"))) static inline void
+scru128_divide_avx2(__m256d (*limbs)[4], int start, __m128i *groups) {
+  __m256d rem0 = _mm256_set1_pd(SCRU128_ENC_REM_BIAS), rem1 = rem0;
+  switch (start) {
+  case 0:
+    rem0 = scru128_divide_step_avx2(rem0, &limbs[0][0]);
+    rem1 = scru128_divide_step_avx2(rem1, &limbs[1][0]);
+    /* fall through */
+  case 1:
+    rem0 = scru128_divide_step_avx2(rem0, &limbs[0][1]);
+    rem1 = scru128_divide_step_avx2(rem1, &limbs[1][1]);
+    /* fall through */
+  case 2:
+    rem0 = scru128_divide_step_avx2(rem0, &limbs[0][2]);
+    rem1 = scru128_divide_step_avx2(rem1, &limbs[1][2]);
+    /* fall through */
+  default:
+    rem0 = scru128_divide_step_avx2(rem0, &limbs[0][3]);
+    rem1 = scru128_divide_step_avx2(rem1, &limbs[1][3]);
+  }
+
+  const __m256d offset = _mm256_set1_pd(-SCRU128_ENC_REM_BIAS + 0.5);
+  groups[0] = _mm256_cvttpd_epi32(_mm256_add_pd(rem0, offset));
+  groups[8] = _mm256_cvttpd_epi32(_mm256_add_pd(rem1, offset));
+}
+
+/**
+ * Encodes eight consecutive IDs with AVX2 and FMA.
  *
- * @param g A generator state object used to generate an ID.
- * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
- * @param timestamp A 48-bit `timestamp` field value.
- * @param arc4random A function pointer to `arc4random()` or a compatible
- * function that returns a (cryptographically strong) random number in the range
- * of 32-bit unsigned integer.
- * @param rollback_allowance The amount of `timestamp` rollback that is
- * considered significant. A suggested value is `10000` (milliseconds).
- * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
- * characteristics of generated ID. A negative return code reports an error.
- * @attention This function is NOT thread-safe. The generator `g` should be
- * protected from concurrent accesses using a mutex or other synchronization
- * mechanism to avoid race conditions.
+ * @private
  */
-static inline int8_t
-scru128_generate_or_abort_core(Scru128Generator *g, uint8_t *id_out,
-                               uint64_t timestamp, uint32_t (*arc4random)(void),
-                               uint64_t rollback_allowance) {
-  if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
-    return SCRU128_GENERATOR_STATUS_ERROR;
-  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
-    return SCRU128_GENERATOR_STATUS_ERROR;
+__attribute__((target("avx2,fma"))) static inline void
+scru128_to_str_x8_avx2(const uint8_t *ids, char *strs_out) {
+  const __m256i bswap = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+  const __m256i sign = _mm256_set1_epi32(-0x7fffffff - 1);
+  const __m256i spread = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  const __m256d limb_bias = _mm256_set1_pd(SCRU128_ENC_LIMB_BIAS);
+  const __m256d signed_bias =
+      _mm256_set1_pd(SCRU128_ENC_LIMB_BIAS + 2147483648.0);
+
+  // load big-endian 32-bit limbs as biased doubles, four IDs per vector
+  __m256d limbs[2][4];
+  for (int_fast8_t v = 0; v < 2; v++) {
+    const __m256i *src = (const __m256i *)(ids + 4 * SCRU128_LEN * v);
+    __m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256(src), bswap);
+    __m256i y = _mm256_shuffle_epi8(_mm256_loadu_si256(src + 1), bswap);
+    __m256i lo = _mm256_permutevar8x32_epi32(
+        _mm256_xor_si256(_mm256_unpacklo_epi32(x, y), sign), spread);
+    __m256i hi = _mm256_permutevar8x32_epi32(
+        _mm256_xor_si256(_mm256_unpackhi_epi32(x, y), sign), spread);
+    limbs[v][0] = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm256_castsi256_si128(lo)), signed_bias);
+    limbs[v][1] = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm256_extracti128_si256(lo, 1)), signed_bias);
+    limbs[v][2] = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm256_castsi256_si128(hi)), signed_bias);
+    limbs[v][3] = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm256_extracti128_si256(hi, 1)), signed_bias);
   }
 
-  int8_t status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+  __m128i groups[16], per_id[4];
+  scru128_divide_avx2(limbs, 0, groups + 7);
+  scru128_divide_avx2(limbs, 0, groups + 6);
+  scru128_divide_avx2(limbs, 0, groups + 5);
+  scru128_divide_avx2(limbs, 1, groups + 4);
+  scru128_divide_avx2(limbs, 1, groups + 3);
+  scru128_divide_avx2(limbs, 2, groups + 2);
+  scru128_divide_avx2(limbs, 2, groups + 1);
+  scru128_divide_avx2(limbs, 3, groups + 0);
+  for (int_fast8_t v = 0; v < 2; v++) {
+    int lead[4];
+    _mm_storeu_si128((__m128i *)lead, _mm256_cvttpd_epi32(_mm256_sub_pd(
+                                          limbs[v][3], limb_bias)));
+    char *dst = strs_out + SCRU128_STR_LEN * 4 * v;
+    scru128_transpose_groups_sse41(groups + 8 * v, per_id);
+    scru128_store_groups_avx2(_mm256_setr_m128i(per_id[0], per_id[1]), lead,
+                              dst);
+    scru128_store_groups_avx2(_mm256_setr_m128i(per_id[2], per_id[3]),
+                              lead + 2, dst + SCRU128_STR_LEN * 2);
+  }
+}
+
+/**
+ * Encodes as many leading IDs as possible in units of eight with AVX2 and FMA
+ * and returns the number of encoded IDs.
+ *
+ * @private
+ */
+__attribute__((target("avx2,fma"))) static inline size_t
+scru128_to_str_batch_avx2(const uint8_t *ids, size_t n, char *strs_out) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    scru128_to_str_x8_avx2(ids + SCRU128_LEN * i,
+                           strs_out + SCRU128_STR_LEN * i);
+  }
+  return i;
+}
+
+/**
+ * Stores the 25-digit string representations of four IDs, each given as the
+ * eight 3-digit groups in a 128-bit lane, in the same way as
+ * `scru128_store_groups_sse41()`.
+ *
+ * @private
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline void
+scru128_store_groups_avx512(__m512i groups, const int *lead, char *strs_out) {
+  __m512i x =
+      _mm512_mulhi_epu16(_mm512_srli_epi16(groups, 2), _mm512_set1_epi16(7282));
+  __m512i d2 =
+      _mm512_sub_epi16(groups, _mm512_mullo_epi16(x, _mm512_set1_epi16(36)));
+  __m512i d0 = _mm512_mulhi_epu16(x, _mm512_set1_epi16(1821));
+  __m512i d1 =
+      _mm512_sub_epi16(x, _mm512_mullo_epi16(d0, _mm512_set1_epi16(36)));
+  __m512i d01 = _mm512_or_si512(d0, _mm512_slli_epi16(d1, 8));
+
+  // the masked forms of some intrinsics are used throughout because the
+  // unmasked ones trigger false `-Wuninitialized` warnings in GCC 12
+  __m512i shuffle[4];
+  for (int_fast8_t k = 0; k < 4; k++) {
+    shuffle[k] = _mm512_maskz_broadcast_i32x4(
+        -1, _mm_loadu_si128((const __m128i *)SCRU128_ENC_SHUFFLE[k]));
+  }
+  __m512i lo = _mm512_or_si512(_mm512_shuffle_epi8(d01, shuffle[0]),
+                               _mm512_shuffle_epi8(d2, shuffle[1]));
+  __m512i hi = _mm512_or_si512(_mm512_shuffle_epi8(d01, shuffle[2]),
+                               _mm512_shuffle_epi8(d2, shuffle[3]));
+
+  const __m512i nine = _mm512_set1_epi8(9), zero = _mm512_set1_epi8('0');
+  const __m512i gap = _mm512_set1_epi8('a' - '0' - 10);
+  __mmask64 lo_alpha = _mm512_cmpgt_epi8_mask(lo, nine);
+  __mmask64 hi_alpha = _mm512_cmpgt_epi8_mask(hi, nine);
+  lo = _mm512_add_epi8(lo, zero);
+  hi = _mm512_add_epi8(hi, zero);
+  lo = _mm512_mask_add_epi8(lo, lo_alpha, lo, gap);
+  hi = _mm512_mask_add_epi8(hi, hi_alpha, hi, gap);
+
+  scru128_store_str_sse41(_mm512_maskz_extracti32x4_epi32(-1, lo, 0),
+                          _mm512_maskz_extracti32x4_epi32(-1, hi, 0), lead[0],
+                          strs_out);
+  scru128_store_str_sse41(_mm512_maskz_extracti32x4_epi32(-1, lo, 1),
+                          _mm512_maskz_extracti32x4_epi32(-1, hi, 1), lead[1],
+                          strs_out + SCRU128_STR_LEN);
+  scru128_store_str_sse41(_mm512_maskz_extracti32x4_epi32(-1, lo, 2),
+                          _mm512_maskz_extracti32x4_epi32(-1, hi, 2), lead[2],
+                          strs_out + SCRU128_STR_LEN * 2);
+  scru128_store_str_sse41(_mm512_maskz_extracti32x4_epi32(-1, lo, 3),
+                          _mm512_maskz_extracti32x4_epi32(-1, hi, 3), lead[3],
+                          strs_out + SCRU128_STR_LEN * 3);
+}
+
+/**
+ * Performs a step of `scru128_divide_step_sse41()` on eight IDs.
+ *
+ * @private
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline __m512d
+scru128_divide_step_avx512(__m512d rem, __m512d *limb) {
+  const __m512d rounder = _mm512_set1_pd(SCRU128_ENC_ROUNDER);
+  __m512d cur = _mm512_fmadd_pd(rem, _mm512_set1_pd(SCRU128_ENC_RADIX), *limb);
+  __m512d quo = _mm512_sub_pd(
+      _mm512_fmadd_pd(cur, _mm512_set1_pd(SCRU128_ENC_INVERSE), rounder),
+      rounder);
+  *limb = _mm512_add_pd(quo, _mm512_set1_pd(SCRU128_ENC_LIMB_BIAS));
+  return _mm512_fnmadd_pd(quo, _mm512_set1_pd(SCRU128_ENC_DIVISOR), cur);
+}
+
+/**
+ * Divides the biased limbs of two octuples of IDs by 36^3 in the same way as
+ * `scru128_divide_sse41()`, storing the remainders in `groups[0]` and
+ * `groups[8]`.
+ *
+ * @private
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline void
+scru128_divide_avx512(__m512d (*limbs)[4], int start, __m256i *groups) {
+  __m512d rem0 = _mm512_set1_pd(SCRU128_ENC_REM_BIAS), rem1 = rem0;
+  switch (start) {
+  case 0:
+    rem0 = scru128_divide_step_avx512(rem0, &limbs[0][0]);
+    rem1 = scru128_divide_step_avx512(rem1, &limbs[1][0]);
+    /* fall through */
+  case 1:
+    rem0 = scru128_divide_step_avx512(rem0, &limbs[0][1]);
+    rem1 = scru128_divide_step_avx512(rem1, &limbs[1][1]);
+    /* fall through */
+  case 2:
+    rem0 = scru128_divide_step_avx512(rem0, &limbs[0][2]);
+    rem1 = scru128_divide_step_avx512(rem1, &limbs[1][2]);
+    /* fall through */
+  default:
+    rem0 = scru128_divide_step_avx512(rem0, &limbs[0][3]);
+    rem1 = scru128_divide_step_avx512(rem1, &limbs[1][3]);
+  }
+
+  const __m512d offset = _mm512_set1_pd(-SCRU128_ENC_REM_BIAS + 0.5);
+  groups[0] = _mm512_maskz_cvttpd_epi32(-1, _mm512_add_pd(rem0, offset));
+  groups[8] = _mm512_maskz_cvttpd_epi32(-1, _mm512_add_pd(rem1, offset));
+}
+
+/**
+ * Encodes sixteen consecutive IDs with AVX-512BW.
+ *
+ * @private
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline void
+scru128_to_str_x16_avx512(const uint8_t *ids, char *strs_out) {
+  const __m512i bswap = _mm512_maskz_broadcast_i32x4(-1, 
+      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+  const __m512i gather =
+      _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m512d limb_bias = _mm512_set1_pd(SCRU128_ENC_LIMB_BIAS);
+
+  // load big-endian 32-bit limbs as biased doubles, eight IDs per vector
+  __m512d limbs[2][4];
+  for (int_fast8_t v = 0; v < 2; v++) {
+    const uint8_t *src = ids + 8 * SCRU128_LEN * v;
+    __m512i x = _mm512_shuffle_epi8(_mm512_loadu_si512(src), bswap);
+    __m512i y = _mm512_shuffle_epi8(_mm512_loadu_si512(src + 64), bswap);
+    for (int_fast8_t j = 0; j < 4; j++) {
+      __m512i limb = _mm512_permutex2var_epi32(
+          x, _mm512_add_epi32(gather, _mm512_set1_epi32(j)), y);
+      __m256i lo = _mm512_maskz_extracti64x4_epi64(-1, limb, 0);
+      limbs[v][j] = _mm512_add_pd(_mm512_maskz_cvtepu32_pd(-1, lo), limb_bias);
+    }
+  }
+
+  __m256i groups[16];
+  scru128_divide_avx512(limbs, 0, groups + 7);
+  scru128_divide_avx512(limbs, 0, groups + 6);
+  scru128_divide_avx512(limbs, 0, groups + 5);
+  scru128_divide_avx512(limbs, 1, groups + 4);
+  scru128_divide_avx512(limbs, 1, groups + 3);
+  scru128_divide_avx512(limbs, 2, groups + 2);
+  scru128_divide_avx512(limbs, 2, groups + 1);
+  scru128_divide_avx512(limbs, 3, groups + 0);
+
+  const __m512i transpose0 = _mm512_loadu_si512(SCRU128_ENC_TRANSPOSE[0]);
+  const __m512i transpose1 = _mm512_loadu_si512(SCRU128_ENC_TRANSPOSE[1]);
+  for (int_fast8_t v = 0; v < 2; v++) {
+    const __m256i *g = groups + 8 * v;
+    __m256i h[4];
+    for (int_fast8_t k = 0; k < 4; k++) {
+      h[k] = _mm512_maskz_cvtepi32_epi16(
+          -1, _mm512_maskz_inserti64x4(-1, _mm512_castsi256_si512(g[2 * k]),
+                                       g[2 * k + 1], 1));
+    }
+    __m512i a = _mm512_maskz_inserti64x4(-1, _mm512_castsi256_si512(h[0]),
+                                         h[1], 1);
+    __m512i b = _mm512_maskz_inserti64x4(-1, _mm512_castsi256_si512(h[2]),
+                                         h[3], 1);
+
+    int lead[8];
+    _mm256_storeu_si256(
+        (__m256i *)lead,
+        _mm512_maskz_cvttpd_epi32(-1, _mm512_sub_pd(limbs[v][3], limb_bias)));
+    char *dst = strs_out + SCRU128_STR_LEN * 8 * v;
+    scru128_store_groups_avx512(_mm512_permutex2var_epi16(a, transpose0, b),
+                                lead, dst);
+    scru128_store_groups_avx512(_mm512_permutex2var_epi16(a, transpose1, b),
+                                lead + 4, dst + SCRU128_STR_LEN * 4);
+  }
+}
+
+/**
+ * Encodes as many leading IDs as possible in units of sixteen with AVX-512BW
+ * and returns the number of encoded IDs.
+ *
+ * @private
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline size_t
+scru128_to_str_batch_avx512(const uint8_t *ids, size_t n, char *strs_out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    scru128_to_str_x16_avx512(ids + SCRU128_LEN * i,
+                              strs_out + SCRU128_STR_LEN * i);
+  }
+  return i;
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
+/**
+ * Decodes the first 25 characters of `src` as a 25-digit string representation
+ * and returns zero on success or a non-zero integer on failure. If
+ * `is_terminated` is non-zero, `src[25]` must also be null.
+ *
+ * @private
+ */
+static inline int scru128_from_digits(uint8_t *id_out, const char *src,
+                                      int is_terminated) {
+  static const uint64_t BASE_POW_6 = 2176782336; // 36^6
+
+  // implement Base36 using a leading digit and four 6-digit words accumulated
+  // into 32-bit limbs; invalid digits (0xff) are collected in `flags` and
+  // checked once at the end unless a null-terminated string may end early
+  uint8_t flags = SCRU128_DECODE_MAP[(unsigned char)src[0]];
+  if (is_terminated && flags == 0xff) {
+    return -1; // invalid digit or empty string
+  }
+  uint32_t limbs[4] = {0, 0, 0, flags};
+  for (int_fast8_t i = 1; i < 25; i += 6) {
+    uint32_t word = 0;
+    for (int_fast8_t j = i; j < i + 6; j++) {
+      uint8_t digit = SCRU128_DECODE_MAP[(unsigned char)src[j]];
+      if (is_terminated && digit == 0xff) {
+        return -1; // invalid digit or too short string
+      }
+      flags |= digit;
+      word = word * 36 + digit;
+    }
+
+    uint64_t carry = word;
+    for (int_fast8_t j = 3; j >= 0; j--) {
+      carry += limbs[j] * BASE_POW_6;
+      limbs[j] = (uint32_t)carry;
+      carry = carry >> 32;
+    }
+    if (carry > 0) {
+      return -1; // out of 128-bit value range
+    }
+  }
+  if (flags == 0xff) {
+    return -1; // invalid digit
+  }
+  if (is_terminated && src[25] != 0) {
+    return -1; // invalid length
+  }
+
+  for (int_fast8_t i = 0; i < 4; i++) {
+    id_out[4 * i] = (uint8_t)(limbs[i] >> 24);
+    id_out[4 * i + 1] = (uint8_t)(limbs[i] >> 16);
+    id_out[4 * i + 2] = (uint8_t)(limbs[i] >> 8);
+    id_out[4 * i + 3] = (uint8_t)limbs[i];
+  }
+  return 0;
+}
+
+#ifdef SCRU128_HAS_X86_SIMD
+/** @private */
+__extension__ typedef unsigned __int128 Scru128Uint128;
+
+/**
+ * `pshufb` masks that pick the first and last twelve of the 24 digits following
+ * the leading one from the vectors loaded at offsets 1 and 9, in groups of
+ * three digits padded to 32-bit lanes.
+ *
+ * @private
+ */
+static const int8_t SCRU128_DEC_SHUFFLE[2][16] = {
+    {0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128},
+    {4, 5, 6, -128, 7, 8, 9, -128, 10, 11, 12, -128, 13, 14, 15, -128},
+};
+
+/**
+ * Stores the SCRU128 ID that consists of the leading digit `lead` and two
+ * 12-digit words, or fills `id_out` with zeros if `is_valid` is zero or the
+ * value is out of the 128-bit range, and returns zero on success or one on
+ * failure.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline int
+scru128_store_words_sse41(uint8_t *id_out, uint8_t lead, uint64_t word0,
+                          uint64_t word1, int is_valid) {
+  static const uint64_t BASE_POW_12 = 4738381338321616896; // 36^12
+
+  Scru128Uint128 head =
+      (lead & 15) * ((Scru128Uint128)BASE_POW_12 * BASE_POW_12);
+  Scru128Uint128 value = (Scru128Uint128)word0 * BASE_POW_12 + word1 + head;
+
+  // clear the value without branches, which invalid records would mispredict
+  int is_invalid = !is_valid | (lead > 15) | (value < head);
+  uint64_t keep = (uint64_t)is_invalid - 1;
+  __m128i x = _mm_set_epi64x((int64_t)((uint64_t)(value >> 64) & keep),
+                             (int64_t)((uint64_t)value & keep));
+  _mm_storeu_si128((__m128i *)id_out,
+                   _mm_shuffle_epi8(x, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9,
+                                                     8, 7, 6, 5, 4, 3, 2, 1,
+                                                     0)));
+  return is_invalid;
+}
+
+/**
+ * Maps sixteen characters to Base36 digit values and combines the twelve
+ * selected by `shuffle` into a 12-digit word in the lower 64-bit lane, storing
+ * in `*mask_out` a bitmask that has a bit set for each character in
+ * `[0-9A-Za-z]`.
+ *
+ * Letters are folded to lower case only after digits are told apart because
+ * folding turns some other characters into digits.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline __m128i
+scru128_combine_digits_sse41(__m128i chars, __m128i shuffle, int *mask_out) {
+  __m128i num = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  __m128i alpha = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                               _mm_set1_epi8('a'));
+  __m128i is_num = _mm_cmpeq_epi8(_mm_min_epu8(num, _mm_set1_epi8(9)), num);
+  __m128i is_alpha =
+      _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(25)), alpha);
+  *mask_out = _mm_movemask_epi8(_mm_or_si128(is_num, is_alpha));
+  __m128i x = _mm_shuffle_epi8(
+      _mm_blendv_epi8(_mm_add_epi8(alpha, _mm_set1_epi8(10)), num, is_num),
+      shuffle);
+
+  // 3-digit groups (< 2^16), 6-digit words (< 2^32), and a 12-digit word
+  x = _mm_maddubs_epi16(x, _mm_set1_epi32(36 | 1 << 8 | 1 << 16));
+  x = _mm_madd_epi16(x, _mm_set1_epi32(36 | 1 << 16));
+  x = _mm_add_epi64(_mm_mul_epu32(x, _mm_set1_epi32(46656)), // 36^3
+                    _mm_srli_epi64(x, 32));
+  return _mm_add_epi64(
+      _mm_mul_epu32(x, _mm_set1_epi32((int32_t)2176782336)), // 36^6
+      _mm_srli_si128(x, 8));
+}
+
+/**
+ * Decodes the first 25 characters of `src` with SSE4.1 in the same way as
+ * `scru128_from_digits()` with `is_terminated` of zero, except that it fills
+ * `id_out` with zeros and returns one on failure.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline int
+scru128_from_digits_sse41(uint8_t *id_out, const char *src) {
+  // load the 24 digits after the leading one as two overlapping vectors
+  const __m128i *shuffle = (const __m128i *)SCRU128_DEC_SHUFFLE;
+  int mask0, mask1;
+  __m128i word0 = scru128_combine_digits_sse41(
+      _mm_loadu_si128((const __m128i *)(src + 1)), _mm_loadu_si128(shuffle),
+      &mask0);
+  __m128i word1 = scru128_combine_digits_sse41(
+      _mm_loadu_si128((const __m128i *)(src + 9)),
+      _mm_loadu_si128(shuffle + 1), &mask1);
+  return scru128_store_words_sse41(
+      id_out, SCRU128_DECODE_MAP[(unsigned char)src[0]],
+      (uint64_t)_mm_cvtsi128_si64(word0), (uint64_t)_mm_cvtsi128_si64(word1),
+      (mask0 & mask1) == 0xffff);
+}
+
+/**
+ * Decodes as many leading records as possible in units of eight with SSE4.1,
+ * adding the number of invalid records to `*n_errors`, and returns the number
+ * of decoded records.
+ *
+ * @private
+ */
+__attribute__((target("sse4.1"))) static inline size_t
+scru128_from_str_batch_sse41(uint8_t *ids_out, const char *src, size_t n,
+                             size_t stride, uint8_t *errors_out,
+                             size_t *n_errors) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned errors = 0;
+    for (int_fast8_t j = 0; j < 8; j++) {
+      int is_invalid = scru128_from_digits_sse41(
+          ids_out + SCRU128_LEN * (i + j), src + stride * (i + j));
+      *n_errors += (size_t)is_invalid;
+      errors |= (unsigned)is_invalid << j;
+    }
+    if (errors_out != NULL) {
+      errors_out[i / 8] = (uint8_t)errors;
+    }
+  }
+  return i;
+}
+
+/**
+ * Performs `scru128_combine_digits_sse41()` on two records, one per 128-bit
+ * lane, with AVX2.
+ *
+ * @private
+ */
+__attribute__((target("avx2"))) static inline __m256i
+scru128_combine_digits_avx2(__m256i chars, __m256i shuffle,
+                            uint32_t *mask_out) {
+  __m256i num = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+  __m256i alpha = _mm256_sub_epi8(
+      _mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  __m256i is_num =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(num, _mm256_set1_epi8(9)), num);
+  __m256i is_alpha =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(25)), alpha);
+  *mask_out = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_num, is_alpha));
+  __m256i x = _mm256_shuffle_epi8(
+      _mm256_blendv_epi8(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), num,
+                         is_num),
+      shuffle);
+
+  x = _mm256_maddubs_epi16(x, _mm256_set1_epi32(36 | 1 << 8 | 1 << 16));
+  x = _mm256_madd_epi16(x, _mm256_set1_epi32(36 | 1 << 16));
+  x = _mm256_add_epi64(_mm256_mul_epu32(x, _mm256_set1_epi32(46656)), // 36^3
+                       _mm256_srli_epi64(x, 32));
+  return _mm256_add_epi64(
+      _mm256_mul_epu32(x, _mm256_set1_epi32((int32_t)2176782336)), // 36^6
+      _mm256_srli_si256(x, 8));
+}
+
+/**
+ * Decodes the first 25 characters of two records `src` and `src + stride` with
+ * AVX2 in the same way as `scru128_from_digits_sse41()` and returns a bitmask
+ * that has a bit set for each invalid record.
+ *
+ * @private
+ */
+__attribute__((target("avx2"))) static inline unsigned
+scru128_from_digits_x2_avx2(uint8_t *ids_out, const char *src, size_t stride) {
+  const __m128i *shuffle = (const __m128i *)SCRU128_DEC_SHUFFLE;
+  uint32_t mask0, mask1;
+  __m256i word0 = scru128_combine_digits_avx2(
+      _mm256_setr_m128i(
+          _mm_loadu_si128((const __m128i *)(src + 1)),
+          _mm_loadu_si128((const __m128i *)(src + stride + 1))),
+      _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle)), &mask0);
+  __m256i word1 = scru128_combine_digits_avx2(
+      _mm256_setr_m128i(
+          _mm_loadu_si128((const __m128i *)(src + 9)),
+          _mm_loadu_si128((const __m128i *)(src + stride + 9))),
+      _mm256_broadcastsi128_si256(_mm_loadu_si128(shuffle + 1)), &mask1);
+
+  uint32_t mask = mask0 & mask1;
+  int err0 = scru128_store_words_sse41(
+      ids_out, SCRU128_DECODE_MAP[(unsigned char)src[0]],
+      (uint64_t)_mm256_extract_epi64(word0, 0),
+      (uint64_t)_mm256_extract_epi64(word1, 0), (mask & 0xffff) == 0xffff);
+  int err1 = scru128_store_words_sse41(
+      ids_out + SCRU128_LEN, SCRU128_DECODE_MAP[(unsigned char)src[stride]],
+      (uint64_t)_mm256_extract_epi64(word0, 2),
+      (uint64_t)_mm256_extract_epi64(word1, 2), mask >> 16 == 0xffff);
+  return (unsigned)err0 | (unsigned)err1 << 1;
+}
+
+/**
+ * Decodes as many leading records as possible in units of eight with AVX2 in
+ * the same way as `scru128_from_str_batch_sse41()`.
+ *
+ * @private
+ */
+__attribute__((target("avx2"))) static inline size_t
+scru128_from_str_batch_avx2(uint8_t *ids_out, const char *src, size_t n,
+                            size_t stride, uint8_t *errors_out,
+                            size_t *n_errors) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned errors = 0;
+    for (int_fast8_t j = 0; j < 8; j += 2) {
+      unsigned pair = scru128_from_digits_x2_avx2(
+          ids_out + SCRU128_LEN * (i + j), src + stride * (i + j), stride);
+      *n_errors += (pair & 1) + (pair >> 1);
+      errors |= pair << j;
+    }
+    if (errors_out != NULL) {
+      errors_out[i / 8] = (uint8_t)errors;
+    }
+  }
+  return i;
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
+/**
+ * Creates a SCRU128 ID from a 25-digit string representation.
+ *
+ * @param id_out A 16-byte byte array where the created SCRU128 ID is stored.
+ * @param str A null-terminated character array containing the 25-digit string
+ * representation.
+ * @return Zero on success or a non-zero integer if `str` is not a valid string
+ * representation.
+ */
+static inline int scru128_from_str(uint8_t *id_out, const char *str) {
+  return scru128_from_digits(id_out, str, 1);
+}
+
+/**
+ * Creates multiple SCRU128 IDs from fixed-width 25-digit string representations
+ * placed at regular intervals.
+ *
+ * Unlike `scru128_from_str()`, this function does not require each string
+ * representation to be terminated by null; it reads exactly 25 characters from
+ * each record and ignores the rest, so it can decode a column of IDs directly
+ * from a buffer of fixed-length lines or records. On x86-64, this function
+ * decodes eight records at a time with the SSE4.1 or AVX2 kernel if the CPU
+ * supports either.
+ *
+ * @param ids_out A `n * 16`-byte byte array where the created SCRU128 IDs are
+ * stored consecutively. The element for an invalid record is filled with
+ * zeros.
+ * @param src A character array containing `n` records, each of which begins
+ * with a 25-digit string representation.
+ * @param n The number of records to decode.
+ * @param stride The distance in bytes between the beginnings of consecutive
+ * records, which must be `25` or greater.
+ * @param errors_out A `(n + 7) / 8`-byte byte array where a bitmap is stored,
+ * in which the `i % 8`-th least significant bit of the `i / 8`-th byte is set
+ * if the `i`-th record is not a valid string representation. Can be `NULL` if
+ * not needed.
+ * @return The number of invalid records.
+ */
+static inline size_t scru128_from_str_batch(uint8_t *ids_out, const char *src,
+                                            size_t n, size_t stride,
+                                            uint8_t *errors_out) {
+  size_t i = 0, n_errors = 0;
+#ifdef SCRU128_HAS_X86_SIMD
+  switch (scru128_x86_simd_level()) {
+  case 3:
+  case 2:
+    i = scru128_from_str_batch_avx2(ids_out, src, n, stride, errors_out,
+                                    &n_errors);
+    break;
+  case 1:
+    i = scru128_from_str_batch_sse41(ids_out, src, n, stride, errors_out,
+                                     &n_errors);
+    break;
+  }
+#endif
+  for (; i < n; i++) {
+    uint8_t *id_out = ids_out + SCRU128_LEN * i;
+    int is_invalid = scru128_from_digits(id_out, src + stride * i, 0) != 0;
+    if (is_invalid) {
+      n_errors++;
+      for (int_fast8_t j = 0; j < SCRU128_LEN; j++) {
+        id_out[j] = 0;
+      }
+    }
+    if (errors_out != NULL) {
+      if (is_invalid) {
+        errors_out[i / 8] |= (uint8_t)(1 << i % 8);
+      } else {
+        errors_out[i / 8] &= (uint8_t) ~(1 << i % 8);
+      }
+    }
+  }
+  return n_errors;
+}
+
+/**
+ * Returns the 48-bit `timestamp` field value of a SCRU128 ID.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ */
+static inline uint64_t scru128_timestamp(const uint8_t *id) {
+  return (uint64_t)id[0] << 40 | (uint64_t)id[1] << 32 | (uint64_t)id[2] << 24 |
+         (uint64_t)id[3] << 16 | (uint64_t)id[4] << 8 | (uint64_t)id[5];
+}
+
+/**
+ * Returns the 24-bit `counter_hi` field value of a SCRU128 ID.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ */
+static inline uint32_t scru128_counter_hi(const uint8_t *id) {
+  return (uint32_t)id[6] << 16 | (uint32_t)id[7] << 8 | (uint32_t)id[8];
+}
+
+/**
+ * Returns the node or shard ID embedded in the upper bits of the `counter_hi`
+ * field value of a SCRU128 ID generated by a partitioned generator.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @param shard_bits The number of the upper bits of `counter_hi` reserved for
+ * the shard ID, which must be the value given to
+ * `scru128_generator_init_sharded()` and no greater than 24.
+ */
+static inline uint32_t scru128_shard(const uint8_t *id, uint32_t shard_bits) {
+  return scru128_counter_hi(id) >> (24 - shard_bits);
+}
+
+/**
+ * Returns the 24-bit `counter_lo` field value of a SCRU128 ID.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ */
+static inline uint32_t scru128_counter_lo(const uint8_t *id) {
+  return (uint32_t)id[9] << 16 | (uint32_t)id[10] << 8 | (uint32_t)id[11];
+}
+
+/**
+ * Returns the 32-bit `entropy` field value of a SCRU128 ID.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ */
+static inline uint32_t scru128_entropy(const uint8_t *id) {
+  return (uint32_t)id[12] << 24 | (uint32_t)id[13] << 16 |
+         (uint32_t)id[14] << 8 | (uint32_t)id[15];
+}
+
+/**
+ * Returns the 25-digit canonical string representation of a SCRU128 ID.
+ *
+ * @param id A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @param str_out A 26-byte character array where the returned string is stored.
+ * The returned array is a 26-byte null-terminated string consisting of 25
+ * `[0-9a-z]` characters and null.
+ */
+static inline void scru128_to_str(const uint8_t *id, char *str_out) {
+  static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  static const uint64_t BASE_POW_6 = 2176782336; // 36^6
+
+  uint32_t limbs[4];
+  for (int_fast8_t i = 0; i < 4; i++) {
+    limbs[i] = (uint32_t)id[4 * i] << 24 | (uint32_t)id[4 * i + 1] << 16 |
+               (uint32_t)id[4 * i + 2] << 8 | (uint32_t)id[4 * i + 3];
+  }
+
+  // implement Base36 by dividing 32-bit limbs by 36^6 to take 6-digit words
+  // from right to left, leaving the leading digit in the last limb
+  for (int_fast8_t i = 19; i > 0; i -= 6) {
+    uint64_t rem = 0;
+    for (int_fast8_t j = 0; j < 4; j++) {
+      uint64_t cur = rem << 32 | limbs[j];
+      limbs[j] = (uint32_t)(cur / BASE_POW_6);
+      rem = cur % BASE_POW_6;
+    }
+
+    uint32_t word = (uint32_t)rem;
+    for (int_fast8_t j = i + 5; j >= i; j--) {
+      str_out[j] = DIGITS[word % 36];
+      word /= 36;
+    }
+  }
+  str_out[0] = DIGITS[limbs[3]];
+  str_out[25] = 0;
+}
+
+/**
+ * Returns the 25-digit canonical string representations of multiple SCRU128
+ * IDs.
+ *
+ * The result is identical to that of `scru128_to_str()` applied to each ID. On
+ * x86-64, this function encodes up to sixteen IDs at a time with the widest of
+ * the SSE4.1, AVX2, and AVX-512BW kernels that the CPU supports.
+ *
+ * @param ids A `n * 16`-byte byte array containing consecutive SCRU128 IDs.
+ * @param n The number of IDs to encode.
+ * @param strs_out A `n * 26`-byte character array where the returned strings
+ * are stored consecutively. Each 26-byte element is a null-terminated string
+ * consisting of 25 `[0-9a-z]` characters and null.
+ */
+static inline void scru128_to_str_batch(const uint8_t *ids, size_t n,
+                                        char *strs_out) {
+  size_t i = 0;
+#ifdef SCRU128_HAS_X86_SIMD
+  switch (scru128_x86_simd_level()) {
+  case 3:
+    i = scru128_to_str_batch_avx512(ids, n, strs_out);
+    break;
+  case 2:
+    i = scru128_to_str_batch_avx2(ids, n, strs_out);
+    break;
+  case 1:
+    i = scru128_to_str_batch_sse41(ids, n, strs_out);
+    break;
+  }
+#endif
+  for (; i < n; i++) {
+    scru128_to_str(ids + SCRU128_LEN * i, strs_out + SCRU128_STR_LEN * i);
+  }
+}
+
+/**
+ * Returns a negative integer, zero, or positive integer if `id_lft` is less
+ * than, equal to, or greater than `id_rgt`, respectively.
+ *
+ * @param id_lft A 16-byte big-endian byte array that represents a SCRU128 ID.
+ * @param id_rgt A 16-byte big-endian byte array that represents a SCRU128 ID.
+ */
+static inline int scru128_compare(const uint8_t *id_lft,
+                                  const uint8_t *id_rgt) {
+  for (int_fast8_t i = 0; i < SCRU128_LEN; i++) {
+    if (id_lft[i] != id_rgt[i]) {
+      return id_lft[i] < id_rgt[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/** @} */
+
+/**
+ * @name Generator-related functions
+ *
+ * @{
+ */
+
+#ifdef SCRU128_ENABLE_STATS
+/**
+ * Copies the statistics collected by a generator to `stats_out`.
+ *
+ * @attention This function is NOT thread-safe. Take a snapshot while holding
+ * the lock that protects the generator `g`, if any.
+ */
+static inline void scru128_generator_stats(const Scru128Generator *g,
+                                           Scru128GeneratorStats *stats_out) {
+  *stats_out = g->_stats;
+}
+
+/**
+ * Resets the statistics collected by a generator to zero.
+ *
+ * A metrics exporter can take a snapshot and then reset the statistics to
+ * report the counts and the maximum drift per export interval.
+ *
+ * @attention This function is NOT thread-safe. Reset the statistics while
+ * holding the lock that protects the generator `g`, if any.
+ */
+static inline void scru128_generator_reset_stats(Scru128Generator *g) {
+  Scru128GeneratorStats zero = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+  g->_stats = zero;
+}
+#endif /* #ifdef SCRU128_ENABLE_STATS */
+
+/** Initializes a generator struct `g`. */
+static inline void scru128_generator_init(Scru128Generator *g) {
+  g->_timestamp = 0;
+  g->_counter_hi = 0;
+  g->_counter_lo = 0;
+  g->_ts_counter_hi = 0;
+  g->_shard = 0;
+  g->_shard_bits = 0;
+#ifdef SCRU128_ENABLE_STATS
+  scru128_generator_reset_stats(g);
+#endif
+}
+
+/**
+ * Initializes a generator struct `g` in the partitioned mode, where the upper
+ * `shard_bits` bits of the `counter_hi` field of every generated ID are fixed
+ * to `shard`.
+ *
+ * Generators initialized with distinct `shard` values (e.g., one per node)
+ * never generate the same ID regardless of the random numbers, so the
+ * uniqueness across them is guaranteed without coordination. The remaining
+ * lower bits of `counter_hi` work as usual; fewer random bits are left to
+ * distinguish generators sharing a shard, and `counter_hi` overflows (and thus
+ * `timestamp` is incremented) more often. Use `scru128_shard()` to extract the
+ * shard ID from a generated ID.
+ *
+ * @param g A generator state object to initialize.
+ * @param shard A node or shard ID that fits in `shard_bits` bits.
+ * @param shard_bits The number of the upper bits of `counter_hi` reserved for
+ * the shard ID, which must be no greater than 24.
+ * @return Zero on success or a non-zero integer if any argument is out of the
+ * value range.
+ */
+static inline int scru128_generator_init_sharded(Scru128Generator *g,
+                                                 uint32_t shard,
+                                                 uint32_t shard_bits) {
+  if (shard_bits > 24 || (uint64_t)shard >> shard_bits != 0) {
+    return -1;
+  }
+  scru128_generator_init(g);
+  g->_shard = shard;
+  g->_shard_bits = shard_bits;
+  return 0;
+}
+
+/**
+ * Returns a `counter_hi` field value consisting of `shard` in the upper
+ * `shard_bits` bits and the lower bits of `random`.
+ *
+ * @private
+ */
+static inline uint32_t scru128_shard_counter_hi(uint32_t shard,
+                                                uint32_t shard_bits,
+                                                uint32_t random) {
+  return shard << (24 - shard_bits) |
+         (random & SCRU128_MAX_COUNTER_HI >> shard_bits);
+}
+
+#ifdef SCRU128_ENABLE_STATS
+/**
+ * Returns a pointer to the counter of `status` in `stats`.
+ *
+ * @private
+ */
+static inline uint64_t *scru128_stats_counter(Scru128GeneratorStats *stats,
+                                              int8_t status) {
+  switch (status) {
+  case SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP:
+    return &stats->n_new_timestamp;
+  case SCRU128_GENERATOR_STATUS_COUNTER_LO_INC:
+    return &stats->n_counter_lo_inc;
+  case SCRU128_GENERATOR_STATUS_COUNTER_HI_INC:
+    return &stats->n_counter_hi_inc;
+  case SCRU128_GENERATOR_STATUS_TIMESTAMP_INC:
+    return &stats->n_timestamp_inc;
+  case SCRU128_GENERATOR_STATUS_ROLLBACK_RESET:
+    return &stats->n_rollback_reset;
+  case SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT:
+    return &stats->n_rollback_abort;
+  default:
+    return &stats->n_error;
+  }
+}
+#endif /* #ifdef SCRU128_ENABLE_STATS */
+
+/**
+ * Records the result of a generation in the statistics of `g` (if enabled) and
+ * returns `status` as is.
+ *
+ * @private
+ */
+static inline int8_t scru128_record(Scru128Generator *g, int8_t status,
+                                    uint64_t timestamp) {
+#ifdef SCRU128_ENABLE_STATS
+  Scru128GeneratorStats *stats = &g->_stats;
+  ++*scru128_stats_counter(stats, status);
+  if (status >= 0 && g->_timestamp > timestamp &&
+      g->_timestamp - timestamp > stats->max_drift) {
+    stats->max_drift = g->_timestamp - timestamp;
+  }
+#else
+  (void)g;
+  (void)timestamp;
+#endif
+  return status;
+}
+
+/**
+ * Takes back a status recorded by `scru128_record()`, so that a reset function
+ * records only its final status even though it calls the generation function
+ * twice.
+ *
+ * @private
+ */
+static inline void scru128_unrecord(Scru128Generator *g, int8_t status) {
+#ifdef SCRU128_ENABLE_STATS
+  --*scru128_stats_counter(&g->_stats, status);
+#else
+  (void)g;
+  (void)status;
+#endif
+}
+
+/**
+ * Calls `arc4random`, counting the call in the statistics of `g` (if enabled).
+ *
+ * @private
+ */
+static inline uint32_t scru128_random_uint32(Scru128Generator *g,
+                                             uint32_t (*arc4random)(void)) {
+#ifdef SCRU128_ENABLE_STATS
+  g->_stats.n_rng_calls++;
+#else
+  (void)g;
+#endif
+  return (*arc4random)();
+}
+
+/**
+ * Calls the `fill` function of `src`, counting the call in the statistics of
+ * `g` (if enabled).
+ *
+ * @private
+ */
+static inline void scru128_fill_random(Scru128Generator *g,
+                                       const Scru128RandomSource *src,
+                                       void *buf, size_t nbytes) {
+#ifdef SCRU128_ENABLE_STATS
+  g->_stats.n_rng_calls++;
+#else
+  (void)g;
+#endif
+  (*src->fill)(src->ctx, buf, nbytes);
+}
+
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random number
+ * generator, or returns an error upon significant timestamp rollback.
+ *
+ * This function returns a monotonically increasing ID by reusing the previous
+ * `timestamp` even if the one provided is smaller than the immediately
+ * preceding ID's. However, when such a clock rollback is considered significant
+ * (by more than `rollback_allowance` milliseconds), this function aborts and
+ * returns `SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT` immediately.
+ *
+ * See `scru128_generate_or_reset_core()` for the other mode of generation.
+ *
+ * @param g A generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t
+scru128_generate_or_abort_core(Scru128Generator *g, uint8_t *id_out,
+                               uint64_t timestamp, uint32_t (*arc4random)(void),
+                               uint64_t rollback_allowance) {
+  if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  }
+
+  int8_t status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
   if (timestamp > g->_timestamp) {
     g->_timestamp = timestamp;
-    g->_counter_lo = (*arc4random)() & SCRU128_MAX_COUNTER_LO;
+    g->_counter_lo =
+        scru128_random_uint32(g, arc4random) & SCRU128_MAX_COUNTER_LO;
   } else if (timestamp + rollback_allowance >= g->_timestamp) {
     // go on with previous timestamp if new one is not much smaller
     g->_counter_lo++;
@@ -410,77 +1795,998 @@ scru128_generate_or_abort_core(Scru128Generator *g, uint8_t *id_out,
       g->_counter_lo = 0;
       g->_counter_hi++;
       status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
-      if (g->_counter_hi > SCRU128_MAX_COUNTER_HI) {
-        g->_counter_hi = 0;
+      if ((g->_counter_hi & SCRU128_MAX_COUNTER_HI >> g->_shard_bits) == 0) {
+        g->_counter_hi = scru128_shard_counter_hi(g->_shard, g->_shard_bits, 0);
+        // increment timestamp at counter overflow
+        g->_timestamp++;
+        g->_counter_lo =
+            scru128_random_uint32(g, arc4random) & SCRU128_MAX_COUNTER_LO;
+        status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
+      }
+    }
+  } else {
+    // abort if clock went backwards to unbearable extent
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT,
+                          timestamp);
+  }
+
+  if (g->_timestamp - g->_ts_counter_hi >= 1000 || g->_ts_counter_hi == 0) {
+    g->_ts_counter_hi = g->_timestamp;
+    g->_counter_hi = scru128_shard_counter_hi(
+        g->_shard, g->_shard_bits, scru128_random_uint32(g, arc4random));
+  }
+
+  if (scru128_from_fields(id_out, g->_timestamp, g->_counter_hi, g->_counter_lo,
+                          scru128_random_uint32(g, arc4random)) == 0) {
+    return scru128_record(g, status, timestamp);
+  } else {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  }
+}
+
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random number
+ * generator, or resets the generator upon significant timestamp rollback.
+ *
+ * This function returns a monotonically increasing ID by reusing the previous
+ * `timestamp` even if the one provided is smaller than the immediately
+ * preceding ID's. However, when such a clock rollback is considered significant
+ * (by more than `rollback_allowance` milliseconds), this function resets the
+ * generator and returns a new ID based on the given `timestamp`, breaking the
+ * increasing order of IDs.
+ *
+ * See `scru128_generate_or_abort_core()` for the other mode of generation.
+ *
+ * @param g A generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t
+scru128_generate_or_reset_core(Scru128Generator *g, uint8_t *id_out,
+                               uint64_t timestamp, uint32_t (*arc4random)(void),
+                               uint64_t rollback_allowance) {
+  int8_t status = scru128_generate_or_abort_core(
+      g, id_out, timestamp, arc4random, rollback_allowance);
+  if (status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT) {
+    // reset state and resume
+    g->_timestamp = 0;
+    g->_ts_counter_hi = 0;
+    int8_t resumed = scru128_generate_or_abort_core(
+        g, id_out, timestamp, arc4random, rollback_allowance);
+    scru128_unrecord(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+    scru128_unrecord(g, resumed);
+    status = scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_RESET,
+                            timestamp);
+  }
+  return status;
+}
+
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random source, or
+ * returns an error upon significant timestamp rollback.
+ *
+ * This function works in the same manner as `scru128_generate_or_abort_core()`
+ * but obtains all the random bits needed for an ID (`counter_lo`, `counter_hi`,
+ * and `entropy`) through a single 10-byte `fill` call of `src`.
+ *
+ * See `scru128_generate_or_reset_core_src()` for the other mode of generation.
+ *
+ * @param g A generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param src A random source that provides (cryptographically strong) random
+ * bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_or_abort_core_src(
+    Scru128Generator *g, uint8_t *id_out, uint64_t timestamp,
+    const Scru128RandomSource *src, uint64_t rollback_allowance) {
+  if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (timestamp <= g->_timestamp &&
+             timestamp + rollback_allowance < g->_timestamp) {
+    // abort if clock went backwards to unbearable extent
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT,
+                          timestamp);
+  }
+
+  uint8_t r[10];
+  scru128_fill_random(g, src, r, sizeof(r));
+  uint32_t random_lo = (uint32_t)r[0] << 16 | (uint32_t)r[1] << 8 | r[2];
+  uint32_t random_hi = (uint32_t)r[3] << 16 | (uint32_t)r[4] << 8 | r[5];
+  uint32_t entropy = (uint32_t)r[6] << 24 | (uint32_t)r[7] << 16 |
+                     (uint32_t)r[8] << 8 | (uint32_t)r[9];
+
+  int8_t status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+  if (timestamp > g->_timestamp) {
+    g->_timestamp = timestamp;
+    g->_counter_lo = random_lo;
+  } else {
+    // go on with previous timestamp if new one is not much smaller
+    g->_counter_lo++;
+    status = SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+    if (g->_counter_lo > SCRU128_MAX_COUNTER_LO) {
+      g->_counter_lo = 0;
+      g->_counter_hi++;
+      status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
+      if ((g->_counter_hi & SCRU128_MAX_COUNTER_HI >> g->_shard_bits) == 0) {
+        g->_counter_hi = scru128_shard_counter_hi(g->_shard, g->_shard_bits, 0);
         // increment timestamp at counter overflow
         g->_timestamp++;
-        g->_counter_lo = (*arc4random)() & SCRU128_MAX_COUNTER_LO;
+        g->_counter_lo = random_lo;
         status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
       }
     }
+  }
+
+  if (g->_timestamp - g->_ts_counter_hi >= 1000 || g->_ts_counter_hi == 0) {
+    g->_ts_counter_hi = g->_timestamp;
+    g->_counter_hi =
+        scru128_shard_counter_hi(g->_shard, g->_shard_bits, random_hi);
+  }
+
+  if (scru128_from_fields(id_out, g->_timestamp, g->_counter_hi, g->_counter_lo,
+                          entropy) == 0) {
+    return scru128_record(g, status, timestamp);
   } else {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  }
+}
+
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random source, or
+ * resets the generator upon significant timestamp rollback.
+ *
+ * This function works in the same manner as `scru128_generate_or_reset_core()`
+ * but obtains all the random bits needed for an ID (`counter_lo`, `counter_hi`,
+ * and `entropy`) through a single 10-byte `fill` call of `src`.
+ *
+ * See `scru128_generate_or_abort_core_src()` for the other mode of generation.
+ *
+ * @param g A generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param src A random source that provides (cryptographically strong) random
+ * bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_or_reset_core_src(
+    Scru128Generator *g, uint8_t *id_out, uint64_t timestamp,
+    const Scru128RandomSource *src, uint64_t rollback_allowance) {
+  int8_t status = scru128_generate_or_abort_core_src(g, id_out, timestamp, src,
+                                                     rollback_allowance);
+  if (status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT) {
+    // reset state and resume
+    g->_timestamp = 0;
+    g->_ts_counter_hi = 0;
+    int8_t resumed = scru128_generate_or_abort_core_src(
+        g, id_out, timestamp, src, rollback_allowance);
+    scru128_unrecord(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+    scru128_unrecord(g, resumed);
+    status = scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_RESET,
+                            timestamp);
+  }
+  return status;
+}
+
+/**
+ * Takes a 24-bit random number from the spare random bytes of a batch
+ * generation, refilling the spare bytes when exhausted.
+ *
+ * @private
+ */
+static inline uint32_t scru128_take_uint24(Scru128Generator *g,
+                                           uint8_t *spare,
+                                           int_fast8_t *n_spare,
+                                           const Scru128RandomSource *src) {
+  if (*n_spare < 3) {
+    scru128_fill_random(g, src, spare, 6);
+    *n_spare = 6;
+  }
+  *n_spare -= 3;
+  return (uint32_t)spare[*n_spare] << 16 |
+         (uint32_t)spare[*n_spare + 1] << 8 | (uint32_t)spare[*n_spare + 2];
+}
+
+/**
+ * Generates `n` new SCRU128 IDs at once with the given `timestamp` and random
+ * source, or returns an error upon significant timestamp rollback.
+ *
+ * This function generates IDs under the same rules as `n` consecutive calls of
+ * `scru128_generate_or_abort_core()` with the same `timestamp` do, but it
+ * obtains the random bytes for the whole batch through a single `fill` call of
+ * `src` (except for rare counter overflows).
+ *
+ * See `scru128_generate_batch_or_reset_core_src()` for the other mode of
+ * generation.
+ *
+ * @param g A generator state object used to generate IDs.
+ * @param ids_out A `n * 16`-byte byte array where the generated SCRU128 IDs are
+ * stored consecutively.
+ * @param n The number of IDs to generate, which must be positive.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param src A random source that provides (cryptographically strong) random
+ * bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of generated IDs. A negative return code reports an error, in
+ * which case the content of `ids_out` is unspecified.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_batch_or_abort_core_src(
+    Scru128Generator *g, uint8_t *ids_out, size_t n, uint64_t timestamp,
+    const Scru128RandomSource *src, uint64_t rollback_allowance) {
+  if (n == 0 || n > SIZE_MAX / SCRU128_LEN) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (timestamp <= g->_timestamp &&
+             timestamp + rollback_allowance < g->_timestamp) {
     // abort if clock went backwards to unbearable extent
-    return SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT;
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT,
+                          timestamp);
+  }
+
+  // fill the tail of output array with random bytes: 6 spare bytes for counter
+  // renewals followed by 4 bytes of `entropy` per ID, which are consumed from
+  // front to back before being overwritten by the IDs generated
+  uint8_t *random_bytes = ids_out + (SCRU128_LEN - 4) * n - 6;
+  scru128_fill_random(g, src, random_bytes, 4 * n + 6);
+  uint8_t spare[6];
+  for (int_fast8_t i = 0; i < 6; i++) {
+    spare[i] = random_bytes[i];
+  }
+  int_fast8_t n_spare = 6;
+  random_bytes += 6;
+
+  int8_t max_status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+  for (size_t i = 0; i < n; i++) {
+    int8_t status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+    if (timestamp > g->_timestamp) {
+      g->_timestamp = timestamp;
+      g->_counter_lo = scru128_take_uint24(g, spare, &n_spare, src);
+    } else {
+      g->_counter_lo++;
+      status = SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+      if (g->_counter_lo > SCRU128_MAX_COUNTER_LO) {
+        g->_counter_lo = 0;
+        g->_counter_hi++;
+        status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
+        if ((g->_counter_hi & SCRU128_MAX_COUNTER_HI >> g->_shard_bits) == 0) {
+          g->_counter_hi =
+              scru128_shard_counter_hi(g->_shard, g->_shard_bits, 0);
+          // increment timestamp at counter overflow
+          g->_timestamp++;
+          g->_counter_lo = scru128_take_uint24(g, spare, &n_spare, src);
+          status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
+        }
+      }
+    }
+
+    if (g->_timestamp - g->_ts_counter_hi >= 1000 || g->_ts_counter_hi == 0) {
+      g->_ts_counter_hi = g->_timestamp;
+      g->_counter_hi = scru128_shard_counter_hi(
+          g->_shard, g->_shard_bits,
+          scru128_take_uint24(g, spare, &n_spare, src));
+    }
+
+    const uint8_t *e = random_bytes + 4 * i;
+    uint32_t entropy = (uint32_t)e[0] << 24 | (uint32_t)e[1] << 16 |
+                       (uint32_t)e[2] << 8 | (uint32_t)e[3];
+    if (scru128_from_fields(ids_out + SCRU128_LEN * i, g->_timestamp,
+                            g->_counter_hi, g->_counter_lo, entropy) != 0) {
+      return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+    }
+    if (status > max_status) {
+      max_status = status;
+    }
+  }
+  return scru128_record(g, max_status, timestamp);
+}
+
+/**
+ * Generates `n` new SCRU128 IDs at once with the given `timestamp` and random
+ * source, or resets the generator upon significant timestamp rollback.
+ *
+ * This function generates IDs under the same rules as `n` consecutive calls of
+ * `scru128_generate_or_reset_core()` with the same `timestamp` do, but it
+ * obtains the random bytes for the whole batch through a single `fill` call of
+ * `src` (except for rare counter overflows).
+ *
+ * See `scru128_generate_batch_or_abort_core_src()` for the other mode of
+ * generation.
+ *
+ * @param g A generator state object used to generate IDs.
+ * @param ids_out A `n * 16`-byte byte array where the generated SCRU128 IDs are
+ * stored consecutively.
+ * @param n The number of IDs to generate, which must be positive.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param src A random source that provides (cryptographically strong) random
+ * bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of generated IDs. A negative return code reports an error, in
+ * which case the content of `ids_out` is unspecified.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_batch_or_reset_core_src(
+    Scru128Generator *g, uint8_t *ids_out, size_t n, uint64_t timestamp,
+    const Scru128RandomSource *src, uint64_t rollback_allowance) {
+  int8_t status = scru128_generate_batch_or_abort_core_src(
+      g, ids_out, n, timestamp, src, rollback_allowance);
+  if (status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT) {
+    // reset state and resume
+    g->_timestamp = 0;
+    g->_ts_counter_hi = 0;
+    int8_t resumed = scru128_generate_batch_or_abort_core_src(
+        g, ids_out, n, timestamp, src, rollback_allowance);
+    scru128_unrecord(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+    scru128_unrecord(g, resumed);
+    status = scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_RESET,
+                            timestamp);
+  }
+  return status;
+}
+
+/**
+ * Implements `Scru128RandomSource::fill` by calling the `arc4random_buf()`
+ * compatible function pointed to by `ctx`.
+ *
+ * @private
+ */
+static inline void scru128_arc4random_buf_fill(void *ctx, void *buf,
+                                               size_t nbytes) {
+  (**(void (**)(void *, size_t))ctx)(buf, nbytes);
+}
+
+/**
+ * Generates `n` new SCRU128 IDs at once with the given `timestamp` and random
+ * number generator, or returns an error upon significant timestamp rollback.
+ *
+ * This function is equivalent to `scru128_generate_batch_or_abort_core_src()`
+ * with a random source that calls `arc4random_buf`.
+ *
+ * See `scru128_generate_batch_or_reset_core()` for the other mode of
+ * generation.
+ *
+ * @param g A generator state object used to generate IDs.
+ * @param ids_out A `n * 16`-byte byte array where the generated SCRU128 IDs are
+ * stored consecutively.
+ * @param n The number of IDs to generate, which must be positive.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random_buf A function pointer to `arc4random_buf()` or a
+ * compatible function that fills a buffer with (cryptographically strong)
+ * random bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of generated IDs. A negative return code reports an error, in
+ * which case the content of `ids_out` is unspecified.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_batch_or_abort_core(
+    Scru128Generator *g, uint8_t *ids_out, size_t n, uint64_t timestamp,
+    void (*arc4random_buf)(void *, size_t), uint64_t rollback_allowance) {
+  Scru128RandomSource src = {&arc4random_buf, &scru128_arc4random_buf_fill};
+  return scru128_generate_batch_or_abort_core_src(g, ids_out, n, timestamp,
+                                                  &src, rollback_allowance);
+}
+
+/**
+ * Generates `n` new SCRU128 IDs at once with the given `timestamp` and random
+ * number generator, or resets the generator upon significant timestamp
+ * rollback.
+ *
+ * This function is equivalent to `scru128_generate_batch_or_reset_core_src()`
+ * with a random source that calls `arc4random_buf`.
+ *
+ * See `scru128_generate_batch_or_abort_core()` for the other mode of
+ * generation.
+ *
+ * @param g A generator state object used to generate IDs.
+ * @param ids_out A `n * 16`-byte byte array where the generated SCRU128 IDs are
+ * stored consecutively.
+ * @param n The number of IDs to generate, which must be positive.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random_buf A function pointer to `arc4random_buf()` or a
+ * compatible function that fills a buffer with (cryptographically strong)
+ * random bytes.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of generated IDs. A negative return code reports an error, in
+ * which case the content of `ids_out` is unspecified.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generate_batch_or_reset_core(
+    Scru128Generator *g, uint8_t *ids_out, size_t n, uint64_t timestamp,
+    void (*arc4random_buf)(void *, size_t), uint64_t rollback_allowance) {
+  Scru128RandomSource src = {&arc4random_buf, &scru128_arc4random_buf_fill};
+  return scru128_generate_batch_or_reset_core_src(g, ids_out, n, timestamp,
+                                                  &src, rollback_allowance);
+}
+
+/**
+ * Advances the counter fields by `delta` as if incrementing `counter_lo`
+ * `delta` times, carrying `counter_lo` overflow into `counter_hi` and
+ * `counter_hi` overflow into `timestamp`, while keeping the upper `shard_bits`
+ * bits of `counter_hi` intact.
+ *
+ * @param delta The amount of increment, which must not exceed 48 bits.
+ * @return The `SCRU128_GENERATOR_STATUS_*_INC` code that describes the most
+ * significant field incremented.
+ * @private
+ */
+static inline int8_t scru128_advance_counters(uint64_t *timestamp,
+                                              uint32_t *counter_hi,
+                                              uint32_t *counter_lo,
+                                              uint32_t shard_bits,
+                                              uint64_t delta) {
+  uint32_t mask = SCRU128_MAX_COUNTER_HI >> shard_bits;
+  uint64_t counters = ((uint64_t)(*counter_hi & mask) << 24 | *counter_lo) +
+                      delta;
+  int8_t status = SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+  if (counters >> 24 != (*counter_hi & mask)) {
+    status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
+  }
+  if (counters >> (48 - shard_bits) != 0) {
+    *timestamp += counters >> (48 - shard_bits);
+    status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
   }
+  *counter_hi = (*counter_hi & ~mask) | ((uint32_t)(counters >> 24) & mask);
+  *counter_lo = (uint32_t)counters & SCRU128_MAX_COUNTER_LO;
+  return status;
+}
 
-  if (g->_timestamp - g->_ts_counter_hi >= 1000 || g->_ts_counter_hi == 0) {
-    g->_ts_counter_hi = g->_timestamp;
-    g->_counter_hi = (*arc4random)() & SCRU128_MAX_COUNTER_HI;
+/**
+ * Reserves a block of `n` consecutive counter values with the given `timestamp`
+ * and random number generator, or returns an error upon significant timestamp
+ * rollback.
+ *
+ * This function advances the generator as `n` consecutive calls of
+ * `scru128_generate_or_abort_core()` with the same `timestamp` would do, except
+ * that the counters simply wrap around within the block: `counter_lo` overflow
+ * increments `counter_hi` and `counter_hi` overflow increments `timestamp`. The
+ * IDs created from the block by `scru128_counter_block_generate()` are thus
+ * greater than the IDs generated by `g` before the reservation and smaller than
+ * those generated after it.
+ *
+ * See `scru128_generator_reserve_or_reset_core()` for the other mode of
+ * generation.
+ *
+ * @param g A generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive and no
+ * greater than `2^48`.
+ * @param block_out A counter block object where the reserved values are stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error,
+ * in which case `g` and `block_out` are left untouched.
+ * @attention This function is NOT thread-safe. The generator `g` should be
+ * protected from concurrent accesses using a mutex or other synchronization
+ * mechanism to avoid race conditions.
+ */
+static inline int8_t scru128_generator_reserve_or_abort_core(
+    Scru128Generator *g, size_t n, Scru128CounterBlock *block_out,
+    uint64_t timestamp, uint32_t (*arc4random)(void),
+    uint64_t rollback_allowance) {
+  if (n == 0 || (uint64_t)(n - 1) > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  } else if (timestamp <= g->_timestamp &&
+             timestamp + rollback_allowance < g->_timestamp) {
+    // abort if clock went backwards to unbearable extent
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT,
+                          timestamp);
   }
 
-  if (scru128_from_fields(id_out, g->_timestamp, g->_counter_hi, g->_counter_lo,
-                          (*arc4random)()) == 0) {
-    return status;
+  // take the first value in the same manner as a single generation
+  uint64_t ts = g->_timestamp;
+  uint32_t counter_hi = g->_counter_hi;
+  uint32_t counter_lo = g->_counter_lo;
+  uint64_t ts_counter_hi = g->_ts_counter_hi;
+  int8_t status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+  if (timestamp > ts) {
+    ts = timestamp;
+    counter_lo =
+        scru128_random_uint32(g, arc4random) & SCRU128_MAX_COUNTER_LO;
   } else {
-    return SCRU128_GENERATOR_STATUS_ERROR;
+    status = scru128_advance_counters(&ts, &counter_hi, &counter_lo,
+                                      g->_shard_bits, 1);
+    if (status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC) {
+      counter_lo =
+          scru128_random_uint32(g, arc4random) & SCRU128_MAX_COUNTER_LO;
+    }
+  }
+
+  if (ts - ts_counter_hi >= 1000 || ts_counter_hi == 0) {
+    ts_counter_hi = ts;
+    counter_hi = scru128_shard_counter_hi(
+        g->_shard, g->_shard_bits, scru128_random_uint32(g, arc4random));
+  }
+
+  Scru128CounterBlock block = {ts, counter_hi, counter_lo, g->_shard_bits, n};
+  if (n > 1) {
+    int8_t s = scru128_advance_counters(&ts, &counter_hi, &counter_lo,
+                                        g->_shard_bits, n - 1);
+    status = s > status ? s : status;
   }
+  if (ts > SCRU128_MAX_TIMESTAMP) {
+    return scru128_record(g, SCRU128_GENERATOR_STATUS_ERROR, timestamp);
+  }
+
+  g->_timestamp = ts;
+  g->_counter_hi = counter_hi;
+  g->_counter_lo = counter_lo;
+  g->_ts_counter_hi = ts_counter_hi;
+  *block_out = block;
+  return scru128_record(g, status, timestamp);
 }
 
 /**
- * Generates a new SCRU128 ID with the given `timestamp` and random number
- * generator, or resets the generator upon significant timestamp rollback.
+ * Reserves a block of `n` consecutive counter values with the given `timestamp`
+ * and random number generator, or resets the generator upon significant
+ * timestamp rollback.
  *
- * This function returns a monotonically increasing ID by reusing the previous
- * `timestamp` even if the one provided is smaller than the immediately
- * preceding ID's. However, when such a clock rollback is considered significant
- * (by more than `rollback_allowance` milliseconds), this function resets the
- * generator and returns a new ID based on the given `timestamp`, breaking the
- * increasing order of IDs.
+ * This function works in the same manner as
+ * `scru128_generator_reserve_or_abort_core()` but resets the generator and
+ * reserves values based on the given `timestamp` when a clock rollback is
+ * considered significant, breaking the increasing order of IDs.
  *
- * See `scru128_generate_or_abort_core()` for the other mode of generation.
+ * See `scru128_generator_reserve_or_abort_core()` for the other mode of
+ * generation.
  *
- * @param g A generator state object used to generate an ID.
- * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param g A generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive and no
+ * greater than `2^48`.
+ * @param block_out A counter block object where the reserved values are stored.
  * @param timestamp A 48-bit `timestamp` field value.
  * @param arc4random A function pointer to `arc4random()` or a compatible
  * function that returns a (cryptographically strong) random number in the range
  * of 32-bit unsigned integer.
  * @param rollback_allowance The amount of `timestamp` rollback that is
  * considered significant. A suggested value is `10000` (milliseconds).
- * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
- * characteristics of generated ID. A negative return code reports an error.
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error.
  * @attention This function is NOT thread-safe. The generator `g` should be
  * protected from concurrent accesses using a mutex or other synchronization
  * mechanism to avoid race conditions.
  */
-static inline int8_t
-scru128_generate_or_reset_core(Scru128Generator *g, uint8_t *id_out,
-                               uint64_t timestamp, uint32_t (*arc4random)(void),
-                               uint64_t rollback_allowance) {
-  int8_t status = scru128_generate_or_abort_core(
-      g, id_out, timestamp, arc4random, rollback_allowance);
+static inline int8_t scru128_generator_reserve_or_reset_core(
+    Scru128Generator *g, size_t n, Scru128CounterBlock *block_out,
+    uint64_t timestamp, uint32_t (*arc4random)(void),
+    uint64_t rollback_allowance) {
+  int8_t status = scru128_generator_reserve_or_abort_core(
+      g, n, block_out, timestamp, arc4random, rollback_allowance);
   if (status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT) {
     // reset state and resume
     g->_timestamp = 0;
     g->_ts_counter_hi = 0;
-    scru128_generate_or_abort_core(g, id_out, timestamp, arc4random,
-                                   rollback_allowance);
-    status = SCRU128_GENERATOR_STATUS_ROLLBACK_RESET;
+    status = scru128_generator_reserve_or_abort_core(
+        g, n, block_out, timestamp, arc4random, rollback_allowance);
+    scru128_unrecord(g, SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+    if (status >= 0) {
+      scru128_unrecord(g, status);
+      status = scru128_record(g, SCRU128_GENERATOR_STATUS_ROLLBACK_RESET,
+                              timestamp);
+    }
+  }
+  return status;
+}
+
+/**
+ * Creates a new SCRU128 ID from the next value of a counter block.
+ *
+ * The IDs created from a block are monotonically increasing. This function
+ * touches only `block`, so each thread can create IDs from its own block
+ * without any synchronization once the block has been reserved.
+ *
+ * @param block A counter block object filled by a reservation function.
+ * @param id_out A 16-byte byte array where the created SCRU128 ID is stored.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer.
+ * @return Zero on success or a non-zero integer if the block is exhausted.
+ */
+static inline int scru128_counter_block_generate(Scru128CounterBlock *block,
+                                                 uint8_t *id_out,
+                                                 uint32_t (*arc4random)(void)) {
+  if (block->_n_remaining == 0) {
+    return -1;
+  }
+  scru128_from_fields(id_out, block->_timestamp, block->_counter_hi,
+                      block->_counter_lo, (*arc4random)());
+  if (--block->_n_remaining > 0) {
+    scru128_advance_counters(&block->_timestamp, &block->_counter_hi,
+                             &block->_counter_lo, block->_shard_bits, 1);
+  }
+  return 0;
+}
+
+/** @} */
+
+#ifdef SCRU128_HAS_ATOMIC_GENERATOR
+/**
+ * @name Lock-free generator functions
+ *
+ * These functions are available if `SCRU128_HAS_ATOMIC_GENERATOR` is defined.
+ *
+ * @{
+ */
+
+/**
+ * Initializes a lock-free generator struct `g`.
+ *
+ * @attention This function is NOT thread-safe. The generator `g` must not be
+ * shared with other threads until initialized.
+ */
+static inline void scru128_atomic_generator_init(Scru128AtomicGenerator *g) {
+  g->_state._timestamp_ttl = 0;
+  g->_state._counters = 0;
+  g->_shard = 0;
+  g->_shard_bits = 0;
+}
+
+/**
+ * Initializes a lock-free generator struct `g` in the partitioned mode, where
+ * the upper `shard_bits` bits of the `counter_hi` field of every generated ID
+ * are fixed to `shard`.
+ *
+ * See `scru128_generator_init_sharded()` for the details.
+ *
+ * @param g A lock-free generator state object to initialize.
+ * @param shard A node or shard ID that fits in `shard_bits` bits.
+ * @param shard_bits The number of the upper bits of `counter_hi` reserved for
+ * the shard ID, which must be no greater than 24.
+ * @return Zero on success or a non-zero integer if any argument is out of the
+ * value range.
+ * @attention This function is NOT thread-safe. The generator `g` must not be
+ * shared with other threads until initialized.
+ */
+static inline int
+scru128_atomic_generator_init_sharded(Scru128AtomicGenerator *g,
+                                      uint32_t shard, uint32_t shard_bits) {
+  if (shard_bits > 24 || (uint64_t)shard >> shard_bits != 0) {
+    return -1;
+  }
+  scru128_atomic_generator_init(g);
+  g->_shard = shard;
+  g->_shard_bits = shard_bits;
+  return 0;
+}
+
+/**
+ * Implements the generation and reservation functions of the lock-free
+ * generator by reserving `n` values in a single compare-and-swap operation.
+ *
+ * @private
+ */
+static inline int8_t scru128_atomic_reserve_core(
+    Scru128AtomicGenerator *g, size_t n, Scru128CounterBlock *block_out,
+    uint64_t timestamp, uint32_t (*arc4random)(void),
+    uint64_t rollback_allowance, int reset) {
+  if (n == 0 || (uint64_t)(n - 1) > SCRU128_MAX_TIMESTAMP) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  } else if (timestamp == 0 || timestamp > SCRU128_MAX_TIMESTAMP) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  } else if (rollback_allowance > SCRU128_MAX_TIMESTAMP) {
+    return SCRU128_GENERATOR_STATUS_ERROR;
+  }
+
+  // draw random numbers lazily and reuse them across retries
+  uint32_t random_lo = 0, random_hi = 0;
+  int has_random_lo = 0, has_random_hi = 0;
+
+  Scru128AtomicState prev, next;
+  uint64_t ts, last_ts;
+  uint32_t counter_hi, counter_lo, last_counter_hi, last_counter_lo;
+  int8_t status;
+  __atomic_load(&g->_state, &prev, __ATOMIC_ACQUIRE);
+  do {
+    ts = prev._timestamp_ttl >> 16;
+    uint64_t ttl = prev._timestamp_ttl & 0xffff;
+    counter_hi = (uint32_t)(prev._counters >> 24) & SCRU128_MAX_COUNTER_HI;
+    counter_lo = (uint32_t)prev._counters & SCRU128_MAX_COUNTER_LO;
+
+    status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+    if (timestamp > ts) {
+      ttl = ttl > timestamp - ts ? ttl - (timestamp - ts) : 0;
+      ts = timestamp;
+      counter_lo = SCRU128_MAX_COUNTER_LO + 1;
+    } else if (timestamp + rollback_allowance >= ts) {
+      // go on with previous timestamp if new one is not much smaller
+      counter_lo++;
+      status = SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+      if (counter_lo > SCRU128_MAX_COUNTER_LO) {
+        counter_lo = 0;
+        counter_hi++;
+        status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
+        if ((counter_hi & SCRU128_MAX_COUNTER_HI >> g->_shard_bits) == 0) {
+          counter_hi = scru128_shard_counter_hi(g->_shard, g->_shard_bits, 0);
+          // increment timestamp at counter overflow
+          ts++;
+          ttl = ttl > 0 ? ttl - 1 : 0;
+          counter_lo = SCRU128_MAX_COUNTER_LO + 1;
+          status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
+        }
+      }
+    } else if (reset) {
+      // reset state and resume
+      ts = timestamp;
+      ttl = 0;
+      counter_lo = SCRU128_MAX_COUNTER_LO + 1;
+      status = SCRU128_GENERATOR_STATUS_ROLLBACK_RESET;
+    } else {
+      // abort if clock went backwards to unbearable extent
+      return SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT;
+    }
+
+    if (counter_lo > SCRU128_MAX_COUNTER_LO) {
+      if (!has_random_lo) {
+        random_lo = (*arc4random)() & SCRU128_MAX_COUNTER_LO;
+        has_random_lo = 1;
+      }
+      counter_lo = random_lo;
+    }
+
+    if (ttl == 0) {
+      if (!has_random_hi) {
+        random_hi = scru128_shard_counter_hi(g->_shard, g->_shard_bits,
+                                             (*arc4random)());
+        has_random_hi = 1;
+      }
+      counter_hi = random_hi;
+      ttl = 1000;
+    }
+
+    last_ts = ts;
+    last_counter_hi = counter_hi;
+    last_counter_lo = counter_lo;
+    if (n > 1) {
+      int8_t s = scru128_advance_counters(&last_ts, &last_counter_hi,
+                                          &last_counter_lo, g->_shard_bits,
+                                          n - 1);
+      status = s > status ? s : status;
+      ttl = ttl > last_ts - ts ? ttl - (last_ts - ts) : 0;
+    }
+    if (last_ts > SCRU128_MAX_TIMESTAMP) {
+      return SCRU128_GENERATOR_STATUS_ERROR;
+    }
+
+    next._timestamp_ttl = last_ts << 16 | ttl;
+    next._counters = (uint64_t)last_counter_hi << 24 | last_counter_lo;
+  } while (!__atomic_compare_exchange(&g->_state, &prev, &next, 0,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+  block_out->_timestamp = ts;
+  block_out->_counter_hi = counter_hi;
+  block_out->_counter_lo = counter_lo;
+  block_out->_shard_bits = g->_shard_bits;
+  block_out->_n_remaining = n;
+  return status;
+}
+
+/**
+ * Implements `scru128_atomic_generate_or_abort_core()` and
+ * `scru128_atomic_generate_or_reset_core()`.
+ *
+ * @private
+ */
+static inline int8_t scru128_atomic_generate_core(
+    Scru128AtomicGenerator *g, uint8_t *id_out, uint64_t timestamp,
+    uint32_t (*arc4random)(void), uint64_t rollback_allowance, int reset) {
+  Scru128CounterBlock block;
+  int8_t status = scru128_atomic_reserve_core(
+      g, 1, &block, timestamp, arc4random, rollback_allowance, reset);
+  if (status >= 0) {
+    scru128_counter_block_generate(&block, id_out, arc4random);
   }
   return status;
 }
 
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random number
+ * generator using a lock-free generator, or returns an error upon significant
+ * timestamp rollback.
+ *
+ * This function works in the same manner as `scru128_generate_or_abort_core()`
+ * but can be called concurrently from multiple threads without locks; it
+ * advances the packed generator state with a 128-bit compare-and-swap loop, so
+ * the IDs returned to all threads are unique and ordered by the time each
+ * update takes effect.
+ *
+ * See `scru128_atomic_generate_or_reset_core()` for the other mode of
+ * generation.
+ *
+ * @param g A lock-free generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer. It must be thread-safe.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ */
+static inline int8_t scru128_atomic_generate_or_abort_core(
+    Scru128AtomicGenerator *g, uint8_t *id_out, uint64_t timestamp,
+    uint32_t (*arc4random)(void), uint64_t rollback_allowance) {
+  return scru128_atomic_generate_core(g, id_out, timestamp, arc4random,
+                                      rollback_allowance, 0);
+}
+
+/**
+ * Generates a new SCRU128 ID with the given `timestamp` and random number
+ * generator using a lock-free generator, or resets the generator upon
+ * significant timestamp rollback.
+ *
+ * This function works in the same manner as `scru128_generate_or_reset_core()`
+ * but can be called concurrently from multiple threads without locks; it
+ * advances the packed generator state with a 128-bit compare-and-swap loop, so
+ * the IDs returned to all threads are unique and ordered by the time each
+ * update takes effect.
+ *
+ * See `scru128_atomic_generate_or_abort_core()` for the other mode of
+ * generation.
+ *
+ * @param g A lock-free generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer. It must be thread-safe.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ */
+static inline int8_t scru128_atomic_generate_or_reset_core(
+    Scru128AtomicGenerator *g, uint8_t *id_out, uint64_t timestamp,
+    uint32_t (*arc4random)(void), uint64_t rollback_allowance) {
+  return scru128_atomic_generate_core(g, id_out, timestamp, arc4random,
+                                      rollback_allowance, 1);
+}
+
+/**
+ * Reserves a block of `n` consecutive counter values with the given `timestamp`
+ * and random number generator using a lock-free generator, or returns an error
+ * upon significant timestamp rollback.
+ *
+ * This function works in the same manner as
+ * `scru128_generator_reserve_or_abort_core()` but can be called concurrently
+ * from multiple threads without locks. A thread that creates IDs from its own
+ * block by `scru128_counter_block_generate()` touches the shared generator only
+ * once per `n` IDs, which greatly reduces contention among high-rate producers.
+ * The IDs from different blocks are ordered by the time each reservation takes
+ * effect, but IDs created from a block later are not ordered with IDs generated
+ * by `g` after the reservation.
+ *
+ * See `scru128_atomic_generator_reserve_or_reset_core()` for the other mode of
+ * generation.
+ *
+ * @param g A lock-free generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive and no
+ * greater than `2^48`.
+ * @param block_out A counter block object where the reserved values are stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer. It must be thread-safe.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error.
+ */
+static inline int8_t scru128_atomic_generator_reserve_or_abort_core(
+    Scru128AtomicGenerator *g, size_t n, Scru128CounterBlock *block_out,
+    uint64_t timestamp, uint32_t (*arc4random)(void),
+    uint64_t rollback_allowance) {
+  return scru128_atomic_reserve_core(g, n, block_out, timestamp, arc4random,
+                                     rollback_allowance, 0);
+}
+
+/**
+ * Reserves a block of `n` consecutive counter values with the given `timestamp`
+ * and random number generator using a lock-free generator, or resets the
+ * generator upon significant timestamp rollback.
+ *
+ * This function works in the same manner as
+ * `scru128_generator_reserve_or_reset_core()` but can be called concurrently
+ * from multiple threads without locks. See
+ * `scru128_atomic_generator_reserve_or_abort_core()` for the details.
+ *
+ * @param g A lock-free generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive and no
+ * greater than `2^48`.
+ * @param block_out A counter block object where the reserved values are stored.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @param arc4random A function pointer to `arc4random()` or a compatible
+ * function that returns a (cryptographically strong) random number in the range
+ * of 32-bit unsigned integer. It must be thread-safe.
+ * @param rollback_allowance The amount of `timestamp` rollback that is
+ * considered significant. A suggested value is `10000` (milliseconds).
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error.
+ */
+static inline int8_t scru128_atomic_generator_reserve_or_reset_core(
+    Scru128AtomicGenerator *g, size_t n, Scru128CounterBlock *block_out,
+    uint64_t timestamp, uint32_t (*arc4random)(void),
+    uint64_t rollback_allowance) {
+  return scru128_atomic_reserve_core(g, n, block_out, timestamp, arc4random,
+                                     rollback_allowance, 1);
+}
+
+/**
+ * Raises a timestamp watermark shared among threads to `timestamp` if it is
+ * smaller and returns the resulting value.
+ *
+ * Independent generators (e.g., per-thread ones) can guarantee the merge order
+ * of their outputs at millisecond granularity by generating IDs with the
+ * timestamp returned by this function and then raising the watermark to the
+ * `timestamp` of each generated ID; an ID generated after another ID is
+ * returned from any generator then never has a smaller `timestamp`.
+ *
+ * @param watermark A pointer to the shared watermark initialized with zero.
+ * @param timestamp A 48-bit `timestamp` field value.
+ * @return The greater of `timestamp` and the current watermark.
+ */
+static inline uint64_t scru128_atomic_raise_watermark(uint64_t *watermark,
+                                                      uint64_t timestamp) {
+  uint64_t current = __atomic_load_n(watermark, __ATOMIC_ACQUIRE);
+  while (current < timestamp &&
+         !__atomic_compare_exchange_n(watermark, &current, timestamp, 1,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+  }
+  return current < timestamp ? timestamp : current;
+}
+
 /** @} */
+#endif /* #ifdef SCRU128_HAS_ATOMIC_GENERATOR */
 
 /**
  * @name High-level generator APIs that require platform integration
@@ -507,6 +2813,174 @@ scru128_generate_or_reset_core(Scru128Generator *g, uint8_t *id_out,
  */
 int scru128_generate(Scru128Generator *g, uint8_t *id_out);
 
+/**
+ * Generates `n` new SCRU128 IDs at once from the current `timestamp`.
+ *
+ * @param g A generator state object used to generate IDs.
+ * @param ids_out A `n * 16`-byte byte array where the generated SCRU128 IDs are
+ * stored consecutively.
+ * @param n The number of IDs to generate, which must be positive.
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of generated IDs. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by integrating
+ * `scru128_generate_batch_or_reset_core()` or
+ * `scru128_generate_batch_or_abort_core()` with the real-time clock and random
+ * number generator available in the system.
+ * @attention See `scru128_generate()` for the thread-safety consideration.
+ */
+int scru128_generate_batch(Scru128Generator *g, uint8_t *ids_out, size_t n);
+
+/**
+ * Generates a new SCRU128 ID from the current `timestamp` using a generator
+ * owned by the calling thread.
+ *
+ * Each thread has its own generator, so this function scales with the number
+ * of threads without contention. The uniqueness of IDs across threads relies
+ * on the random `counter_hi` that each generator initializes and renews every
+ * second, and the IDs are monotonically increasing only within each thread.
+ *
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by keeping a
+ * zero-initialized `Scru128Generator` in thread-local storage aligned to a
+ * cache line and passing it to `scru128_generate()`.
+ * @note This function is thread-safe if implemented as noted above.
+ */
+int scru128_generate_tls(uint8_t *id_out);
+
+#ifdef SCRU128_ENABLE_STATS
+/**
+ * Copies the statistics collected by the generator that the calling thread
+ * uses in `scru128_generate_tls()` and `scru128_generate_tls_ordered()`.
+ *
+ * Thread-local generators are reachable only from their own threads, so this
+ * function reports the calling thread only; a metrics exporter should call it
+ * in each thread (e.g., periodically or before the thread exits) and sum up the
+ * results. The generators passed explicitly to `scru128_generate()` and the
+ * other functions are read by `scru128_generator_stats()` instead.
+ *
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by passing the
+ * thread-local generator to `scru128_generator_stats()`.
+ * @note This function is thread-safe if implemented as noted above.
+ */
+void scru128_tls_generator_stats(Scru128GeneratorStats *stats_out);
+#endif /* #ifdef SCRU128_ENABLE_STATS */
+
+/**
+ * Reserves a block of `n` consecutive counter values from the current
+ * `timestamp`, from which IDs can be created by
+ * `scru128_counter_block_generate()` without accessing the generator.
+ *
+ * @param g A generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive.
+ * @param block_out A counter block object where the reserved values are stored.
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by integrating
+ * `scru128_generator_reserve_or_reset_core()` or
+ * `scru128_generator_reserve_or_abort_core()` with the real-time clock and
+ * random number generator available in the system.
+ * @attention See `scru128_generate()` for the thread-safety consideration.
+ */
+int scru128_generator_reserve(Scru128Generator *g, size_t n,
+                              Scru128CounterBlock *block_out);
+
+#ifdef SCRU128_HAS_ATOMIC_GENERATOR
+/**
+ * Generates a new SCRU128 ID from the current `timestamp` using a lock-free
+ * generator.
+ *
+ * @param g A lock-free generator state object used to generate an ID.
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by integrating
+ * `scru128_atomic_generate_or_reset_core()` or
+ * `scru128_atomic_generate_or_abort_core()` with the real-time clock and a
+ * thread-safe random number generator available in the system.
+ * @note This function is thread-safe if implemented with a thread-safe clock
+ * and random number generator.
+ */
+int scru128_atomic_generate(Scru128AtomicGenerator *g, uint8_t *id_out);
+
+/**
+ * Reserves a block of `n` consecutive counter values from the current
+ * `timestamp` using a lock-free generator.
+ *
+ * @param g A lock-free generator state object used to reserve values.
+ * @param n The number of values to reserve, which must be positive.
+ * @param block_out A counter block object where the reserved values are stored.
+ * @return The greatest of `SCRU128_GENERATOR_STATUS_*` codes that describe the
+ * characteristics of reserved values. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by integrating
+ * `scru128_atomic_generator_reserve_or_reset_core()` or
+ * `scru128_atomic_generator_reserve_or_abort_core()` with the real-time clock
+ * and a thread-safe random number generator available in the system.
+ * @note This function is thread-safe if implemented with a thread-safe clock
+ * and random number generator.
+ */
+int scru128_atomic_generator_reserve(Scru128AtomicGenerator *g, size_t n,
+                                     Scru128CounterBlock *block_out);
+
+/**
+ * Maps a lock-free generator placed in a named shared memory object into the
+ * address space of the calling process, creating the object if necessary.
+ *
+ * All the processes that open the same `name` share a single generator, so the
+ * IDs generated by `scru128_atomic_generate()` with it are unique and
+ * monotonically ordered across processes on the host. Every update of the
+ * generator is a single compare-and-swap operation, so a process that dies at
+ * any moment never leaves the generator in an inconsistent state.
+ *
+ * @param name The name of the shared memory object, such as `"/scru128"`.
+ * @return A pointer to the shared generator, or `NULL` on failure, including
+ * the case where 16-byte atomic operations are not lock-free and therefore
+ * cannot be shared among processes.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by mapping a
+ * zero-filled shared memory object created by, for example, `shm_open()` or
+ * `memfd_create()`.
+ */
+Scru128AtomicGenerator *scru128_shared_generator_open(const char *name);
+
+/**
+ * Unmaps a generator returned by `scru128_shared_generator_open()` from the
+ * address space of the calling process.
+ *
+ * @note Provide a concrete implementation of
+ * `scru128_shared_generator_open()` to enable this function.
+ */
+void scru128_shared_generator_close(Scru128AtomicGenerator *g);
+
+/**
+ * Generates a new SCRU128 ID from the current `timestamp` using a generator
+ * owned by the calling thread, guaranteeing the merge order across threads at
+ * millisecond granularity.
+ *
+ * This function works in the same manner as `scru128_generate_tls()`, except
+ * that an ID generated by this function never has a smaller `timestamp` than
+ * IDs already returned by this function in any thread. IDs from different
+ * threads sharing the same `timestamp` are not ordered.
+ *
+ * @param id_out A 16-byte byte array where the generated SCRU128 ID is stored.
+ * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+ * characteristics of generated ID. A negative return code reports an error.
+ * @note This single-file library does not provide a concrete implementation of
+ * this function, so users have to implement it (if necessary) by integrating
+ * the thread-local generator of `scru128_generate_tls()` with a timestamp
+ * watermark shared through `scru128_atomic_raise_watermark()`.
+ * @note This function is thread-safe if implemented as noted above.
+ */
+int scru128_generate_tls_ordered(uint8_t *id_out);
+#endif /* #ifdef SCRU128_HAS_ATOMIC_GENERATOR */
+
 /**
  * Generates a new SCRU128 ID encoded in the 25-digit canonical string
  * representation.
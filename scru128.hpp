@@ -0,0 +1,675 @@
+/**
+ * @file scru128.hpp
+ *
+ * SCRU128: Sortable, Clock and Random number-based Unique identifier (C++
+ * value type)
+ *
+ * This optional header wraps the binary representation of `scru128.h` in a
+ * trivially copyable value type that supports `constexpr` conversion from and
+ * to the string representation. It requires C++17, and it enables `operator<=>`
+ * (C++20), `consteval` literals (C++20), and `std::format` support (C++20)
+ * where the compiler and standard library provide them.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_HPP_QKZRWNEM
+#define SCRU128_HPP_QKZRWNEM
+
+#if !defined(__cplusplus) ||                                                   \
+    (__cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L))
+#error "scru128.hpp requires C++17 or later"
+#endif
+
+#include "scru128.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_impl_three_way_comparison) &&                                \
+    __cpp_impl_three_way_comparison >= 201907L && __has_include(<compare>)
+#include <compare>
+/** Defined if `scru128::id` provides `operator<=>`. */
+#define SCRU128_HAS_THREE_WAY_COMPARISON (1)
+#endif
+
+#if defined(__cpp_lib_format) && __cpp_lib_format >= 201907L
+#include <format>
+/** Defined if `std::formatter` is specialized for `scru128::id`. */
+#define SCRU128_HAS_STD_FORMAT (1)
+#endif
+
+#if defined(__cpp_consteval) && __cpp_consteval >= 201811L
+/**
+ * Expands to `consteval` if supported, so that `_scru128` literals are always
+ * validated at compile time, or to `constexpr` otherwise.
+ *
+ * @private
+ */
+#define SCRU128_CONSTEVAL consteval
+#else
+#define SCRU128_CONSTEVAL constexpr
+#endif
+
+namespace scru128 {
+
+/** @private */
+namespace detail {
+
+/**
+ * Returns the value of the Base36 digit `c` (case-insensitively) or `0xff` if
+ * it is not a digit. This is a `constexpr` counterpart of `SCRU128_DECODE_MAP`.
+ *
+ * @private
+ */
+constexpr std::uint8_t decode_digit(char c) noexcept {
+  if ('0' <= c && c <= '9') {
+    return static_cast<std::uint8_t>(c - '0');
+  } else if ('a' <= c && c <= 'z') {
+    return static_cast<std::uint8_t>(c - 'a' + 10);
+  } else if ('A' <= c && c <= 'Z') {
+    return static_cast<std::uint8_t>(c - 'A' + 10);
+  }
+  return 0xff;
+}
+
+} // namespace detail
+
+/**
+ * Represents a SCRU128 ID as a trivially copyable 16-byte value holding the
+ * same big-endian byte array as the C API, so that `data()` can be passed to
+ * any function of `scru128.h`.
+ *
+ * Comparison operators compare two big-endian 64-bit words instead of bytes.
+ */
+class id {
+public:
+  /** Creates the nil ID (all zero bits). */
+  constexpr id() noexcept : bytes_{} {}
+
+  /**
+   * Creates a SCRU128 ID from a 16-byte big-endian byte array.
+   *
+   * @param bytes A 16-byte byte array that represents a SCRU128 ID.
+   */
+  static constexpr id from_bytes(const std::uint8_t *bytes) noexcept {
+    id x;
+    for (std::size_t i = 0; i < SCRU128_LEN; i++) {
+      x.bytes_[i] = bytes[i];
+    }
+    return x;
+  }
+
+  /**
+   * Creates a SCRU128 ID from two 64-bit words.
+   *
+   * @param hi The most significant 64 bits.
+   * @param lo The least significant 64 bits.
+   */
+  static constexpr id from_u64_pair(std::uint64_t hi,
+                                    std::uint64_t lo) noexcept {
+    id x;
+    for (std::size_t i = 0; i < 8; i++) {
+      x.bytes_[i] = static_cast<std::uint8_t>(hi >> (56 - 8 * i));
+      x.bytes_[8 + i] = static_cast<std::uint8_t>(lo >> (56 - 8 * i));
+    }
+    return x;
+  }
+
+  /**
+   * Creates a SCRU128 ID from field values.
+   *
+   * @param id_out A reference where the created SCRU128 ID is stored.
+   * @param timestamp A 48-bit `timestamp` field value.
+   * @param counter_hi A 24-bit `counter_hi` field value.
+   * @param counter_lo A 24-bit `counter_lo` field value.
+   * @param entropy A 32-bit `entropy` field value.
+   * @return Zero on success or a non-zero integer if any argument is out of the
+   * value range of the field.
+   */
+  static constexpr int try_from_fields(id &id_out, std::uint64_t timestamp,
+                                       std::uint32_t counter_hi,
+                                       std::uint32_t counter_lo,
+                                       std::uint32_t entropy) noexcept {
+    if (timestamp > 0xffffffffffff || counter_hi > 0xffffff ||
+        counter_lo > 0xffffff) {
+      return -1;
+    }
+    id_out = from_u64_pair(timestamp << 16 | counter_hi >> 8,
+                           static_cast<std::uint64_t>(counter_hi) << 56 |
+                               static_cast<std::uint64_t>(counter_lo) << 32 |
+                               entropy);
+    return 0;
+  }
+
+  /**
+   * Creates a SCRU128 ID from field values.
+   *
+   * @throws std::out_of_range if any argument is out of the value range of the
+   * field.
+   */
+  static constexpr id from_fields(std::uint64_t timestamp,
+                                  std::uint32_t counter_hi,
+                                  std::uint32_t counter_lo,
+                                  std::uint32_t entropy) {
+    id x;
+    if (try_from_fields(x, timestamp, counter_hi, counter_lo, entropy) != 0) {
+      throw std::out_of_range("scru128: field value out of range");
+    }
+    return x;
+  }
+
+  /**
+   * Creates a SCRU128 ID from a 25-digit string representation.
+   *
+   * Unlike `scru128_from_str()`, this function does not require `str` to be
+   * null-terminated; it requires `str` to be exactly 25 digits long.
+   *
+   * @param id_out A reference where the created SCRU128 ID is stored.
+   * @param str A 25-digit string representation.
+   * @return Zero on success or a non-zero integer if `str` is not a valid
+   * string representation.
+   */
+  static constexpr int try_from_str(id &id_out, std::string_view str) noexcept {
+    constexpr std::uint64_t BASE_POW_6 = 2176782336; // 36^6
+    if (str.size() != 25) {
+      return -1; // invalid length
+    }
+
+    // follow scru128_from_str(): a leading digit and four 6-digit words
+    // accumulated into 32-bit limbs
+    std::uint32_t limbs[4] = {0, 0, 0, detail::decode_digit(str[0])};
+    if (limbs[3] == 0xff) {
+      return -1; // invalid digit
+    }
+    for (std::size_t i = 1; i < 25; i += 6) {
+      std::uint32_t word = 0;
+      for (std::size_t j = i; j < i + 6; j++) {
+        std::uint8_t digit = detail::decode_digit(str[j]);
+        if (digit == 0xff) {
+          return -1; // invalid digit
+        }
+        word = word * 36 + digit;
+      }
+
+      std::uint64_t carry = word;
+      for (int j = 3; j >= 0; j--) {
+        carry += limbs[j] * BASE_POW_6;
+        limbs[j] = static_cast<std::uint32_t>(carry);
+        carry = carry >> 32;
+      }
+      if (carry > 0) {
+        return -1; // out of 128-bit value range
+      }
+    }
+
+    id_out = from_u64_pair(
+        static_cast<std::uint64_t>(limbs[0]) << 32 | limbs[1],
+        static_cast<std::uint64_t>(limbs[2]) << 32 | limbs[3]);
+    return 0;
+  }
+
+  /**
+   * Creates a SCRU128 ID from a 25-digit string representation.
+   *
+   * @throws std::invalid_argument if `str` is not a valid string
+   * representation.
+   */
+  static constexpr id from_str(std::string_view str) {
+    id x;
+    if (try_from_str(x, str) != 0) {
+      throw std::invalid_argument("scru128: invalid string representation");
+    }
+    return x;
+  }
+
+  /**
+   * Returns the 25-digit canonical string representation followed by a NUL,
+   * which can be passed as a C string by `to_str().data()`.
+   */
+  constexpr std::array<char, SCRU128_STR_LEN> to_str() const noexcept {
+    constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    constexpr std::uint64_t BASE_POW_6 = 2176782336; // 36^6
+
+    std::uint32_t limbs[4] = {static_cast<std::uint32_t>(hi() >> 32),
+                              static_cast<std::uint32_t>(hi()),
+                              static_cast<std::uint32_t>(lo() >> 32),
+                              static_cast<std::uint32_t>(lo())};
+
+    // follow scru128_to_str(): divide 32-bit limbs by 36^6 to take 6-digit
+    // words from right to left, leaving the leading digit in the last limb
+    std::array<char, SCRU128_STR_LEN> str{};
+    for (int i = 19; i > 0; i -= 6) {
+      std::uint64_t rem = 0;
+      for (std::size_t j = 0; j < 4; j++) {
+        std::uint64_t cur = rem << 32 | limbs[j];
+        limbs[j] = static_cast<std::uint32_t>(cur / BASE_POW_6);
+        rem = cur % BASE_POW_6;
+      }
+
+      std::uint32_t word = static_cast<std::uint32_t>(rem);
+      for (int j = i + 5; j >= i; j--) {
+        str[static_cast<std::size_t>(j)] = DIGITS[word % 36];
+        word /= 36;
+      }
+    }
+    str[0] = DIGITS[limbs[3]];
+    str[25] = 0;
+    return str;
+  }
+
+  /** Returns the 25-digit canonical string representation. */
+  std::string to_string() const {
+    return std::string(to_str().data(), SCRU128_STR_LEN - 1);
+  }
+
+  /** Returns the most significant 64 bits. */
+  constexpr std::uint64_t hi() const noexcept { return load_u64(0); }
+
+  /** Returns the least significant 64 bits. */
+  constexpr std::uint64_t lo() const noexcept { return load_u64(8); }
+
+  /** Returns the 48-bit `timestamp` field value. */
+  constexpr std::uint64_t timestamp() const noexcept { return hi() >> 16; }
+
+  /** Returns the 24-bit `counter_hi` field value. */
+  constexpr std::uint32_t counter_hi() const noexcept {
+    return static_cast<std::uint32_t>((hi() & 0xffff) << 8 | lo() >> 56);
+  }
+
+  /** Returns the 24-bit `counter_lo` field value. */
+  constexpr std::uint32_t counter_lo() const noexcept {
+    return static_cast<std::uint32_t>(lo() >> 32) & 0xffffff;
+  }
+
+  /** Returns the 32-bit `entropy` field value. */
+  constexpr std::uint32_t entropy() const noexcept {
+    return static_cast<std::uint32_t>(lo());
+  }
+
+  /** Returns a pointer to the 16-byte big-endian byte array. */
+  constexpr std::uint8_t *data() noexcept { return bytes_; }
+
+  /** Returns a pointer to the 16-byte big-endian byte array. */
+  constexpr const std::uint8_t *data() const noexcept { return bytes_; }
+
+  /** Returns the size in bytes of the binary representation (16 bytes). */
+  static constexpr std::size_t size() noexcept { return SCRU128_LEN; }
+
+  friend constexpr bool operator==(const id &lhs, const id &rhs) noexcept {
+    return lhs.hi() == rhs.hi() && lhs.lo() == rhs.lo();
+  }
+
+#ifdef SCRU128_HAS_THREE_WAY_COMPARISON
+  friend constexpr std::strong_ordering operator<=>(const id &lhs,
+                                                    const id &rhs) noexcept {
+    if (lhs.hi() != rhs.hi()) {
+      return lhs.hi() <=> rhs.hi();
+    }
+    return lhs.lo() <=> rhs.lo();
+  }
+#else
+  friend constexpr bool operator!=(const id &lhs, const id &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+  friend constexpr bool operator<(const id &lhs, const id &rhs) noexcept {
+    return lhs.hi() < rhs.hi() || (lhs.hi() == rhs.hi() && lhs.lo() < rhs.lo());
+  }
+
+  friend constexpr bool operator>(const id &lhs, const id &rhs) noexcept {
+    return rhs < lhs;
+  }
+
+  friend constexpr bool operator<=(const id &lhs, const id &rhs) noexcept {
+    return !(rhs < lhs);
+  }
+
+  friend constexpr bool operator>=(const id &lhs, const id &rhs) noexcept {
+    return !(lhs < rhs);
+  }
+#endif
+
+  friend std::ostream &operator<<(std::ostream &os, const id &x) {
+    return os << x.to_str().data();
+  }
+
+private:
+  /** Loads a big-endian 64-bit word at `offset`. */
+  constexpr std::uint64_t load_u64(std::size_t offset) const noexcept {
+    std::uint64_t n = 0;
+    for (std::size_t i = offset; i < offset + 8; i++) {
+      n = n << 8 | bytes_[i];
+    }
+    return n;
+  }
+
+  std::uint8_t bytes_[SCRU128_LEN];
+};
+
+static_assert(sizeof(id) == SCRU128_LEN, "scru128::id must be 16 bytes");
+
+/**
+ * A clock that returns the current Unix time in milliseconds read from
+ * `std::chrono::system_clock`.
+ */
+struct system_clock {
+  std::uint64_t operator()() const noexcept {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+  }
+};
+
+/**
+ * Adapts a uniform random bit generator (e.g., `std::random_device` or any
+ * engine of `<random>`) to the random number generator interface of
+ * `basic_generator`, which returns a uniformly distributed 32-bit unsigned
+ * integer per call like `arc4random()`.
+ *
+ * An engine whose range is narrower than 32 bits is called repeatedly, and an
+ * engine whose range is not a multiple of a power of two has the excess values
+ * rejected to keep the result unbiased. Both are determined at compile time.
+ *
+ * @note The quality of generated IDs depends on the engine; SCRU128 calls for
+ * a cryptographically strong random number generator.
+ */
+template <class Engine> class urbg_adaptor {
+public:
+  urbg_adaptor() = default;
+
+  /** Creates an adaptor that owns `engine`. */
+  explicit urbg_adaptor(Engine engine) : engine_(std::move(engine)) {}
+
+  std::uint32_t operator()() {
+    std::uint64_t n = 0;
+    for (int i = 0; i < N_DRAWS; i++) {
+      n = n << BITS_PER_DRAW | draw();
+    }
+    return static_cast<std::uint32_t>(n);
+  }
+
+  /** Returns the underlying engine. */
+  Engine &engine() noexcept { return engine_; }
+
+private:
+  static constexpr std::uint64_t RANGE =
+      static_cast<std::uint64_t>(Engine::max() - Engine::min());
+
+  /** Returns the greatest `k` (up to 32) such that `2^k - 1 <= RANGE`. */
+  static constexpr int bits_per_draw() noexcept {
+    int bits = 0;
+    while (bits < 32 && (std::uint64_t{1} << (bits + 1)) - 1 <= RANGE) {
+      bits++;
+    }
+    return bits;
+  }
+
+  static constexpr int BITS_PER_DRAW = bits_per_draw();
+  static constexpr int N_DRAWS = (32 + BITS_PER_DRAW - 1) / BITS_PER_DRAW;
+  static constexpr std::uint64_t MASK =
+      (std::uint64_t{1} << BITS_PER_DRAW) - 1;
+
+  /** True if the lower bits of every engine output are uniform as is. */
+  static constexpr bool IS_DIVISIBLE =
+      RANGE == UINT64_MAX || (RANGE + 1) % (MASK + 1) == 0;
+
+  /** The number of engine outputs accepted if `IS_DIVISIBLE` is false. */
+  static constexpr std::uint64_t LIMIT =
+      IS_DIVISIBLE ? 0 : RANGE + 1 - (RANGE + 1) % (MASK + 1);
+
+  static_assert(BITS_PER_DRAW > 0, "engine must produce at least one bit");
+
+  /** Returns `BITS_PER_DRAW` uniformly distributed bits. */
+  std::uint64_t draw() {
+    for (;;) {
+      std::uint64_t n = static_cast<std::uint64_t>(engine_() - Engine::min());
+      if (IS_DIVISIBLE || n < LIMIT) {
+        return n & MASK;
+      }
+    }
+  }
+
+  Engine engine_;
+};
+
+/**
+ * Represents a SCRU128 ID generator whose clock, random number generator, and
+ * rollback allowance are fixed at compile time, so that the compiler can
+ * inline the clock read and random number draws and fold the constant checks
+ * that the C core functions perform on every call.
+ *
+ * This class implements the same algorithm as
+ * `scru128_generate_or_abort_core()` and `scru128_generate_or_reset_core()`,
+ * including the partitioned mode of `scru128_generator_init_sharded()`, and
+ * produces identical IDs given the same clock readings and random numbers. It
+ * does not call those functions because their random number generator is a
+ * plain function pointer; the `_src` variants accept a context pointer, but
+ * calling through them would still prevent the inlining that this class is
+ * for. Statistics (`SCRU128_ENABLE_STATS`) are not collected.
+ *
+ * @tparam Clock A function object type whose `operator()` returns the current
+ * Unix time in milliseconds, or zero on error.
+ * @tparam Rng A function object type whose `operator()` returns a
+ * (cryptographically strong) random number in the range of 32-bit unsigned
+ * integer, e.g., `urbg_adaptor<std::random_device>`.
+ * @tparam RollbackAllowance The amount of `timestamp` rollback that is
+ * considered significant, in milliseconds.
+ * @attention This class is NOT thread-safe.
+ */
+template <class Clock = system_clock,
+          class Rng = urbg_adaptor<std::random_device>,
+          std::uint64_t RollbackAllowance = 10000>
+class basic_generator {
+  static_assert(RollbackAllowance <= 0xffffffffffff,
+                "RollbackAllowance must be a 48-bit integer");
+
+public:
+  basic_generator() = default;
+
+  /** Creates a generator that owns `clock` and `rng`. */
+  basic_generator(Clock clock, Rng rng)
+      : clock_(std::move(clock)), rng_(std::move(rng)) {}
+
+  /**
+   * Creates a generator that owns `clock` and `rng` in the partitioned mode,
+   * where the upper `shard_bits` bits of the `counter_hi` field of every
+   * generated ID are fixed to `shard`, as `scru128_generator_init_sharded()`
+   * does.
+   *
+   * @throws std::out_of_range if `shard_bits` is greater than 24 or `shard`
+   * does not fit in `shard_bits` bits.
+   */
+  basic_generator(Clock clock, Rng rng, std::uint32_t shard,
+                  std::uint32_t shard_bits)
+      : clock_(std::move(clock)), rng_(std::move(rng)), shard_(shard),
+        shard_bits_(shard_bits) {
+    if (shard_bits > 24 || std::uint64_t{shard} >> shard_bits != 0) {
+      throw std::out_of_range("scru128: shard out of range");
+    }
+  }
+
+  /**
+   * Generates a new SCRU128 ID, or returns an error upon significant timestamp
+   * rollback.
+   *
+   * @param id_out A reference where the generated SCRU128 ID is stored.
+   * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+   * characteristics of generated ID. A negative return code reports an error.
+   */
+  int generate_or_abort(id &id_out) {
+    return generate_or_abort_core(id_out, clock_());
+  }
+
+  /**
+   * Generates a new SCRU128 ID, or resets the generator upon significant
+   * timestamp rollback.
+   *
+   * @param id_out A reference where the generated SCRU128 ID is stored.
+   * @return One of `SCRU128_GENERATOR_STATUS_*` codes that describes the
+   * characteristics of generated ID. A negative return code reports an error.
+   */
+  int generate_or_reset(id &id_out) {
+    std::uint64_t timestamp = clock_();
+    int status = generate_or_abort_core(id_out, timestamp);
+    if (status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT) {
+      // reset state and resume
+      timestamp_ = 0;
+      ts_counter_hi_ = 0;
+      generate_or_abort_core(id_out, timestamp);
+      status = SCRU128_GENERATOR_STATUS_ROLLBACK_RESET;
+    }
+    return status;
+  }
+
+  /**
+   * Generates a new SCRU128 ID, resetting the generator upon significant
+   * timestamp rollback.
+   *
+   * @throws std::runtime_error if the clock returns an invalid timestamp.
+   */
+  id generate() {
+    id x;
+    if (generate_or_reset(x) < 0) {
+      throw std::runtime_error("scru128: clock returned invalid timestamp");
+    }
+    return x;
+  }
+
+  /** Returns the clock. */
+  Clock &clock() noexcept { return clock_; }
+
+  /** Returns the random number generator. */
+  Rng &rng() noexcept { return rng_; }
+
+private:
+  int generate_or_abort_core(id &id_out, std::uint64_t timestamp) {
+    if (timestamp == 0 || timestamp > 0xffffffffffff) {
+      return SCRU128_GENERATOR_STATUS_ERROR;
+    }
+
+    int status = SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP;
+    if (timestamp > timestamp_) {
+      timestamp_ = timestamp;
+      counter_lo_ = rng_() & 0xffffff;
+    } else if (timestamp + RollbackAllowance >= timestamp_) {
+      // go on with previous timestamp if new one is not much smaller
+      counter_lo_++;
+      status = SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+      if (counter_lo_ > 0xffffff) {
+        counter_lo_ = 0;
+        counter_hi_++;
+        status = SCRU128_GENERATOR_STATUS_COUNTER_HI_INC;
+        if ((counter_hi_ & 0xffffff >> shard_bits_) == 0) {
+          counter_hi_ = scru128_shard_counter_hi(shard_, shard_bits_, 0);
+          // increment timestamp at counter overflow
+          timestamp_++;
+          counter_lo_ = rng_() & 0xffffff;
+          status = SCRU128_GENERATOR_STATUS_TIMESTAMP_INC;
+        }
+      }
+    } else {
+      // abort if clock went backwards to unbearable extent
+      return SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT;
+    }
+
+    if (timestamp_ - ts_counter_hi_ >= 1000 || ts_counter_hi_ == 0) {
+      ts_counter_hi_ = timestamp_;
+      counter_hi_ = scru128_shard_counter_hi(shard_, shard_bits_, rng_());
+    }
+
+    if (id::try_from_fields(id_out, timestamp_, counter_hi_, counter_lo_,
+                            rng_()) != 0) {
+      return SCRU128_GENERATOR_STATUS_ERROR;
+    }
+    return status;
+  }
+
+  Clock clock_;
+  Rng rng_;
+  std::uint64_t timestamp_ = 0;
+  std::uint32_t counter_hi_ = 0;
+  std::uint32_t counter_lo_ = 0;
+
+  /** The timestamp at the last renewal of `counter_hi` field. */
+  std::uint64_t ts_counter_hi_ = 0;
+
+  /** The shard ID fixed in the upper `shard_bits_` bits of `counter_hi`. */
+  std::uint32_t shard_ = 0;
+
+  /** The number of the upper bits of `counter_hi` reserved for `shard_`. */
+  std::uint32_t shard_bits_ = 0;
+};
+
+inline namespace literals {
+
+/**
+ * Creates a SCRU128 ID from a 25-digit string literal (e.g.,
+ * `"036z951mhjikzik2gsl81gr7l"_scru128`).
+ *
+ * An invalid literal is a compile-time error where `consteval` is supported or
+ * where the result initializes a `constexpr` variable.
+ */
+SCRU128_CONSTEVAL id operator""_scru128(const char *str, std::size_t len) {
+  return id::from_str(std::string_view(str, len));
+}
+
+} // namespace literals
+
+} // namespace scru128
+
+namespace std {
+
+template <> struct hash<scru128::id> {
+  std::size_t operator()(const scru128::id &x) const noexcept {
+    // `entropy` fills the lower bits with random bits even if `size_t` is
+    // narrower than 64 bits, while the multiplication mixes in `hi`
+    return static_cast<std::size_t>(x.lo() ^ (x.hi() * 0x9e3779b97f4a7c15));
+  }
+};
+
+#ifdef SCRU128_HAS_STD_FORMAT
+/** Formats `scru128::id` as the string representation with string specs. */
+template <>
+struct formatter<scru128::id, char> : formatter<std::string_view, char> {
+  template <class FormatContext>
+  auto format(const scru128::id &x, FormatContext &ctx) const {
+    std::array<char, SCRU128_STR_LEN> str = x.to_str();
+    return formatter<std::string_view, char>::format(
+        std::string_view(str.data(), SCRU128_STR_LEN - 1), ctx);
+  }
+};
+#endif /* #ifdef SCRU128_HAS_STD_FORMAT */
+
+} // namespace std
+
+#endif /* #ifndef SCRU128_HPP_QKZRWNEM */
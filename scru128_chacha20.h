@@ -0,0 +1,258 @@
+/**
+ * @file scru128_chacha20.h
+ *
+ * ChaCha20-based cryptographically secure random number generator for SCRU128
+ * generators
+ *
+ * This header provides a userspace random number generator that feeds the
+ * `arc4random`-style callbacks of `scru128.h` on systems without a fast
+ * `arc4random()`. It produces the ChaCha20 keystream several blocks at a time,
+ * erases the key by replacing it with the first 32 bytes of each new batch of
+ * blocks, and reseeds itself from the system entropy source at a regular
+ * interval.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_CHACHA20_H_QZNDWKTB
+#define SCRU128_CHACHA20_H_QZNDWKTB
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The number of ChaCha20 blocks computed in parallel, which lets compilers map
+ * the block function onto 128-bit SIMD registers.
+ *
+ * @private
+ */
+#define SCRU128_CHACHA20_LANES (4)
+
+/**
+ * The size in bytes of the keystream buffer, which is refilled at once.
+ */
+#define SCRU128_CHACHA20_BUF_LEN (1024)
+
+/**
+ * The number of output bytes after which the generator is reseeded from the
+ * system entropy source.
+ */
+#define SCRU128_CHACHA20_RESEED_INTERVAL (1024 * 1024)
+
+/**
+ * Represents the state of a ChaCha20-based random number generator.
+ *
+ * A zero-filled struct is a valid initial state that seeds itself upon the
+ * first use, so the state may be placed in memory that is zero-filled in child
+ * processes (e.g., by `MADV_WIPEONFORK`) to prevent a forked process from
+ * repeating the parent's output.
+ */
+typedef struct Scru128ChaCha20 {
+  /** @private */
+  uint32_t _key[8];
+
+  /**
+   * The number of unconsumed bytes at the end of `_buf`.
+   *
+   * @private
+   */
+  size_t _n_avail;
+
+  /**
+   * The number of bytes that can be produced before reseeding.
+   *
+   * @private
+   */
+  size_t _n_until_reseed;
+
+  /** @private */
+  uint8_t _buf[SCRU128_CHACHA20_BUF_LEN];
+} Scru128ChaCha20;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @private */
+static inline uint32_t scru128_chacha20_rotl(uint32_t x, int n) {
+  return (x << n) | (x >> (32 - n));
+}
+
+/**
+ * Computes the ChaCha20 quarter round on each lane of `x`.
+ *
+ * @private
+ */
+static inline void scru128_chacha20_quarter_round(
+    uint32_t (*x)[SCRU128_CHACHA20_LANES], int a, int b, int c, int d) {
+  for (int_fast8_t l = 0; l < SCRU128_CHACHA20_LANES; l++) {
+    x[a][l] += x[b][l];
+    x[d][l] = scru128_chacha20_rotl(x[d][l] ^ x[a][l], 16);
+    x[c][l] += x[d][l];
+    x[b][l] = scru128_chacha20_rotl(x[b][l] ^ x[c][l], 12);
+    x[a][l] += x[b][l];
+    x[d][l] = scru128_chacha20_rotl(x[d][l] ^ x[a][l], 8);
+    x[c][l] += x[d][l];
+    x[b][l] = scru128_chacha20_rotl(x[b][l] ^ x[c][l], 7);
+  }
+}
+
+/**
+ * Computes `SCRU128_CHACHA20_LANES` consecutive ChaCha20 blocks as defined in
+ * RFC 8439.
+ *
+ * @param out A `64 * SCRU128_CHACHA20_LANES`-byte byte array where the
+ * keystream is stored.
+ * @param key A 256-bit key as eight little-endian 32-bit words.
+ * @param counter The block counter of the first block.
+ * @param nonce A 96-bit nonce as three little-endian 32-bit words.
+ */
+static inline void scru128_chacha20_blocks(uint8_t *out, const uint32_t *key,
+                                           uint32_t counter,
+                                           const uint32_t *nonce) {
+  uint32_t init[16][SCRU128_CHACHA20_LANES];
+  uint32_t x[16][SCRU128_CHACHA20_LANES];
+  for (int_fast8_t l = 0; l < SCRU128_CHACHA20_LANES; l++) {
+    init[0][l] = 0x61707865;
+    init[1][l] = 0x3320646e;
+    init[2][l] = 0x79622d32;
+    init[3][l] = 0x6b206574;
+    for (int_fast8_t i = 0; i < 8; i++) {
+      init[4 + i][l] = key[i];
+    }
+    init[12][l] = counter + (uint32_t)l;
+    init[13][l] = nonce[0];
+    init[14][l] = nonce[1];
+    init[15][l] = nonce[2];
+  }
+  memcpy(x, init, sizeof(x));
+
+  for (int_fast8_t i = 0; i < 10; i++) {
+    scru128_chacha20_quarter_round(x, 0, 4, 8, 12);
+    scru128_chacha20_quarter_round(x, 1, 5, 9, 13);
+    scru128_chacha20_quarter_round(x, 2, 6, 10, 14);
+    scru128_chacha20_quarter_round(x, 3, 7, 11, 15);
+    scru128_chacha20_quarter_round(x, 0, 5, 10, 15);
+    scru128_chacha20_quarter_round(x, 1, 6, 11, 12);
+    scru128_chacha20_quarter_round(x, 2, 7, 8, 13);
+    scru128_chacha20_quarter_round(x, 3, 4, 9, 14);
+  }
+
+  for (int_fast8_t l = 0; l < SCRU128_CHACHA20_LANES; l++) {
+    for (int_fast8_t i = 0; i < 16; i++) {
+      uint32_t w = x[i][l] + init[i][l];
+      uint8_t *p = out + 64 * l + 4 * i;
+      p[0] = (uint8_t)w;
+      p[1] = (uint8_t)(w >> 8);
+      p[2] = (uint8_t)(w >> 16);
+      p[3] = (uint8_t)(w >> 24);
+    }
+  }
+}
+
+/** Initializes a random number generator struct `rng`. */
+static inline void scru128_chacha20_init(Scru128ChaCha20 *rng) {
+  memset(rng, 0, sizeof(Scru128ChaCha20));
+}
+
+/**
+ * Refills the keystream buffer and replaces the key with the first 32 bytes of
+ * the new keystream.
+ *
+ * @private
+ */
+static inline void scru128_chacha20_refill(Scru128ChaCha20 *rng) {
+  static const uint32_t NONCE[3] = {0, 0, 0};
+  for (int i = 0; i < SCRU128_CHACHA20_BUF_LEN / 64;
+       i += SCRU128_CHACHA20_LANES) {
+    scru128_chacha20_blocks(rng->_buf + 64 * i, rng->_key, (uint32_t)i, NONCE);
+  }
+  for (int_fast8_t i = 0; i < 8; i++) {
+    const uint8_t *p = rng->_buf + 4 * i;
+    rng->_key[i] = (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+                   (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+  }
+  memset(rng->_buf, 0, 32);
+  rng->_n_avail = SCRU128_CHACHA20_BUF_LEN - 32;
+}
+
+/**
+ * Fills a buffer with random bytes.
+ *
+ * @param rng A random number generator state object.
+ * @param buf A byte array where the random bytes are stored.
+ * @param nbytes The number of bytes to generate.
+ * @param getentropy A function pointer to `getentropy()` or a compatible
+ * function that fills a buffer of up to 256 bytes with random bytes from the
+ * system entropy source and returns zero on success, which is called when the
+ * generator needs to be (re)seeded.
+ * @return Zero on success or a non-zero integer if `getentropy` failed.
+ * @attention This function is NOT thread-safe. Use a separate state object per
+ * thread or protect `rng` from concurrent accesses.
+ */
+static inline int scru128_chacha20_buf(Scru128ChaCha20 *rng, void *buf,
+                                       size_t nbytes,
+                                       int (*getentropy)(void *, size_t)) {
+  uint8_t *dst = (uint8_t *)buf;
+  while (nbytes > 0) {
+    if (rng->_n_until_reseed == 0) {
+      uint8_t seed[32];
+      if ((*getentropy)(seed, sizeof(seed)) != 0) {
+        return -1;
+      }
+      for (int_fast8_t i = 0; i < 8; i++) {
+        const uint8_t *p = seed + 4 * i;
+        rng->_key[i] ^= (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+                        (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+      }
+      memset(seed, 0, sizeof(seed));
+      memset(rng->_buf, 0, sizeof(rng->_buf));
+      rng->_n_avail = 0;
+      rng->_n_until_reseed = SCRU128_CHACHA20_RESEED_INTERVAL;
+    }
+    if (rng->_n_avail == 0) {
+      scru128_chacha20_refill(rng);
+    }
+
+    size_t n = nbytes;
+    if (n > rng->_n_avail) {
+      n = rng->_n_avail;
+    }
+    if (n > rng->_n_until_reseed) {
+      n = rng->_n_until_reseed;
+    }
+
+    // copy and wipe consumed bytes so that they cannot be reproduced later
+    uint8_t *src = rng->_buf + SCRU128_CHACHA20_BUF_LEN - rng->_n_avail;
+    memcpy(dst, src, n);
+    memset(src, 0, n);
+    rng->_n_avail -= n;
+    rng->_n_until_reseed -= n;
+    dst += n;
+    nbytes -= n;
+  }
+  return 0;
+}
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* #ifndef SCRU128_CHACHA20_H_QZNDWKTB */
@@ -0,0 +1,540 @@
+/**
+ * @file scru128_clock.h
+ *
+ * Millisecond time sources for SCRU128 generators on POSIX systems
+ *
+ * SCRU128 needs the current Unix time only at millisecond resolution, so a
+ * generator that mints millions of IDs per second can afford a cheaper clock
+ * than `clock_gettime(CLOCK_REALTIME, ...)` per ID. This header provides a
+ * pluggable clock hook (`Scru128Clock`) and several implementations of it:
+ *
+ * - `scru128_clock_realtime()`: `CLOCK_REALTIME`, the reference.
+ * - `scru128_clock_realtime_coarse()`: `CLOCK_REALTIME_COARSE`, which skips
+ *   reading the hardware counter at the cost of a few milliseconds of lag.
+ * - `Scru128Ticker`: a background thread that publishes the current time in an
+ *   atomic variable, making a read a single memory load. Available (as is
+ *   `Scru128AnchoredClock`) if `SCRU128_HAS_ATOMIC_CLOCK` is defined, i.e.,
+ *   with the `__atomic` builtins of GCC and Clang.
+ * - `Scru128TscClock`: extrapolation from the x86 time-stamp counter calibrated
+ *   against `CLOCK_REALTIME`.
+ * - `Scru128AnchoredClock`: `CLOCK_MONOTONIC` anchored to `CLOCK_REALTIME`,
+ *   which slews toward the system clock instead of jumping backward.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_CLOCK_H_MCFXEPLR
+#define SCRU128_CLOCK_H_MCFXEPLR
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Represents a source of the current Unix time in milliseconds that carries its
+ * own context, such as a ticker thread or calibration data.
+ */
+typedef struct Scru128Clock {
+  /** An opaque pointer passed to `now` as the argument. */
+  void *ctx;
+
+  /**
+   * A function that returns the current Unix time in milliseconds, or zero on
+   * error.
+   */
+  uint64_t (*now)(void *ctx);
+} Scru128Clock;
+
+#if defined(__GNUC__) && defined(__ATOMIC_ACQ_REL)
+/**
+ * Defined if the compiler supports the `__atomic` builtins required by the
+ * clocks shared among threads (`Scru128Ticker` and `Scru128AnchoredClock`).
+ */
+#define SCRU128_HAS_ATOMIC_CLOCK (1)
+
+/**
+ * Represents a background thread that publishes the current Unix time in
+ * milliseconds.
+ *
+ * A new ticker must be started by `scru128_ticker_start()` before use.
+ */
+typedef struct Scru128Ticker {
+  /**
+   * The latest Unix time in milliseconds, which is read and written atomically.
+   *
+   * @private
+   */
+  uint64_t _timestamp;
+
+  /**
+   * A flag that keeps the ticker thread running, which is read and written
+   * atomically.
+   *
+   * @private
+   */
+  int _running;
+
+  /** @private */
+  pthread_t _thread;
+} Scru128Ticker;
+
+/**
+ * Represents a clock that never goes backward, which derives the Unix time
+ * from `CLOCK_MONOTONIC` plus an offset to `CLOCK_REALTIME` sampled at
+ * initialization and gradually slewed toward the system clock afterwards.
+ *
+ * A new clock must be initialized by `scru128_anchored_clock_init()` before
+ * use.
+ */
+typedef struct Scru128AnchoredClock {
+  /**
+   * The offset in nanoseconds from `CLOCK_MONOTONIC` to the Unix time, which
+   * is read and written atomically.
+   *
+   * @private
+   */
+  int64_t _offset_ns;
+
+  /**
+   * The `CLOCK_MONOTONIC` time in nanoseconds at the last synchronization.
+   *
+   * @private
+   */
+  uint64_t _last_sync_ns;
+
+  /**
+   * The `CLOCK_MONOTONIC` time in nanoseconds at which the next synchronization
+   * is due, which is read and written atomically.
+   *
+   * @private
+   */
+  uint64_t _next_sync_ns;
+
+  /**
+   * The greatest Unix time in milliseconds returned, which is read and written
+   * atomically.
+   *
+   * @private
+   */
+  uint64_t _last_ms;
+
+  /**
+   * The maximum rate in parts per million at which the offset is reduced.
+   *
+   * @private
+   */
+  uint32_t _max_slew_ppm;
+} Scru128AnchoredClock;
+#endif /* #if defined(__GNUC__) && defined(__ATOMIC_ACQ_REL) */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/**
+ * Defined if the target supports the time-stamp counter clock
+ * (`Scru128TscClock`).
+ */
+#define SCRU128_HAS_TSC_CLOCK (1)
+
+/**
+ * Represents a clock that extrapolates the Unix time from the x86 time-stamp
+ * counter (TSC).
+ *
+ * A new clock must be initialized by `scru128_tsc_clock_init()` before use.
+ * Once initialized, the clock is read-only and can be shared among threads.
+ *
+ * @attention The clock assumes an invariant TSC that ticks at a constant rate
+ * and is synchronized across cores, which is the case with most x86 processors
+ * since around 2008. It follows the rate measured at calibration and does not
+ * track later adjustments of the system clock, so it should be recalibrated
+ * periodically (e.g., every minute) to stay close to `CLOCK_REALTIME`.
+ */
+typedef struct Scru128TscClock {
+  /**
+   * The TSC value at calibration.
+   *
+   * @private
+   */
+  uint64_t _tsc_base;
+
+  /**
+   * The Unix time in nanoseconds at calibration.
+   *
+   * @private
+   */
+  uint64_t _ns_base;
+
+  /**
+   * The nanoseconds per TSC tick in 40.24 fixed-point format.
+   *
+   * @private
+   */
+  uint64_t _ns_per_tick;
+} Scru128TscClock;
+#endif /* #if defined(__GNUC__) && (defined(__x86_64__) || ... */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returns the current Unix time in milliseconds obtained from `clock`. */
+static inline uint64_t scru128_clock_now(const Scru128Clock *clock) {
+  return (*clock->now)(clock->ctx);
+}
+
+/**
+ * Returns the Unix time in milliseconds read from a POSIX clock, or zero on
+ * error.
+ *
+ * @private
+ */
+static inline uint64_t scru128_clock_read(clockid_t clock_id) {
+  struct timespec tp;
+  if (clock_gettime(clock_id, &tp) != 0) {
+    return 0; // rejected by generator functions
+  }
+  return (uint64_t)tp.tv_sec * 1000 + (uint64_t)tp.tv_nsec / 1000000;
+}
+
+/**
+ * Returns the current Unix time in milliseconds read from `CLOCK_REALTIME`, or
+ * zero on error.
+ *
+ * @param ctx Unused; present to match the `Scru128Clock` interface.
+ */
+static inline uint64_t scru128_clock_realtime(void *ctx) {
+  (void)ctx;
+  return scru128_clock_read(CLOCK_REALTIME);
+}
+
+/**
+ * Returns the current Unix time in milliseconds read from
+ * `CLOCK_REALTIME_COARSE`, or zero on error.
+ *
+ * The coarse clock returns the time recorded at the last timer interrupt
+ * without reading the hardware counter, so it lags behind `CLOCK_REALTIME` by
+ * up to one scheduler tick (typically 1-4 milliseconds). This function falls
+ * back to `CLOCK_REALTIME` where the coarse clock is unavailable.
+ *
+ * @param ctx Unused; present to match the `Scru128Clock` interface.
+ */
+static inline uint64_t scru128_clock_realtime_coarse(void *ctx) {
+  (void)ctx;
+#ifdef CLOCK_REALTIME_COARSE
+  return scru128_clock_read(CLOCK_REALTIME_COARSE);
+#else
+  return scru128_clock_read(CLOCK_REALTIME);
+#endif
+}
+
+#ifdef SCRU128_HAS_ATOMIC_CLOCK
+/**
+ * Runs the ticker thread, which updates the published time at every
+ * millisecond boundary until stopped.
+ *
+ * @private
+ */
+static inline void *scru128_ticker_main(void *arg) {
+  Scru128Ticker *ticker = (Scru128Ticker *)arg;
+  while (__atomic_load_n(&ticker->_running, __ATOMIC_ACQUIRE)) {
+    struct timespec tp;
+    if (clock_gettime(CLOCK_REALTIME, &tp) == 0) {
+      uint64_t timestamp =
+          (uint64_t)tp.tv_sec * 1000 + (uint64_t)tp.tv_nsec / 1000000;
+      __atomic_store_n(&ticker->_timestamp, timestamp, __ATOMIC_RELEASE);
+
+      // sleep until the next millisecond boundary
+      tp.tv_sec = 0;
+      tp.tv_nsec = 1000000 - tp.tv_nsec % 1000000;
+    } else {
+      tp.tv_sec = 0;
+      tp.tv_nsec = 1000000;
+    }
+    nanosleep(&tp, NULL);
+  }
+  return NULL;
+}
+
+/**
+ * Starts a ticker thread.
+ *
+ * The published time is valid as soon as this function returns. A ticker lags
+ * behind `CLOCK_REALTIME` by the scheduling latency of the ticker thread,
+ * which is usually well below a millisecond but may grow under heavy load.
+ *
+ * @param ticker A ticker object to start.
+ * @return Zero on success or a non-zero integer if the thread could not be
+ * created.
+ */
+static inline int scru128_ticker_start(Scru128Ticker *ticker) {
+  ticker->_timestamp = scru128_clock_read(CLOCK_REALTIME);
+  ticker->_running = 1;
+  if (pthread_create(&ticker->_thread, NULL, &scru128_ticker_main, ticker) !=
+      0) {
+    ticker->_running = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Stops a ticker thread and waits for it to finish.
+ *
+ * @attention The ticker must not be read after this function is called.
+ */
+static inline void scru128_ticker_stop(Scru128Ticker *ticker) {
+  __atomic_store_n(&ticker->_running, 0, __ATOMIC_RELEASE);
+  pthread_join(ticker->_thread, NULL);
+}
+
+/**
+ * Returns the Unix time in milliseconds last published by a ticker, or zero on
+ * error.
+ *
+ * This function is thread-safe and reads a single atomic variable.
+ *
+ * @param ticker A pointer to a started `Scru128Ticker`, typed as `void *` to
+ * match the `Scru128Clock` interface.
+ */
+static inline uint64_t scru128_ticker_now(void *ticker) {
+  return __atomic_load_n(&((Scru128Ticker *)ticker)->_timestamp,
+                         __ATOMIC_ACQUIRE);
+}
+
+/**
+ * The interval in nanoseconds at which `Scru128AnchoredClock` compares itself
+ * with `CLOCK_REALTIME`.
+ *
+ * @private
+ */
+#define SCRU128_ANCHORED_CLOCK_SYNC_INTERVAL (1000000000)
+
+/**
+ * Reads `CLOCK_MONOTONIC` and `CLOCK_REALTIME` back to back in nanoseconds.
+ *
+ * @private
+ */
+static inline int scru128_anchored_clock_sample(uint64_t *mono_ns_out,
+                                                uint64_t *real_ns_out) {
+  struct timespec mono, real;
+  if (clock_gettime(CLOCK_MONOTONIC, &mono) != 0 ||
+      clock_gettime(CLOCK_REALTIME, &real) != 0) {
+    return -1;
+  }
+  *mono_ns_out = (uint64_t)mono.tv_sec * 1000000000 + (uint64_t)mono.tv_nsec;
+  *real_ns_out = (uint64_t)real.tv_sec * 1000000000 + (uint64_t)real.tv_nsec;
+  return 0;
+}
+
+/**
+ * Moves the offset of an anchored clock toward the one observed between
+ * `mono_ns` and `real_ns`.
+ *
+ * A forward discrepancy is corrected at once because it never breaks the order
+ * of timestamps, while a backward one (e.g., caused by an NTP step) is reduced
+ * by at most `max_slew_ppm` parts per million of the monotonic time elapsed
+ * since the last synchronization.
+ *
+ * @private
+ */
+static inline void scru128_anchored_clock_sync(Scru128AnchoredClock *clock,
+                                               uint64_t mono_ns,
+                                               uint64_t real_ns) {
+  int64_t offset = __atomic_load_n(&clock->_offset_ns, __ATOMIC_ACQUIRE);
+  int64_t diff = (int64_t)(real_ns - mono_ns) - offset;
+  if (diff < 0) {
+    uint64_t elapsed = mono_ns - clock->_last_sync_ns;
+    int64_t max_slew =
+        (int64_t)(elapsed / 1000000 * clock->_max_slew_ppm +
+                  elapsed % 1000000 * clock->_max_slew_ppm / 1000000);
+    diff = diff < -max_slew ? -max_slew : diff;
+  }
+  __atomic_store_n(&clock->_offset_ns, offset + diff, __ATOMIC_RELEASE);
+  clock->_last_sync_ns = mono_ns;
+}
+
+/**
+ * Initializes an anchored clock with the current offset from `CLOCK_MONOTONIC`
+ * to `CLOCK_REALTIME`.
+ *
+ * @param clock An anchored clock object to initialize.
+ * @param max_slew_ppm The maximum rate in parts per million at which the clock
+ * slows down to catch up with a system clock stepped backward. A suggested
+ * value is `500`, the maximum slew rate of NTP. The clock stays ahead of the
+ * system clock until it catches up, which takes `2000` seconds per second of
+ * backward step at the suggested rate.
+ * @return Zero on success or a non-zero integer if the system clocks could not
+ * be read.
+ * @attention This function is NOT thread-safe. The clock must not be shared
+ * with other threads until initialized.
+ */
+static inline int scru128_anchored_clock_init(Scru128AnchoredClock *clock,
+                                              uint32_t max_slew_ppm) {
+  uint64_t mono_ns, real_ns;
+  if (scru128_anchored_clock_sample(&mono_ns, &real_ns) != 0) {
+    return -1;
+  }
+  clock->_offset_ns = (int64_t)(real_ns - mono_ns);
+  clock->_last_sync_ns = mono_ns;
+  clock->_next_sync_ns = mono_ns + SCRU128_ANCHORED_CLOCK_SYNC_INTERVAL;
+  clock->_last_ms = 0;
+  clock->_max_slew_ppm = max_slew_ppm;
+  return 0;
+}
+
+/**
+ * Returns the current Unix time in milliseconds from an anchored clock, or
+ * zero on error.
+ *
+ * The returned value never decreases, even across threads, so a generator fed
+ * by this clock falls into the rollback path only if the clock itself is
+ * reinitialized. The clock reads only `CLOCK_MONOTONIC` in most calls and
+ * compares itself with `CLOCK_REALTIME` once a second; a forward step of the
+ * system clock is followed within a second, while a backward step is slewed
+ * out gradually.
+ *
+ * This function is thread-safe.
+ *
+ * @param clock A pointer to an initialized `Scru128AnchoredClock`, typed as
+ * `void *` to match the `Scru128Clock` interface.
+ */
+static inline uint64_t scru128_anchored_clock_now(void *clock) {
+  Scru128AnchoredClock *c = (Scru128AnchoredClock *)clock;
+  uint64_t next_sync = __atomic_load_n(&c->_next_sync_ns, __ATOMIC_ACQUIRE);
+  struct timespec tp;
+  if (clock_gettime(CLOCK_MONOTONIC, &tp) != 0) {
+    return 0; // rejected by generator functions
+  }
+  uint64_t mono_ns = (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
+
+  // let a single thread synchronize the offset when due
+  uint64_t real_ns;
+  if (mono_ns >= next_sync &&
+      __atomic_compare_exchange_n(
+          &c->_next_sync_ns, &next_sync,
+          mono_ns + SCRU128_ANCHORED_CLOCK_SYNC_INTERVAL, 0, __ATOMIC_ACQ_REL,
+          __ATOMIC_ACQUIRE) &&
+      scru128_anchored_clock_sample(&mono_ns, &real_ns) == 0) {
+    scru128_anchored_clock_sync(c, mono_ns, real_ns);
+  }
+
+  int64_t offset = __atomic_load_n(&c->_offset_ns, __ATOMIC_ACQUIRE);
+  uint64_t timestamp = (mono_ns + (uint64_t)offset) / 1000000;
+
+  // never return a smaller value than returned before to any thread
+  uint64_t last = __atomic_load_n(&c->_last_ms, __ATOMIC_ACQUIRE);
+  while (last < timestamp &&
+         !__atomic_compare_exchange_n(&c->_last_ms, &last, timestamp, 1,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+  }
+  return last < timestamp ? timestamp : last;
+}
+#endif /* #ifdef SCRU128_HAS_ATOMIC_CLOCK */
+
+#ifdef SCRU128_HAS_TSC_CLOCK
+/**
+ * Returns the Unix time in nanoseconds read from `CLOCK_REALTIME` along with
+ * the TSC value read at the same moment.
+ *
+ * @private
+ */
+static inline int scru128_tsc_clock_sample(uint64_t *ns_out,
+                                           uint64_t *tsc_out) {
+  struct timespec tp;
+  uint64_t before = __builtin_ia32_rdtsc();
+  if (clock_gettime(CLOCK_REALTIME, &tp) != 0) {
+    return -1;
+  }
+  uint64_t after = __builtin_ia32_rdtsc();
+  *ns_out = (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
+  *tsc_out = before + (after - before) / 2;
+  return 0;
+}
+
+/**
+ * Initializes a TSC clock by measuring the TSC rate against `CLOCK_REALTIME`.
+ *
+ * This function blocks the calling thread for `calibration_ms` milliseconds; a
+ * longer calibration period yields a more accurate rate. A clock can be
+ * recalibrated by calling this function again, which is NOT thread-safe.
+ *
+ * @param clock A TSC clock object to initialize.
+ * @param calibration_ms The calibration period in milliseconds. A suggested
+ * value is `10`.
+ * @return Zero on success or a non-zero integer if the system clock could not
+ * be read or the TSC did not advance.
+ */
+static inline int scru128_tsc_clock_init(Scru128TscClock *clock,
+                                         uint32_t calibration_ms) {
+  uint64_t ns0, tsc0, ns1, tsc1;
+  if (scru128_tsc_clock_sample(&ns0, &tsc0) != 0) {
+    return -1;
+  }
+  struct timespec tp;
+  tp.tv_sec = calibration_ms / 1000;
+  tp.tv_nsec = (long)(calibration_ms % 1000) * 1000000;
+  nanosleep(&tp, NULL);
+  if (scru128_tsc_clock_sample(&ns1, &tsc1) != 0 || tsc1 <= tsc0 ||
+      ns1 <= ns0) {
+    return -1;
+  }
+
+  clock->_tsc_base = tsc1;
+  clock->_ns_base = ns1;
+  clock->_ns_per_tick = ((ns1 - ns0) << 24) / (tsc1 - tsc0);
+  return 0;
+}
+
+/**
+ * Returns the current Unix time in milliseconds extrapolated from the TSC.
+ *
+ * This function is thread-safe and issues no system call.
+ *
+ * @param clock A pointer to an initialized `Scru128TscClock`, typed as
+ * `void *` to match the `Scru128Clock` interface.
+ */
+static inline uint64_t scru128_tsc_clock_now(void *clock) {
+  const Scru128TscClock *c = (const Scru128TscClock *)clock;
+  uint64_t ticks = __builtin_ia32_rdtsc() - c->_tsc_base;
+  // multiply 64-bit ticks by 40.24 fixed-point rate without overflow
+  uint64_t ns = (ticks >> 24) * c->_ns_per_tick +
+                (((ticks & 0xffffff) * c->_ns_per_tick) >> 24);
+  return (c->_ns_base + ns) / 1000000;
+}
+#endif /* #ifdef SCRU128_HAS_TSC_CLOCK */
+
+/**
+ * Replaces the clock used by the high-level generator functions.
+ *
+ * @param clock A clock object to use, which is copied by this function. The
+ * object pointed to by `clock->ctx` (e.g., a started `Scru128Ticker`) must
+ * remain valid while the high-level generator functions are in use.
+ * @note This header does not provide a concrete implementation of this
+ * function, so platform integrations have to implement it by calling
+ * `scru128_clock_now()` with the stored clock wherever they obtain the current
+ * `timestamp`, as all the platform examples in this repository do.
+ * @attention This function is NOT thread-safe. Call it before any thread starts
+ * generating IDs.
+ */
+void scru128_set_clock(const Scru128Clock *clock);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* #ifndef SCRU128_CLOCK_H_MCFXEPLR */
@@ -0,0 +1,933 @@
+/**
+ * @file scru128_codec.h
+ *
+ * Block codec for sorted columns of SCRU128 IDs
+ *
+ * Sorted SCRU128 IDs are highly redundant: `timestamp` changes slowly, and
+ * `counter_hi` and `counter_lo` mostly stay the same or increase by one from
+ * an ID to the next. This header encodes up to `SCRU128_CODEC_BLOCK_LEN` IDs
+ * into a self-contained block that stores the first ID as is and the rest as
+ * four columns of 32-bit deltas and a column of raw `entropy`:
+ *
+ * - Deltas of the upper 16 bits of `timestamp`.
+ * - Deltas of the lower 32 bits of `timestamp` modulo 2^32.
+ * - `counter_hi` deltas modulo 2^24.
+ * - `counter_lo` deltas modulo 2^24.
+ *
+ * Splitting `timestamp` keeps every value and running sum in 32 bits, and the
+ * upper half usually costs no more than its header because it rarely changes.
+ *
+ * Each delta column holds 128 slots, where slot `i` is the delta from ID
+ * `i - 1` to ID `i` (slot 0 and the slots past the last ID are zero). The
+ * slots are bit-packed at the single width that minimizes the column size
+ * after subtracting the minimum delta (frame of reference), and the few values
+ * that do not fit in the width (e.g., `counter_lo` reset by a new `timestamp`)
+ * have their upper bits stored separately as exceptions. The packing is
+ * vertical across four interleaved 32-bit lanes: slot `i` belongs to lane
+ * `i % 4`, and each lane packs its 32 slots in order into `w` words, so a
+ * single 16-byte load yields a word of each lane and a shift and a mask
+ * extract four consecutive slots at once. On x86-64, SSE2 unpacks the slots
+ * and turns them into fields by a vector prefix sum; elsewhere, scalar code
+ * reads the same layout.
+ *
+ * A block starts with its size and first ID, so that a reader can skip to or
+ * binary-search blocks without decoding them, and the `timestamp` columns come
+ * first, so that `scru128_codec_filter_block()` and
+ * `scru128_codec_count_range()` select IDs by `timestamp` without decoding the
+ * other columns or rebuilding IDs.
+ *
+ * Block layout (multi-byte integers are little-endian unless noted):
+ *
+ * - 2 bytes: the size of the block in bytes.
+ * - 1 byte: the number of IDs `n` (1 to `SCRU128_CODEC_BLOCK_LEN`).
+ * - 16 bytes: the first ID.
+ * - Four delta columns, each consisting of:
+ *   - 4 bytes: the frame of reference (minimum delta).
+ *   - 1 byte: the bit width `w` (0 to 32).
+ *   - 1 byte: the number of exceptions `e`.
+ *   - `16 * w` bytes: `4 * w` 32-bit words, where word `4 * k + l` holds bits
+ *     `32 * k` to `32 * k + 31` of lane `l`, a concatenation of the lower `w`
+ *     bits of the deltas minus the frame of reference from the least
+ *     significant bit.
+ *   - `e` times: 1 byte of slot index and LEB128 of the upper bits (above the
+ *     lower `w` bits) of the delta minus the frame of reference.
+ * - `4 * (n - 1)` bytes: the `entropy` of the second and later IDs
+ *   (big-endian).
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_CODEC_H_PLXGUBNR
+#define SCRU128_CODEC_H_PLXGUBNR
+
+#include "scru128.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** The maximum number of IDs in a block (128 IDs). */
+#define SCRU128_CODEC_BLOCK_LEN (128)
+
+/**
+ * The maximum size in bytes of an encoded block, which is reached when no
+ * delta column is compressible.
+ */
+#define SCRU128_CODEC_MAX_BLOCK_SIZE                                           \
+  (19 + 4 * (6 + 4 * SCRU128_CODEC_BLOCK_LEN) +                                \
+   4 * (SCRU128_CODEC_BLOCK_LEN - 1))
+
+/**
+ * Returns the maximum size in bytes of `n` IDs encoded by
+ * `scru128_codec_encode()`.
+ */
+#define SCRU128_CODEC_MAX_ENCODED_SIZE(n)                                      \
+  (((n) + SCRU128_CODEC_BLOCK_LEN - 1) / SCRU128_CODEC_BLOCK_LEN *             \
+   SCRU128_CODEC_MAX_BLOCK_SIZE)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Writes `value` in LEB128 and returns the number of bytes written.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_put_varint(uint8_t *out, uint64_t value) {
+  size_t len = 0;
+  while (value >= 0x80) {
+    out[len++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[len++] = (uint8_t)value;
+  return len;
+}
+
+/**
+ * Reads a LEB128 integer of up to 56 bits and returns the number of bytes read,
+ * or zero if the input is truncated or malformed.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_get_varint(const uint8_t *in, size_t in_len,
+                                              uint64_t *value_out) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < in_len && i < 8; i++) {
+    value |= (uint64_t)(in[i] & 0x7f) << (7 * i);
+    if (in[i] < 0x80) {
+      *value_out = value;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Returns the number of bits needed to represent `value`.
+ *
+ * @private
+ */
+static inline int scru128_codec_bit_len(uint64_t value) {
+  int len = 0;
+  while (value >> len != 0) {
+    len++;
+  }
+  return len;
+}
+
+/**
+ * Returns the size in bytes of `value` in LEB128.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_varint_len(uint64_t value) {
+  int bits = scru128_codec_bit_len(value);
+  return bits == 0 ? 1 : (size_t)(bits + 6) / 7;
+}
+
+/**
+ * Reads a little-endian 32-bit integer.
+ *
+ * @private
+ */
+static inline uint32_t scru128_codec_get_u32(const uint8_t *in) {
+  return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 |
+         (uint32_t)in[3] << 24;
+}
+
+/**
+ * Unpacks the 128 slots of `width` (1 to 32) bits from the lane-interleaved
+ * words of a column.
+ *
+ * @private
+ */
+static inline void scru128_codec_unpack_scalar(const uint8_t *packed,
+                                               int width,
+                                               uint32_t *values_out) {
+  uint32_t mask = 0xffffffff >> (32 - width);
+  for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+    int bit = i / 4 * width, shift = bit % 32;
+    const uint8_t *p = packed + 4 * (bit / 32 * 4 + i % 4);
+    uint64_t word = scru128_codec_get_u32(p);
+    if (shift + width > 32) {
+      word |= (uint64_t)scru128_codec_get_u32(p + 16) << 32;
+    }
+    values_out[i] = (uint32_t)(word >> shift) & mask;
+  }
+}
+
+/**
+ * Adds `base` to each of the 128 slots and replaces each slot with the running
+ * sum from `init` to the slot.
+ *
+ * @private
+ */
+static inline void scru128_codec_prefix_sum_scalar(uint32_t *values,
+                                                   uint32_t base,
+                                                   uint32_t init) {
+  uint32_t acc = init;
+  for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+    acc += values[i] + base;
+    values[i] = acc;
+  }
+}
+
+/**
+ * Sets bit `i % 64` of `bits_out[i / 64]` if the timestamp `hi[i] << 32 |
+ * lo[i]` of slot `i` is within `[ts_min, ts_max]` and clears it otherwise.
+ *
+ * @private
+ */
+static inline void scru128_codec_match_scalar(const uint32_t *hi,
+                                              const uint32_t *lo,
+                                              uint64_t ts_min, uint64_t ts_max,
+                                              uint64_t *bits_out) {
+  bits_out[0] = bits_out[1] = 0;
+  for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+    uint64_t timestamp = (uint64_t)hi[i] << 32 | lo[i];
+    if (timestamp >= ts_min && timestamp <= ts_max) {
+      bits_out[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+  }
+}
+
+/**
+ * Computes the running sums of `scru128_codec_prefix_sum_scalar()` without
+ * storing them, setting bit `i % 64` of `bits_out[i / 64]` if the sum of slot
+ * `i` is within `[min, max]` and clearing it otherwise.
+ *
+ * @private
+ */
+static inline void scru128_codec_scan_scalar(const uint32_t *values,
+                                             uint32_t base, uint32_t init,
+                                             uint32_t min, uint32_t max,
+                                             uint64_t *bits_out) {
+  uint32_t acc = init;
+  bits_out[0] = bits_out[1] = 0;
+  for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+    acc += values[i] + base;
+    if (acc >= min && acc <= max) {
+      bits_out[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+  }
+}
+
+#ifdef SCRU128_HAS_X86_SIMD
+/**
+ * SSE2 version of `scru128_codec_unpack_scalar()` that extracts four slots,
+ * one from each lane, per shift and mask.
+ *
+ * @private
+ */
+static inline void scru128_codec_unpack_sse2(const uint8_t *packed, int width,
+                                             uint32_t *values_out) {
+  const __m128i *in = (const __m128i *)packed;
+  __m128i *out = (__m128i *)values_out;
+  __m128i mask = _mm_set1_epi32((int)(0xffffffff >> (32 - width)));
+  __m128i word = _mm_loadu_si128(in);
+  int shift = 0;
+  for (int row = 0; row < SCRU128_CODEC_BLOCK_LEN / 4; row++) {
+    __m128i v = _mm_srl_epi32(word, _mm_cvtsi32_si128(shift));
+    shift += width;
+    // the last row ends exactly at the end of the last word
+    if (shift >= 32 && row < SCRU128_CODEC_BLOCK_LEN / 4 - 1) {
+      word = _mm_loadu_si128(++in);
+      shift -= 32;
+      __m128i count = _mm_cvtsi32_si128(width - shift);
+      v = _mm_or_si128(v, _mm_sll_epi32(word, count));
+    }
+    _mm_storeu_si128(out + row, _mm_and_si128(v, mask));
+  }
+}
+
+/**
+ * SSE2 version of `scru128_codec_prefix_sum_scalar()` that sums four slots at
+ * a time by two shifts and adds within a vector.
+ *
+ * @private
+ */
+static inline void scru128_codec_prefix_sum_sse2(uint32_t *values,
+                                                 uint32_t base, uint32_t init) {
+  __m128i *p = (__m128i *)values;
+  __m128i b = _mm_set1_epi32((int)base);
+  __m128i acc = _mm_set1_epi32((int)init);
+  for (int row = 0; row < SCRU128_CODEC_BLOCK_LEN / 4; row++) {
+    __m128i v = _mm_add_epi32(_mm_loadu_si128(p + row), b);
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    _mm_storeu_si128(p + row, _mm_add_epi32(acc, v));
+    // carry the total of the row, keeping a single add on the critical path
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(v, 0xff));
+  }
+}
+
+/**
+ * Packs the comparison results of 16 slots in four vectors into 16 bits.
+ *
+ * @private
+ */
+static inline int scru128_codec_movemask_sse2(const __m128i *masks) {
+  return _mm_movemask_epi8(
+      _mm_packs_epi16(_mm_packs_epi32(masks[0], masks[1]),
+                      _mm_packs_epi32(masks[2], masks[3])));
+}
+
+/**
+ * SSE2 version of `scru128_codec_match_scalar()` that compares the 32-bit
+ * halves of four timestamps at a time.
+ *
+ * @private
+ */
+static inline void scru128_codec_match_sse2(const uint32_t *hi,
+                                            const uint32_t *lo, uint64_t ts_min,
+                                            uint64_t ts_max,
+                                            uint64_t *bits_out) {
+  // flip the sign bits to compare unsigned integers by signed comparisons
+  const __m128i sign = _mm_set1_epi32((int)0x80000000);
+  const __m128i min_hi = _mm_set1_epi32((int)((ts_min >> 32) ^ 0x80000000));
+  const __m128i min_lo = _mm_set1_epi32((int)((uint32_t)ts_min ^ 0x80000000));
+  const __m128i max_hi = _mm_set1_epi32((int)((ts_max >> 32) ^ 0x80000000));
+  const __m128i max_lo = _mm_set1_epi32((int)((uint32_t)ts_max ^ 0x80000000));
+  uint16_t bits[SCRU128_CODEC_BLOCK_LEN / 16];
+  for (int group = 0; group < SCRU128_CODEC_BLOCK_LEN / 16; group++) {
+    __m128i match[4];
+    for (int k = 0; k < 4; k++) {
+      int row = 4 * group + k;
+      __m128i h = _mm_xor_si128(_mm_loadu_si128((const __m128i *)hi + row),
+                                sign);
+      __m128i l = _mm_xor_si128(_mm_loadu_si128((const __m128i *)lo + row),
+                                sign);
+      __m128i ge = _mm_or_si128(_mm_cmpgt_epi32(h, min_hi),
+                                _mm_andnot_si128(_mm_cmpgt_epi32(min_lo, l),
+                                                 _mm_cmpeq_epi32(h, min_hi)));
+      __m128i le = _mm_or_si128(_mm_cmpgt_epi32(max_hi, h),
+                                _mm_andnot_si128(_mm_cmpgt_epi32(l, max_lo),
+                                                 _mm_cmpeq_epi32(h, max_hi)));
+      match[k] = _mm_and_si128(ge, le);
+    }
+    bits[group] = (uint16_t)scru128_codec_movemask_sse2(match);
+  }
+  memcpy(bits_out, bits, sizeof(bits)); // x86 is little-endian
+}
+
+/**
+ * SSE2 version of `scru128_codec_scan_scalar()` that fuses the vector prefix
+ * sum of `scru128_codec_prefix_sum_sse2()` with the comparisons.
+ *
+ * @private
+ */
+static inline void scru128_codec_scan_sse2(const uint32_t *values,
+                                           uint32_t base, uint32_t init,
+                                           uint32_t min, uint32_t max,
+                                           uint64_t *bits_out) {
+  const __m128i sign = _mm_set1_epi32((int)0x80000000);
+  const __m128i b = _mm_set1_epi32((int)base);
+  const __m128i min_x = _mm_set1_epi32((int)(min ^ 0x80000000));
+  const __m128i max_x = _mm_set1_epi32((int)(max ^ 0x80000000));
+  __m128i acc = _mm_set1_epi32((int)init);
+  uint16_t bits[SCRU128_CODEC_BLOCK_LEN / 16];
+  for (int group = 0; group < SCRU128_CODEC_BLOCK_LEN / 16; group++) {
+    __m128i outside[4];
+    for (int k = 0; k < 4; k++) {
+      int row = 4 * group + k;
+      __m128i v = _mm_add_epi32(
+          _mm_loadu_si128((const __m128i *)values + row), b);
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+      __m128i x = _mm_xor_si128(_mm_add_epi32(acc, v), sign);
+      acc = _mm_add_epi32(acc, _mm_shuffle_epi32(v, 0xff));
+      outside[k] = _mm_or_si128(_mm_cmpgt_epi32(min_x, x),
+                                _mm_cmpgt_epi32(x, max_x));
+    }
+    bits[group] = (uint16_t)~scru128_codec_movemask_sse2(outside);
+  }
+  memcpy(bits_out, bits, sizeof(bits)); // x86 is little-endian
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
+/**
+ * Encodes the deltas in slots 1 to `n - 1` of `deltas` as a column and returns
+ * the number of bytes written.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_put_column(uint8_t *out,
+                                              const uint32_t *deltas,
+                                              size_t n) {
+  uint32_t base = n > 1 ? deltas[1] : 0;
+  for (size_t i = 2; i < n; i++) {
+    base = deltas[i] < base ? deltas[i] : base;
+  }
+  uint32_t values[SCRU128_CODEC_BLOCK_LEN] = {0};
+  int max_len = 0;
+  for (size_t i = 1; i < n; i++) {
+    values[i] = deltas[i] - base;
+    int len = scru128_codec_bit_len(values[i]);
+    max_len = len > max_len ? len : max_len;
+  }
+
+  // choose the cheapest width, trading packed bits for exceptions
+  int width = max_len;
+  size_t best = 16 * (size_t)max_len;
+  for (int w = 0; w < max_len; w++) {
+    size_t size = 16 * (size_t)w;
+    for (size_t i = 1; i < n; i++) {
+      if (values[i] >> w != 0) {
+        size += 1 + scru128_codec_varint_len(values[i] >> w);
+      }
+    }
+    if (size < best) {
+      best = size;
+      width = w;
+    }
+  }
+
+  uint32_t words[SCRU128_CODEC_BLOCK_LEN] = {0};
+  uint32_t mask = width == 0 ? 0 : 0xffffffff >> (32 - width);
+  for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+    uint32_t v = values[i] & mask;
+    int bit = i / 4 * width, shift = bit % 32;
+    uint32_t *word = &words[bit / 32 * 4 + i % 4];
+    word[0] |= v << shift;
+    if (shift + width > 32) {
+      word[4] |= v >> (32 - shift);
+    }
+  }
+
+  for (int i = 0; i < 4; i++) {
+    out[i] = (uint8_t)(base >> (8 * i));
+  }
+  out[4] = (uint8_t)width;
+  size_t pos = 6;
+  for (int i = 0; i < 4 * width; i++) {
+    for (int j = 0; j < 4; j++) {
+      out[pos++] = (uint8_t)(words[i] >> (8 * j));
+    }
+  }
+
+  uint8_t count = 0;
+  for (size_t i = 1; i < n; i++) {
+    uint64_t high = (uint64_t)values[i] >> width;
+    if (high != 0) {
+      out[pos++] = (uint8_t)i;
+      pos += scru128_codec_put_varint(out + pos, high);
+      count++;
+    }
+  }
+  out[5] = count;
+  return pos;
+}
+
+/**
+ * Unpacks a column into the 128 slots of deltas minus the frame of reference,
+ * which is stored in `base_out`, and returns the number of bytes read, or zero
+ * if the input is malformed.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_unpack_column(const uint8_t *in,
+                                                 size_t in_len,
+                                                 uint32_t *base_out,
+                                                 uint32_t *values_out) {
+  if (in_len < 6 || in[4] > 32) {
+    return 0;
+  }
+  int width = in[4];
+  size_t n_exc = in[5];
+  size_t pos = 6 + 16 * (size_t)width;
+  if (in_len < pos) {
+    return 0;
+  }
+
+  if (width == 0) {
+    memset(values_out, 0, 4 * SCRU128_CODEC_BLOCK_LEN);
+  } else {
+#ifdef SCRU128_HAS_X86_SIMD
+    scru128_codec_unpack_sse2(in + 6, width, values_out);
+#else
+    scru128_codec_unpack_scalar(in + 6, width, values_out);
+#endif
+  }
+
+  for (size_t i = 0; i < n_exc; i++) {
+    uint64_t high;
+    size_t len;
+    if (pos >= in_len || in[pos] >= SCRU128_CODEC_BLOCK_LEN || width == 32 ||
+        (len = scru128_codec_get_varint(in + pos + 1, in_len - pos - 1,
+                                        &high)) == 0) {
+      return 0;
+    }
+    values_out[in[pos]] |= (uint32_t)(high << width);
+    pos += 1 + len;
+  }
+  *base_out = scru128_codec_get_u32(in);
+  return pos;
+}
+
+/**
+ * Decodes a column into the 128 running sums of its deltas from `first`, the
+ * field value of the first ID, and returns the number of bytes read, or zero if
+ * the input is malformed.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_get_column(const uint8_t *in, size_t in_len,
+                                              uint32_t first,
+                                              uint32_t *values_out) {
+  uint32_t base;
+  size_t pos = scru128_codec_unpack_column(in, in_len, &base, values_out);
+  if (pos == 0) {
+    return 0;
+  }
+  // slot 0 is zero, so starting from `first - base` yields `first` at slot 0
+#ifdef SCRU128_HAS_X86_SIMD
+  scru128_codec_prefix_sum_sse2(values_out, base, first - base);
+#else
+  scru128_codec_prefix_sum_scalar(values_out, base, first - base);
+#endif
+  return pos;
+}
+
+/**
+ * Encodes SCRU128 IDs sorted in ascending order into a block.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs sorted in ascending order
+ * (at least by `timestamp`).
+ * @param n The number of IDs, which must be from 1 to
+ * `SCRU128_CODEC_BLOCK_LEN`.
+ * @param block_out A byte array of at least `SCRU128_CODEC_MAX_BLOCK_SIZE`
+ * bytes where the encoded block is stored.
+ * @return The size in bytes of the block, or zero if `n` is out of range or
+ * `ids` is not sorted.
+ */
+static inline size_t scru128_codec_encode_block(const uint8_t *ids, size_t n,
+                                                uint8_t *block_out) {
+  if (n == 0 || n > SCRU128_CODEC_BLOCK_LEN) {
+    return 0;
+  }
+
+  uint32_t deltas[4][SCRU128_CODEC_BLOCK_LEN];
+  for (size_t i = 1; i < n; i++) {
+    const uint8_t *curr = ids + SCRU128_LEN * i, *prev = curr - SCRU128_LEN;
+    uint64_t ts_prev = scru128_timestamp(prev);
+    uint64_t ts_curr = scru128_timestamp(curr);
+    if (ts_curr < ts_prev) {
+      return 0;
+    }
+    deltas[0][i] = (uint32_t)(ts_curr >> 32) - (uint32_t)(ts_prev >> 32);
+    deltas[1][i] = (uint32_t)ts_curr - (uint32_t)ts_prev;
+    deltas[2][i] =
+        (scru128_counter_hi(curr) - scru128_counter_hi(prev)) & 0xffffff;
+    deltas[3][i] =
+        (scru128_counter_lo(curr) - scru128_counter_lo(prev)) & 0xffffff;
+  }
+
+  size_t pos = 2;
+  block_out[pos++] = (uint8_t)n;
+  memcpy(block_out + pos, ids, SCRU128_LEN);
+  pos += SCRU128_LEN;
+  for (int c = 0; c < 4; c++) {
+    pos += scru128_codec_put_column(block_out + pos, deltas[c], n);
+  }
+  for (size_t i = 1; i < n; i++) {
+    memcpy(block_out + pos, ids + SCRU128_LEN * i + 12, 4);
+    pos += 4;
+  }
+  block_out[0] = (uint8_t)pos;
+  block_out[1] = (uint8_t)(pos >> 8);
+  return pos;
+}
+
+/**
+ * Returns the size in bytes of an encoded block.
+ *
+ * @param block A byte array of at least 2 bytes that starts with a block.
+ */
+static inline size_t scru128_codec_block_size(const uint8_t *block) {
+  return (size_t)block[0] | (size_t)block[1] << 8;
+}
+
+/**
+ * Returns the number of IDs in an encoded block.
+ *
+ * @param block A byte array of at least 3 bytes that starts with a block.
+ */
+static inline size_t scru128_codec_block_len(const uint8_t *block) {
+  return block[2];
+}
+
+/**
+ * Returns a pointer to the first (smallest) SCRU128 ID of an encoded block,
+ * which is stored as is and can be used to look up blocks without decoding.
+ *
+ * @param block A byte array of at least 19 bytes that starts with a block.
+ */
+static inline const uint8_t *scru128_codec_block_first(const uint8_t *block) {
+  return block + 3;
+}
+
+/**
+ * Returns the size in bytes of a block if its header is valid and the block is
+ * not truncated, or zero otherwise.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_check_block(const uint8_t *block,
+                                               size_t block_len) {
+  if (block_len < 3 + SCRU128_LEN) {
+    return 0;
+  }
+  size_t size = scru128_codec_block_size(block);
+  size_t n = scru128_codec_block_len(block);
+  if (size < 3 + SCRU128_LEN || size > block_len || n == 0 ||
+      n > SCRU128_CODEC_BLOCK_LEN) {
+    return 0;
+  }
+  return size;
+}
+
+/**
+ * Clears the bits of `bits` past slot `n - 1`, stores the rest as a bitmap of
+ * bytes in `matches_out` unless it is `NULL`, and returns the number of bits
+ * set.
+ *
+ * @private
+ */
+static inline size_t scru128_codec_finish_matches(uint64_t *bits, size_t n,
+                                                  uint8_t *matches_out) {
+  size_t count = 0;
+  for (size_t i = 0; i < 2; i++) {
+    size_t n_valid = n < 64 * i ? 0 : n - 64 * i;
+    uint64_t x = bits[i] & (n_valid >= 64 ? ~(uint64_t)0
+                                          : ((uint64_t)1 << n_valid) - 1);
+    if (matches_out != NULL) {
+      for (size_t j = 0; j < 8; j++) {
+        matches_out[8 * i + j] = (uint8_t)(x >> (8 * j));
+      }
+    }
+    x -= x >> 1 & 0x5555555555555555;
+    x = (x & 0x3333333333333333) + (x >> 2 & 0x3333333333333333);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0f;
+    count += (size_t)(x * 0x0101010101010101 >> 56);
+  }
+  return count;
+}
+
+/**
+ * Validates the header of a block and decodes its first `n_columns` columns,
+ * returning the number of bytes read, or zero if the block is truncated or
+ * malformed.
+ *
+ * @private
+ */
+static inline size_t
+scru128_codec_get_columns(const uint8_t *block, size_t block_len,
+                          int n_columns,
+                          uint32_t (*columns_out)[SCRU128_CODEC_BLOCK_LEN]) {
+  size_t size = scru128_codec_check_block(block, block_len);
+  if (size == 0) {
+    return 0;
+  }
+
+  const uint8_t *first = scru128_codec_block_first(block);
+  uint64_t timestamp = scru128_timestamp(first);
+  uint32_t fields[4] = {(uint32_t)(timestamp >> 32), (uint32_t)timestamp,
+                        scru128_counter_hi(first), scru128_counter_lo(first)};
+  size_t pos = 3 + SCRU128_LEN;
+  for (int c = 0; c < n_columns; c++) {
+    size_t len = scru128_codec_get_column(block + pos, size - pos, fields[c],
+                                          columns_out[c]);
+    if (len == 0) {
+      return 0;
+    }
+    pos += len;
+  }
+  return pos;
+}
+
+/**
+ * Decodes a block into SCRU128 IDs.
+ *
+ * @param block A byte array that starts with a block.
+ * @param block_len The number of bytes available in `block`.
+ * @param ids_out A byte array of at least `SCRU128_CODEC_BLOCK_LEN * 16` bytes
+ * where the decoded IDs are stored.
+ * @return The number of IDs decoded, or a negative integer if the block is
+ * truncated or malformed.
+ */
+static inline ptrdiff_t scru128_codec_decode_block(const uint8_t *block,
+                                                   size_t block_len,
+                                                   uint8_t *ids_out) {
+  uint32_t columns[4][SCRU128_CODEC_BLOCK_LEN];
+  size_t pos = scru128_codec_get_columns(block, block_len, 4, columns);
+  if (pos == 0) {
+    return -1;
+  }
+  size_t n = scru128_codec_block_len(block);
+  const uint8_t *entropy = block + pos;
+  if (scru128_codec_block_size(block) - pos != 4 * (n - 1)) {
+    return -1;
+  }
+
+  uint32_t overflow = 0;
+  memcpy(ids_out, scru128_codec_block_first(block), SCRU128_LEN);
+  for (size_t i = 1; i < n; i++) {
+    uint32_t ts_hi = columns[0][i], ts_lo = columns[1][i];
+    uint32_t counter_hi = columns[2][i], counter_lo = columns[3][i];
+    overflow |= ts_hi;
+    // assemble the first 12 bytes in two integers that compilers store with
+    // a byte swap each
+    uint64_t head = (uint64_t)ts_hi << 48 | (uint64_t)ts_lo << 16 |
+                    (counter_hi & 0xffffff) >> 8;
+    uint32_t tail = counter_hi << 24 | (counter_lo & 0xffffff);
+    uint8_t *id = ids_out + SCRU128_LEN * i;
+    id[0] = (uint8_t)(head >> 56);
+    id[1] = (uint8_t)(head >> 48);
+    id[2] = (uint8_t)(head >> 40);
+    id[3] = (uint8_t)(head >> 32);
+    id[4] = (uint8_t)(head >> 24);
+    id[5] = (uint8_t)(head >> 16);
+    id[6] = (uint8_t)(head >> 8);
+    id[7] = (uint8_t)head;
+    id[8] = (uint8_t)(tail >> 24);
+    id[9] = (uint8_t)(tail >> 16);
+    id[10] = (uint8_t)(tail >> 8);
+    id[11] = (uint8_t)tail;
+    memcpy(id + 12, entropy + 4 * (i - 1), 4);
+  }
+  return overflow > 0xffff ? -1 : (ptrdiff_t)n;
+}
+
+/**
+ * Selects the IDs of a block whose `timestamp` is within a range, decoding only
+ * the `timestamp` columns.
+ *
+ * @param block A byte array that starts with a block.
+ * @param block_len The number of bytes available in `block`.
+ * @param ts_min The minimum `timestamp` to select (inclusive).
+ * @param ts_max The maximum `timestamp` to select (inclusive).
+ * @param matches_out A byte array of at least `SCRU128_CODEC_BLOCK_LEN / 8`
+ * bytes where a bitmap of the selected IDs is stored (the `i`-th ID of the
+ * block at bit `i % 8` of byte `i / 8`), or `NULL` to only count them.
+ * @return The number of selected IDs, or a negative integer if the block is
+ * truncated or malformed.
+ */
+static inline ptrdiff_t scru128_codec_filter_block(const uint8_t *block,
+                                                   size_t block_len,
+                                                   uint64_t ts_min,
+                                                   uint64_t ts_max,
+                                                   uint8_t *matches_out) {
+  static const uint8_t CONSTANT[6] = {0};
+  size_t size = scru128_codec_check_block(block, block_len);
+  if (size == 0) {
+    return -1;
+  }
+  uint64_t bits[2];
+  size_t pos = 3 + SCRU128_LEN;
+  if (size - pos >= 6 && memcmp(block + pos, CONSTANT, 6) == 0) {
+    // if the upper half of `timestamp` never changes, compare the lower halves
+    // with the range clamped to that upper half in a pass over the deltas
+    uint32_t values[SCRU128_CODEC_BLOCK_LEN], base;
+    pos += 6;
+    if (scru128_codec_unpack_column(block + pos, size - pos, &base, values) ==
+        0) {
+      return -1;
+    }
+    uint64_t first = scru128_timestamp(scru128_codec_block_first(block));
+    uint64_t lower = first >> 32 << 32, upper = lower | 0xffffffff;
+    if (ts_min > upper || ts_max < lower || ts_min > ts_max) {
+      bits[0] = bits[1] = 0;
+    } else {
+      uint32_t min = ts_min > lower ? (uint32_t)ts_min : 0;
+      uint32_t max = ts_max < upper ? (uint32_t)ts_max : 0xffffffff;
+#ifdef SCRU128_HAS_X86_SIMD
+      scru128_codec_scan_sse2(values, base, (uint32_t)first - base, min, max,
+                              bits);
+#else
+      scru128_codec_scan_scalar(values, base, (uint32_t)first - base, min, max,
+                                bits);
+#endif
+    }
+  } else {
+    uint32_t columns[2][SCRU128_CODEC_BLOCK_LEN];
+    if (scru128_codec_get_columns(block, block_len, 2, columns) == 0) {
+      return -1;
+    }
+#ifdef SCRU128_HAS_X86_SIMD
+    scru128_codec_match_sse2(columns[0], columns[1], ts_min, ts_max, bits);
+#else
+    scru128_codec_match_scalar(columns[0], columns[1], ts_min, ts_max, bits);
+#endif
+  }
+  size_t n = scru128_codec_block_len(block);
+  return (ptrdiff_t)scru128_codec_finish_matches(bits, n, matches_out);
+}
+
+/**
+ * Encodes SCRU128 IDs sorted in ascending order into consecutive blocks of
+ * `SCRU128_CODEC_BLOCK_LEN` IDs (except the last one).
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs sorted in ascending order
+ * (at least by `timestamp`).
+ * @param n The number of IDs.
+ * @param out A byte array of at least `SCRU128_CODEC_MAX_ENCODED_SIZE(n)` bytes
+ * where the encoded blocks are stored.
+ * @param block_offsets_out A `size_t` array of at least
+ * `ceil(n / SCRU128_CODEC_BLOCK_LEN)` elements where the offset of each block
+ * in `out` is stored for random access, or `NULL`.
+ * @return The total size in bytes of the encoded blocks, or zero if `ids` is
+ * not sorted.
+ */
+static inline size_t scru128_codec_encode(const uint8_t *ids, size_t n,
+                                          uint8_t *out,
+                                          size_t *block_offsets_out) {
+  size_t pos = 0;
+  for (size_t i = 0; i < n; i += SCRU128_CODEC_BLOCK_LEN) {
+    size_t len = n - i < SCRU128_CODEC_BLOCK_LEN ? n - i
+                                                  : SCRU128_CODEC_BLOCK_LEN;
+    if (i > 0 && scru128_timestamp(ids + SCRU128_LEN * (i - 1)) >
+                     scru128_timestamp(ids + SCRU128_LEN * i)) {
+      return 0;
+    }
+    if (block_offsets_out != NULL) {
+      block_offsets_out[i / SCRU128_CODEC_BLOCK_LEN] = pos;
+    }
+    size_t size = scru128_codec_encode_block(ids + SCRU128_LEN * i, len,
+                                             out + pos);
+    if (size == 0) {
+      return 0;
+    }
+    pos += size;
+  }
+  return pos;
+}
+
+/**
+ * Decodes consecutive blocks into SCRU128 IDs.
+ *
+ * @param in A byte array of encoded blocks.
+ * @param in_len The size in bytes of `in`.
+ * @param ids_out A byte array of `max_n` 16-byte SCRU128 IDs where the decoded
+ * IDs are stored.
+ * @param max_n The maximum number of IDs to decode.
+ * @return The number of IDs decoded, or a negative integer if a block is
+ * truncated or malformed or the IDs do not fit in `ids_out`.
+ */
+static inline ptrdiff_t scru128_codec_decode(const uint8_t *in, size_t in_len,
+                                             uint8_t *ids_out, size_t max_n) {
+  uint8_t tmp[SCRU128_LEN * SCRU128_CODEC_BLOCK_LEN];
+  size_t count = 0;
+  for (size_t pos = 0; pos < in_len;) {
+    if (in_len - pos < 3) {
+      return -1;
+    }
+    size_t n = scru128_codec_block_len(in + pos);
+    if (n > max_n - count) {
+      return -1;
+    }
+    // decode directly into the output unless a full block may overflow it
+    uint8_t *dst = max_n - count >= SCRU128_CODEC_BLOCK_LEN
+                       ? ids_out + SCRU128_LEN * count
+                       : tmp;
+    if (scru128_codec_decode_block(in + pos, in_len - pos, dst) !=
+        (ptrdiff_t)n) {
+      return -1;
+    }
+    if (dst == tmp) {
+      memcpy(ids_out + SCRU128_LEN * count, tmp, SCRU128_LEN * n);
+    }
+    count += n;
+    pos += scru128_codec_block_size(in + pos);
+  }
+  return (ptrdiff_t)count;
+}
+
+/**
+ * Counts the IDs whose `timestamp` is within a range in consecutive blocks,
+ * decoding only the `timestamp` columns of the blocks that may contain such
+ * IDs.
+ *
+ * Because the blocks are sorted, the blocks followed by a block that starts
+ * before `ts_min` and the blocks that start after `ts_max` are skipped by
+ * their first IDs, and so are not validated.
+ *
+ * @param in A byte array of encoded blocks.
+ * @param in_len The size in bytes of `in`.
+ * @param ts_min The minimum `timestamp` to count (inclusive).
+ * @param ts_max The maximum `timestamp` to count (inclusive).
+ * @return The number of IDs counted, or a negative integer if a block is
+ * truncated or malformed.
+ */
+static inline ptrdiff_t scru128_codec_count_range(const uint8_t *in,
+                                                  size_t in_len,
+                                                  uint64_t ts_min,
+                                                  uint64_t ts_max) {
+  size_t count = 0;
+  for (size_t pos = 0; pos < in_len;) {
+    if (in_len - pos < 3 + SCRU128_LEN) {
+      return -1;
+    }
+    size_t size = scru128_codec_block_size(in + pos);
+    if (size < 3 + SCRU128_LEN || size > in_len - pos) {
+      return -1;
+    }
+    if (scru128_timestamp(scru128_codec_block_first(in + pos)) > ts_max) {
+      break;
+    }
+    size_t next = pos + size;
+    if (in_len - next < 3 + SCRU128_LEN ||
+        scru128_timestamp(scru128_codec_block_first(in + next)) >= ts_min) {
+      ptrdiff_t n =
+          scru128_codec_filter_block(in + pos, size, ts_min, ts_max, NULL);
+      if (n < 0) {
+        return -1;
+      }
+      count += (size_t)n;
+    }
+    pos = next;
+  }
+  return (ptrdiff_t)count;
+}
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* #ifndef SCRU128_CODEC_H_PLXGUBNR */
@@ -0,0 +1,514 @@
+/**
+ * @file scru128_lines.h
+ *
+ * Streaming conversion between binary SCRU128 IDs and text with one string
+ * representation per line
+ *
+ * `Scru128LineDecoder` decodes newline-delimited string representations in
+ * place from arbitrary chunks of text, such as blocks read by `fread()` or a
+ * whole file mapped into memory, without copying each line into a
+ * null-terminated string. Runs of lines of the same length (LF or CRLF) are
+ * decoded at fixed offsets without searching for each LF, and the lines split
+ * by chunk boundaries are carried over to the next chunk. A line that is
+ * not a valid string representation stops decoding and is reported with its
+ * line number.
+ *
+ * - `scru128_lines_encode()`: encodes IDs into a buffer of lines.
+ * - `Scru128LineReader` and `Scru128LineWriter`: read and write lines through
+ *   `FILE` streams with large buffers.
+ * - `scru128_lines_map()`: maps a file into memory, available if
+ *   `SCRU128_ENABLE_MMAP` is defined before including this header on POSIX
+ *   systems.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_LINES_H_JDWOCYKE
+#define SCRU128_LINES_H_JDWOCYKE
+
+#include "scru128.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef SCRU128_ENABLE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * The size in bytes of the buffers of `Scru128LineReader` and
+ * `Scru128LineWriter` (64 KiB by default).
+ */
+#ifndef SCRU128_LINES_BUFFER_SIZE
+#define SCRU128_LINES_BUFFER_SIZE (65536)
+#endif
+
+/** Returns the maximum size in bytes of `n` lines encoded with CRLF. */
+#define SCRU128_LINES_MAX_ENCODED_SIZE(n) ((n) * (SCRU128_STR_LEN + 1))
+
+/**
+ * The number of lines of the same length that the decoder checks for and
+ * decodes at a time without searching for LF.
+ *
+ * @private
+ */
+#define SCRU128_LINES_RUN_LEN (8)
+
+/** Indicates that a line is not a valid string representation. */
+#define SCRU128_LINES_ERROR_SYNTAX (-1)
+
+/** Indicates that reading from or writing to a stream failed. */
+#define SCRU128_LINES_ERROR_IO (-2)
+
+/**
+ * Represents the state of a decoder of newline-delimited string
+ * representations fed in chunks.
+ *
+ * A decoder must be initialized by `scru128_line_decoder_init()`.
+ */
+typedef struct Scru128LineDecoder {
+  /**
+   * The number of lines consumed so far, or the line number (starting from
+   * one) of the invalid line after a function returns
+   * `SCRU128_LINES_ERROR_SYNTAX`.
+   */
+  uint64_t line;
+
+  /**
+   * The beginning of a line split by the end of the previous chunk, up to
+   * `25` digits and CR.
+   *
+   * @private
+   */
+  char _carry[SCRU128_STR_LEN];
+
+  /**
+   * The length of the split line, which may exceed the size of `_carry`.
+   *
+   * @private
+   */
+  size_t _carry_len;
+} Scru128LineDecoder;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Initializes a line decoder. */
+static inline void scru128_line_decoder_init(Scru128LineDecoder *d) {
+  d->line = 0;
+  d->_carry_len = 0;
+}
+
+/**
+ * Decodes a single line of `len` characters excluding LF and returns zero on
+ * success or `SCRU128_LINES_ERROR_SYNTAX` on failure.
+ *
+ * @private
+ */
+static inline int scru128_lines_decode_one(uint8_t *id_out, const char *line,
+                                           size_t len) {
+  if (len > 0 && line[len - 1] == '\r') {
+    len--;
+  }
+  if (len != SCRU128_STR_LEN - 1 ||
+      scru128_from_str_batch(id_out, line, 1, len, NULL) != 0) {
+    return SCRU128_LINES_ERROR_SYNTAX;
+  }
+  return 0;
+}
+
+/**
+ * Decodes complete lines of a chunk of text into SCRU128 IDs.
+ *
+ * Each line must consist of a 25-digit string representation followed by LF or
+ * CRLF. The last line of a chunk that does not end with LF is saved in the
+ * decoder and completed by the following chunks or
+ * `scru128_line_decoder_finish()`.
+ *
+ * If an invalid line is found after some IDs are decoded, this function
+ * returns the number of those IDs, and the next call returns
+ * `SCRU128_LINES_ERROR_SYNTAX`. In any case, decoding can be resumed after the
+ * invalid line by feeding the rest of the chunk.
+ *
+ * @param d The line decoder.
+ * @param src A chunk of text, which need not be null-terminated.
+ * @param len The length of `src` in bytes.
+ * @param consumed_out A pointer to a variable where the number of bytes of
+ * `src` consumed is stored. The bytes after it must be fed again.
+ * @param ids_out A byte array of `max_n` 16-byte IDs where the decoded IDs are
+ * stored.
+ * @param max_n The maximum number of IDs to decode.
+ * @return The number of IDs decoded or `SCRU128_LINES_ERROR_SYNTAX` if the
+ * first line is invalid. `d->line` is the line number of the invalid line in
+ * the latter case.
+ */
+static inline ptrdiff_t scru128_line_decoder_feed(Scru128LineDecoder *d,
+                                                  const char *src, size_t len,
+                                                  size_t *consumed_out,
+                                                  uint8_t *ids_out,
+                                                  size_t max_n) {
+  size_t pos = 0, count = 0;
+  int status = 0;
+
+  // complete the line carried over from the previous chunk
+  if (d->_carry_len > 0 && max_n > 0) {
+    const char *lf = (const char *)memchr(src, '\n', len);
+    size_t n_bytes = lf == NULL ? len : (size_t)(lf - src);
+    for (size_t i = 0; i < n_bytes && d->_carry_len + i < SCRU128_STR_LEN;
+         i++) {
+      d->_carry[d->_carry_len + i] = src[i];
+    }
+    d->_carry_len += n_bytes;
+    pos = lf == NULL ? len : n_bytes + 1;
+    if (lf != NULL) {
+      d->line++;
+      status = d->_carry_len > SCRU128_STR_LEN
+                   ? SCRU128_LINES_ERROR_SYNTAX
+                   : scru128_lines_decode_one(ids_out, d->_carry,
+                                              d->_carry_len);
+      d->_carry_len = 0;
+      count = status == 0 ? 1 : 0;
+    }
+  }
+
+  while (status == 0 && pos < len && count < max_n) {
+    // decode a run of lines of the same length at a time if possible
+    size_t stride = len - pos >= SCRU128_STR_LEN &&
+                            src[pos + SCRU128_STR_LEN - 1] == '\r'
+                        ? SCRU128_STR_LEN + 1
+                        : SCRU128_STR_LEN;
+    if (len - pos >= stride * SCRU128_LINES_RUN_LEN &&
+        max_n - count >= SCRU128_LINES_RUN_LEN) {
+      int is_run = 1;
+      for (int_fast8_t l = 0; l < SCRU128_LINES_RUN_LEN; l++) {
+        const char *end = src + pos + stride * (size_t)l + stride - 1;
+        is_run &= end[0] == '\n' &&
+                  (stride == SCRU128_STR_LEN || end[-1] == '\r');
+      }
+      if (is_run) {
+        // keep the valid lines before the first invalid one, if any
+        int_fast8_t l = 0;
+        while (l < SCRU128_LINES_RUN_LEN &&
+               scru128_from_digits(ids_out + SCRU128_LEN * (count + (size_t)l),
+                                   src + pos + stride * (size_t)l, 0) == 0) {
+          l++;
+        }
+        pos += stride * (size_t)l;
+        count += (size_t)l;
+        d->line += (uint64_t)l;
+        if (l == SCRU128_LINES_RUN_LEN) {
+          continue;
+        } else if (count > 0) {
+          break;
+        }
+      }
+    }
+
+    const char *lf = (const char *)memchr(src + pos, '\n', len - pos);
+    if (lf == NULL) {
+      // save the incomplete last line
+      size_t n_bytes = len - pos;
+      for (size_t i = 0; i < n_bytes && i < SCRU128_STR_LEN; i++) {
+        d->_carry[i] = src[pos + i];
+      }
+      d->_carry_len = n_bytes;
+      pos = len;
+      break;
+    }
+    size_t n_bytes = (size_t)(lf - (src + pos));
+    uint8_t *id_out = ids_out + SCRU128_LEN * count;
+    if (scru128_lines_decode_one(id_out, src + pos, n_bytes) != 0) {
+      if (count > 0) {
+        break;
+      }
+      status = SCRU128_LINES_ERROR_SYNTAX;
+    } else {
+      count++;
+    }
+    pos += n_bytes + 1;
+    d->line++;
+  }
+
+  *consumed_out = pos;
+  return status != 0 ? status : (ptrdiff_t)count;
+}
+
+/**
+ * Decodes the last line of the text if it does not end with LF.
+ *
+ * @param d The line decoder.
+ * @param id_out A 16-byte byte array where the decoded ID is stored.
+ * @return One if an ID is decoded, zero if there is no such line, or
+ * `SCRU128_LINES_ERROR_SYNTAX` if the line is invalid.
+ */
+static inline int scru128_line_decoder_finish(Scru128LineDecoder *d,
+                                              uint8_t *id_out) {
+  if (d->_carry_len == 0) {
+    return 0;
+  }
+  d->line++;
+  size_t carry_len = d->_carry_len;
+  d->_carry_len = 0;
+  if (carry_len > SCRU128_STR_LEN ||
+      scru128_lines_decode_one(id_out, d->_carry, carry_len) != 0) {
+    return SCRU128_LINES_ERROR_SYNTAX;
+  }
+  return 1;
+}
+
+/**
+ * Encodes SCRU128 IDs into lines of 25-digit string representations.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs.
+ * @param n The number of IDs.
+ * @param crlf Terminates each line with CRLF if nonzero or LF otherwise.
+ * @param out A character array of at least `n * 26` (or `n * 27` with CRLF)
+ * bytes where the lines are stored. The result is not null-terminated.
+ * @return The number of bytes written.
+ */
+static inline size_t scru128_lines_encode(const uint8_t *ids, size_t n,
+                                          int crlf, char *out) {
+  if (!crlf) {
+    // encode in place and replace each null terminator with LF
+    scru128_to_str_batch(ids, n, out);
+    for (size_t i = 0; i < n; i++) {
+      out[SCRU128_STR_LEN * i + SCRU128_STR_LEN - 1] = '\n';
+    }
+    return SCRU128_STR_LEN * n;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    // the null terminator is overwritten by CR
+    char *line = out + (SCRU128_STR_LEN + 1) * i;
+    scru128_to_str(ids + SCRU128_LEN * i, line);
+    line[SCRU128_STR_LEN - 1] = '\r';
+    line[SCRU128_STR_LEN] = '\n';
+  }
+  return (SCRU128_STR_LEN + 1) * n;
+}
+
+/**
+ * Represents a reader of newline-delimited string representations from a
+ * `FILE` stream.
+ *
+ * A reader must be initialized by `scru128_line_reader_init()`. The structure
+ * contains a `SCRU128_LINES_BUFFER_SIZE`-byte buffer and thus should not be
+ * placed on a small stack.
+ */
+typedef struct Scru128LineReader {
+  /** The underlying line decoder, which tracks line numbers. */
+  Scru128LineDecoder decoder;
+
+  /** @private */
+  FILE *_stream;
+
+  /** @private */
+  size_t _pos, _len;
+
+  /** @private */
+  int _is_eof;
+
+  /** @private */
+  char _buffer[SCRU128_LINES_BUFFER_SIZE];
+} Scru128LineReader;
+
+/** Initializes a line reader that reads from `stream`. */
+static inline void scru128_line_reader_init(Scru128LineReader *r,
+                                            FILE *stream) {
+  scru128_line_decoder_init(&r->decoder);
+  r->_stream = stream;
+  r->_pos = 0;
+  r->_len = 0;
+  r->_is_eof = 0;
+}
+
+/**
+ * Reads the next SCRU128 IDs from the stream.
+ *
+ * @param r The line reader.
+ * @param ids_out A byte array of `max_n` 16-byte IDs where the IDs are stored.
+ * @param max_n The maximum number of IDs to read, which must be positive.
+ * @return The number of IDs read, zero at the end of the stream,
+ * `SCRU128_LINES_ERROR_SYNTAX` if the next line is invalid, or
+ * `SCRU128_LINES_ERROR_IO` if reading fails. After a syntax error,
+ * `r->decoder.line` is the line number of the invalid line, and the next call
+ * resumes after it.
+ */
+static inline ptrdiff_t scru128_line_reader_read(Scru128LineReader *r,
+                                                 uint8_t *ids_out,
+                                                 size_t max_n) {
+  for (;;) {
+    if (r->_pos < r->_len) {
+      size_t consumed;
+      ptrdiff_t n =
+          scru128_line_decoder_feed(&r->decoder, r->_buffer + r->_pos,
+                                    r->_len - r->_pos, &consumed, ids_out,
+                                    max_n);
+      r->_pos += consumed;
+      if (n != 0) {
+        return n;
+      }
+    } else if (r->_is_eof) {
+      return scru128_line_decoder_finish(&r->decoder, ids_out);
+    } else {
+      r->_pos = 0;
+      r->_len = fread(r->_buffer, 1, SCRU128_LINES_BUFFER_SIZE, r->_stream);
+      if (r->_len < SCRU128_LINES_BUFFER_SIZE) {
+        if (ferror(r->_stream)) {
+          return SCRU128_LINES_ERROR_IO;
+        }
+        r->_is_eof = 1;
+      }
+    }
+  }
+}
+
+/**
+ * Represents a writer of SCRU128 IDs as newline-delimited string
+ * representations to a `FILE` stream.
+ *
+ * A writer must be initialized by `scru128_line_writer_init()` and flushed by
+ * `scru128_line_writer_flush()` at the end. The structure contains a
+ * `SCRU128_LINES_BUFFER_SIZE`-byte buffer and thus should not be placed on a
+ * small stack.
+ */
+typedef struct Scru128LineWriter {
+  /** @private */
+  FILE *_stream;
+
+  /** @private */
+  int _crlf;
+
+  /** @private */
+  size_t _len;
+
+  /** @private */
+  char _buffer[SCRU128_LINES_BUFFER_SIZE];
+} Scru128LineWriter;
+
+/**
+ * Initializes a line writer that writes to `stream`, terminating each line with
+ * CRLF if `crlf` is nonzero or LF otherwise.
+ */
+static inline void scru128_line_writer_init(Scru128LineWriter *w, FILE *stream,
+                                            int crlf) {
+  w->_stream = stream;
+  w->_crlf = crlf;
+  w->_len = 0;
+}
+
+/**
+ * Writes the buffered lines to the stream.
+ *
+ * @return Zero on success or `SCRU128_LINES_ERROR_IO` on failure.
+ */
+static inline int scru128_line_writer_flush(Scru128LineWriter *w) {
+  size_t len = w->_len;
+  w->_len = 0;
+  if (len > 0 && fwrite(w->_buffer, 1, len, w->_stream) < len) {
+    return SCRU128_LINES_ERROR_IO;
+  }
+  return 0;
+}
+
+/**
+ * Writes SCRU128 IDs as lines, which are buffered and written to the stream in
+ * blocks of about `SCRU128_LINES_BUFFER_SIZE` bytes.
+ *
+ * @param w The line writer.
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs.
+ * @param n The number of IDs.
+ * @return Zero on success or `SCRU128_LINES_ERROR_IO` on failure.
+ */
+static inline int scru128_line_writer_write(Scru128LineWriter *w,
+                                            const uint8_t *ids, size_t n) {
+  size_t line_len = w->_crlf ? SCRU128_STR_LEN + 1 : SCRU128_STR_LEN;
+  size_t capacity = SCRU128_LINES_BUFFER_SIZE / line_len;
+  while (n > 0) {
+    if (w->_len + line_len > SCRU128_LINES_BUFFER_SIZE &&
+        scru128_line_writer_flush(w) != 0) {
+      return SCRU128_LINES_ERROR_IO;
+    }
+    size_t n_lines = capacity - w->_len / line_len;
+    n_lines = n < n_lines ? n : n_lines;
+    w->_len +=
+        scru128_lines_encode(ids, n_lines, w->_crlf, w->_buffer + w->_len);
+    ids += SCRU128_LEN * n_lines;
+    n -= n_lines;
+  }
+  return 0;
+}
+
+#ifdef SCRU128_ENABLE_MMAP
+/**
+ * Maps a file into memory for reading, so that its content can be decoded by
+ * `scru128_line_decoder_feed()` in one call without copying.
+ *
+ * @param path The path of the file.
+ * @param data_out A pointer to a variable where the address of the content is
+ * stored, which is `NULL` if the file is empty.
+ * @param len_out A pointer to a variable where the size of the file is stored.
+ * @return Zero on success or `SCRU128_LINES_ERROR_IO` on failure.
+ */
+static inline int scru128_lines_map(const char *path, const char **data_out,
+                                    size_t *len_out) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return SCRU128_LINES_ERROR_IO;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return SCRU128_LINES_ERROR_IO;
+  }
+
+  void *data = NULL;
+  if (st.st_size > 0) {
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return SCRU128_LINES_ERROR_IO;
+    }
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+  }
+  close(fd);
+  *data_out = (const char *)data;
+  *len_out = (size_t)st.st_size;
+  return 0;
+}
+
+/** Unmaps a file mapped by `scru128_lines_map()`. */
+static inline void scru128_lines_unmap(const char *data, size_t len) {
+  if (data != NULL) {
+    munmap((void *)data, len);
+  }
+}
+#endif /* #ifdef SCRU128_ENABLE_MMAP */
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* #ifndef SCRU128_LINES_H_JDWOCYKE */
@@ -0,0 +1,779 @@
+/**
+ * @file scru128_sort.h
+ *
+ * Sorting, searching, and merging of SCRU128 ID arrays
+ *
+ * This header sorts arrays of binary SCRU128 IDs (contiguous 16-byte records)
+ * by MSD radix sort over the big-endian bytes, which moves each ID a few times
+ * instead of comparing it `log2(n)` times as `qsort()` with `scru128_compare()`
+ * does. IDs generated within a bounded time window share the leading bytes of
+ * `timestamp`; each level of the sort first finds the bytes shared by all the
+ * IDs in the range and skips them without moving any ID.
+ *
+ * - `scru128_sort()`: in place (American flag sort).
+ * - `scru128_sort_with_scratch()`: out of place with a caller-provided buffer,
+ *   which moves IDs sequentially and is faster than the in-place variant.
+ * - `scru128_sort_parallel()`: multithreaded, available if
+ *   `SCRU128_ENABLE_THREADS` is defined before including this header.
+ *
+ * Sorted arrays can then be searched by time range with
+ * `scru128_lower_bound_timestamp()` and the related functions, which read only
+ * the 48-bit `timestamp` field of the probed IDs, and sorted runs of IDs can be
+ * merged by `Scru128Merger` from callbacks that read them incrementally.
+ *
+ * @copyright Licensed under the Apache License, Version 2.0
+ * @see       https://github.com/scru128/c
+ */
+/*
+ * Copyright 2022-2023 The scru128/c Developers.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRU128_SORT_H_TWQDHJVA
+#define SCRU128_SORT_H_TWQDHJVA
+
+#include "scru128.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SCRU128_ENABLE_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * The number of IDs at or below which a range is finished by insertion sort.
+ *
+ * @private
+ */
+#define SCRU128_SORT_INSERTION_THRESHOLD (32)
+
+/**
+ * The maximum number of interpolation probes made by the timestamp search
+ * functions before they fall back to binary search.
+ *
+ * @private
+ */
+#define SCRU128_SEARCH_MAX_PROBES (8)
+
+/**
+ * The number of IDs that `Scru128Merger` reads from a source at a time.
+ *
+ * @private
+ */
+#define SCRU128_MERGE_BUFFER_LEN (256)
+
+/**
+ * Represents a stream of SCRU128 IDs sorted in ascending order, such as a run
+ * of IDs stored in a file, that `Scru128Merger` reads incrementally.
+ */
+typedef struct Scru128MergeSource {
+  /** An opaque pointer passed to `pull` as the first argument. */
+  void *ctx;
+
+  /**
+   * A function that stores up to `max_n` next IDs of the stream in `ids_out`
+   * and returns the number of IDs stored, zero at the end of the stream, or a
+   * negative integer on error.
+   */
+  ptrdiff_t (*pull)(void *ctx, uint8_t *ids_out, size_t max_n);
+} Scru128MergeSource;
+
+/**
+ * Represents the buffered head of a source of `Scru128Merger`.
+ *
+ * @private
+ */
+typedef struct Scru128MergeRun {
+  /** @private */
+  uint8_t *_buffer;
+
+  /** @private */
+  size_t _pos;
+
+  /** @private */
+  size_t _len;
+
+  /**
+   * The ID at `_pos` as two big-endian 64-bit words.
+   *
+   * @private
+   */
+  uint64_t _hi, _lo;
+
+  /** @private */
+  int _is_exhausted;
+} Scru128MergeRun;
+
+/**
+ * Represents a k-way merge of sorted streams of SCRU128 IDs.
+ *
+ * A merger keeps the current head of each source in a loser tree (tournament
+ * tree), so producing an ID takes `log2(k)` comparisons, each of which
+ * compares two pairs of 64-bit words.
+ *
+ * A merger must be initialized by `scru128_merger_init()` and released by
+ * `scru128_merger_destroy()`.
+ */
+typedef struct Scru128Merger {
+  /** @private */
+  const Scru128MergeSource *_sources;
+
+  /** @private */
+  size_t _n_sources;
+
+  /** @private */
+  Scru128MergeRun *_runs;
+
+  /**
+   * The loser of the match at each internal node, with the overall winner at
+   * index zero.
+   *
+   * @private
+   */
+  size_t *_tree;
+
+  /** @private */
+  uint8_t *_memory;
+
+  /** @private */
+  int _dedup;
+
+  /** @private */
+  int _has_last;
+
+  /**
+   * The last ID written as two big-endian 64-bit words.
+   *
+   * @private
+   */
+  uint64_t _last_hi, _last_lo;
+
+  /** @private */
+  int _has_error;
+} Scru128Merger;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sorts `n` IDs that are equal in the bytes before `byte` by insertion sort.
+ *
+ * @private
+ */
+static inline void scru128_sort_insertion(uint8_t *ids, size_t n, int byte) {
+  size_t len = (size_t)(SCRU128_LEN - byte);
+  uint8_t tmp[SCRU128_LEN];
+  for (size_t i = 1; i < n; i++) {
+    uint8_t *curr = ids + SCRU128_LEN * i;
+    if (memcmp(curr - SCRU128_LEN + byte, curr + byte, len) <= 0) {
+      continue;
+    }
+    memcpy(tmp, curr, SCRU128_LEN);
+    size_t j = i;
+    do {
+      memcpy(ids + SCRU128_LEN * j, ids + SCRU128_LEN * (j - 1), SCRU128_LEN);
+      j--;
+    } while (j > 0 && memcmp(ids + SCRU128_LEN * (j - 1) + byte, tmp + byte,
+                             len) > 0);
+    memcpy(ids + SCRU128_LEN * j, tmp, SCRU128_LEN);
+  }
+}
+
+/**
+ * Returns the position of the first byte at or after `byte` that is not the
+ * same in all the `n` IDs, or `SCRU128_LEN` if all the IDs are equal.
+ *
+ * @private
+ */
+static inline int scru128_sort_skip_prefix(const uint8_t *ids, size_t n,
+                                           int byte) {
+  int end = SCRU128_LEN;
+  for (size_t i = 1; i < n && byte < end; i++) {
+    const uint8_t *curr = ids + SCRU128_LEN * i;
+    for (int j = byte; j < end; j++) {
+      if (curr[j] != ids[j]) {
+        end = j;
+      }
+    }
+  }
+  return end;
+}
+
+/**
+ * Partitions `n` IDs that are equal in the bytes before `byte` into 256
+ * buckets by the first byte that differs among them, using `scratch` (if not
+ * `NULL`) as a temporary buffer or swapping IDs in place (otherwise).
+ *
+ * @param counts_out A 256-element array where the size of each bucket is
+ * stored.
+ * @return The position of the byte used as the key, or `SCRU128_LEN` if all
+ * the IDs are equal (in which case `counts_out` is not filled).
+ * @private
+ */
+static inline int scru128_sort_partition(uint8_t *ids, uint8_t *scratch,
+                                         size_t n, int byte,
+                                         size_t *counts_out) {
+  byte = scru128_sort_skip_prefix(ids, n, byte);
+  if (byte == SCRU128_LEN) {
+    return byte;
+  }
+
+  size_t heads[256];
+  memset(counts_out, 0, 256 * sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    counts_out[ids[SCRU128_LEN * i + byte]]++;
+  }
+  for (size_t d = 0, sum = 0; d < 256; d++) {
+    heads[d] = sum;
+    sum += counts_out[d];
+  }
+
+  if (scratch != NULL) {
+    for (size_t i = 0; i < n; i++) {
+      const uint8_t *src = ids + SCRU128_LEN * i;
+      memcpy(scratch + SCRU128_LEN * heads[src[byte]]++, src, SCRU128_LEN);
+    }
+    memcpy(ids, scratch, SCRU128_LEN * n);
+  } else {
+    // move each misplaced ID to the head of its bucket until every bucket is
+    // filled with the right IDs
+    uint8_t tmp[SCRU128_LEN];
+    for (size_t d = 0, end = 0; d < 256; d++) {
+      end += counts_out[d];
+      while (heads[d] < end) {
+        uint8_t *curr = ids + SCRU128_LEN * heads[d];
+        uint8_t digit = curr[byte];
+        if (digit == d) {
+          heads[d]++;
+        } else {
+          uint8_t *dst = ids + SCRU128_LEN * heads[digit]++;
+          memcpy(tmp, dst, SCRU128_LEN);
+          memcpy(dst, curr, SCRU128_LEN);
+          memcpy(curr, tmp, SCRU128_LEN);
+        }
+      }
+    }
+  }
+  return byte;
+}
+
+/**
+ * Sorts `n` IDs that are equal in the bytes before `byte`.
+ *
+ * @private
+ */
+static inline void scru128_sort_core(uint8_t *ids, uint8_t *scratch, size_t n,
+                                     int byte) {
+  if (n <= SCRU128_SORT_INSERTION_THRESHOLD) {
+    scru128_sort_insertion(ids, n, byte);
+    return;
+  }
+
+  size_t counts[256];
+  byte = scru128_sort_partition(ids, scratch, n, byte, counts);
+  if (byte < SCRU128_LEN - 1) {
+    for (size_t d = 0, start = 0; d < 256; start += counts[d++]) {
+      if (counts[d] > 1) {
+        scru128_sort_core(ids + SCRU128_LEN * start,
+                          scratch == NULL ? NULL
+                                          : scratch + SCRU128_LEN * start,
+                          counts[d], byte + 1);
+      }
+    }
+  }
+}
+
+/**
+ * Sorts an array of SCRU128 IDs in ascending order in place.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs.
+ * @param n The number of IDs.
+ */
+static inline void scru128_sort(uint8_t *ids, size_t n) {
+  scru128_sort_core(ids, NULL, n, 0);
+}
+
+/**
+ * Sorts an array of SCRU128 IDs in ascending order using a scratch buffer.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs.
+ * @param n The number of IDs.
+ * @param scratch A byte array of at least `n * SCRU128_LEN` bytes that does not
+ * overlap `ids`, whose content is overwritten.
+ */
+static inline void scru128_sort_with_scratch(uint8_t *ids, size_t n,
+                                             uint8_t *scratch) {
+  scru128_sort_core(ids, scratch, n, 0);
+}
+
+/**
+ * Returns the index of the first ID whose `timestamp` is not less than
+ * `timestamp` in an array of SCRU128 IDs sorted in ascending order, or `n` if
+ * there is no such ID.
+ *
+ * This function estimates the position by interpolating `timestamp` between
+ * the timestamps at both ends of the remaining range, which usually finds the
+ * position in a few probes because timestamps of IDs are spread roughly evenly
+ * over time. If a probe fails to halve the range (e.g., due to bursts of IDs),
+ * the function falls back to branchless binary search.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs sorted in ascending order.
+ * @param n The number of IDs.
+ * @param timestamp A `timestamp` field value to search for.
+ */
+static inline size_t scru128_lower_bound_timestamp(const uint8_t *ids,
+                                                   size_t n,
+                                                   uint64_t timestamp) {
+  // the result is in [lo, hi]: IDs before `lo` are less and IDs at and after
+  // `hi` are not less than `timestamp`
+  size_t lo = 0, hi = n;
+  for (int i = 0; i < SCRU128_SEARCH_MAX_PROBES && lo < hi; i++) {
+    uint64_t first = scru128_timestamp(ids + SCRU128_LEN * lo);
+    uint64_t last = scru128_timestamp(ids + SCRU128_LEN * (hi - 1));
+    if (timestamp <= first) {
+      return lo;
+    } else if (timestamp > last) {
+      return hi;
+    }
+
+    // first < timestamp <= last, so the result is in (lo, hi - 1]
+    size_t width = hi - lo;
+    size_t probe = lo + 1 +
+                   (size_t)((double)(timestamp - first - 1) /
+                            (double)(last - first) * (double)(width - 2));
+    if (scru128_timestamp(ids + SCRU128_LEN * probe) < timestamp) {
+      lo = probe + 1;
+    } else {
+      hi = probe;
+    }
+    if (hi - lo > width / 2) {
+      break; // distribution is too skewed to interpolate
+    }
+  }
+
+  if (lo >= hi) {
+    return lo;
+  }
+  const uint8_t *base = ids + SCRU128_LEN * lo;
+  for (size_t len = hi - lo; len > 1;) {
+    size_t half = len / 2;
+    base = scru128_timestamp(base + SCRU128_LEN * half) < timestamp
+               ? base + SCRU128_LEN * half
+               : base;
+    len -= half;
+  }
+  return (size_t)(base - ids) / SCRU128_LEN +
+         (scru128_timestamp(base) < timestamp);
+}
+
+/**
+ * Returns the index of the first ID whose `timestamp` is greater than
+ * `timestamp` in an array of SCRU128 IDs sorted in ascending order, or `n` if
+ * there is no such ID.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs sorted in ascending order.
+ * @param n The number of IDs.
+ * @param timestamp A `timestamp` field value to search for.
+ */
+static inline size_t scru128_upper_bound_timestamp(const uint8_t *ids,
+                                                   size_t n,
+                                                   uint64_t timestamp) {
+  if (timestamp >= SCRU128_MAX_TIMESTAMP) {
+    return n;
+  }
+  return scru128_lower_bound_timestamp(ids, n, timestamp + 1);
+}
+
+/**
+ * Finds the range of IDs whose `timestamp` is between `timestamp_from` and
+ * `timestamp_to` (both inclusive) in an array of SCRU128 IDs sorted in
+ * ascending order.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs sorted in ascending order.
+ * @param n The number of IDs.
+ * @param timestamp_from The smallest `timestamp` field value to include.
+ * @param timestamp_to The largest `timestamp` field value to include.
+ * @param start_out A pointer where the index of the first ID in the range is
+ * stored.
+ * @return The number of IDs in the range, which start at `*start_out`.
+ */
+static inline size_t scru128_find_timestamp_range(const uint8_t *ids, size_t n,
+                                                  uint64_t timestamp_from,
+                                                  uint64_t timestamp_to,
+                                                  size_t *start_out) {
+  size_t start = scru128_lower_bound_timestamp(ids, n, timestamp_from);
+  *start_out = start;
+  if (timestamp_to < timestamp_from) {
+    return 0;
+  }
+  return scru128_upper_bound_timestamp(ids + SCRU128_LEN * start, n - start,
+                                       timestamp_to);
+}
+
+/**
+ * Loads a big-endian 64-bit word.
+ *
+ * @private
+ */
+static inline uint64_t scru128_load_u64(const uint8_t *bytes) {
+  return (uint64_t)bytes[0] << 56 | (uint64_t)bytes[1] << 48 |
+         (uint64_t)bytes[2] << 40 | (uint64_t)bytes[3] << 32 |
+         (uint64_t)bytes[4] << 24 | (uint64_t)bytes[5] << 16 |
+         (uint64_t)bytes[6] << 8 | (uint64_t)bytes[7];
+}
+
+/**
+ * Moves the head of a run to the next ID, refilling the buffer from `source`
+ * as needed, and returns zero on success or a non-zero integer on error.
+ *
+ * @private
+ */
+static inline int scru128_merge_run_advance(Scru128MergeRun *run,
+                                            const Scru128MergeSource *source) {
+  if (++run->_pos >= run->_len) {
+    ptrdiff_t n =
+        (*source->pull)(source->ctx, run->_buffer, SCRU128_MERGE_BUFFER_LEN);
+    if (n < 0 || n > SCRU128_MERGE_BUFFER_LEN) {
+      run->_is_exhausted = 1;
+      return -1;
+    }
+    run->_pos = 0;
+    run->_len = (size_t)n;
+    if (n == 0) {
+      run->_is_exhausted = 1;
+      return 0;
+    }
+  }
+  const uint8_t *head = run->_buffer + SCRU128_LEN * run->_pos;
+  run->_hi = scru128_load_u64(head);
+  run->_lo = scru128_load_u64(head + 8);
+  return 0;
+}
+
+/**
+ * Returns true if the head of the `a`-th run precedes that of the `b`-th run,
+ * placing exhausted runs last and breaking ties by the source index.
+ *
+ * @private
+ */
+static inline int scru128_merge_precedes(const Scru128MergeRun *runs, size_t a,
+                                         size_t b) {
+  const Scru128MergeRun *x = &runs[a], *y = &runs[b];
+  if (x->_is_exhausted || y->_is_exhausted) {
+    return !x->_is_exhausted || (y->_is_exhausted && a < b);
+  } else if (x->_hi != y->_hi) {
+    return x->_hi < y->_hi;
+  } else if (x->_lo != y->_lo) {
+    return x->_lo < y->_lo;
+  }
+  return a < b;
+}
+
+/**
+ * Plays the matches of the subtree rooted at `node`, storing the losers in
+ * the tree and returning the winner.
+ *
+ * @private
+ */
+static inline size_t scru128_merger_build(Scru128Merger *m, size_t node) {
+  if (node >= m->_n_sources) {
+    return node - m->_n_sources; // leaf
+  }
+  size_t lft = scru128_merger_build(m, 2 * node);
+  size_t rgt = scru128_merger_build(m, 2 * node + 1);
+  if (scru128_merge_precedes(m->_runs, rgt, lft)) {
+    m->_tree[node] = lft;
+    return rgt;
+  } else {
+    m->_tree[node] = rgt;
+    return lft;
+  }
+}
+
+/**
+ * Initializes a merger that merges `n_sources` sorted streams of SCRU128 IDs.
+ *
+ * This function allocates the buffers of the merger and reads the first IDs of
+ * every source.
+ *
+ * @param m A merger object to initialize.
+ * @param sources An array of `n_sources` sources, which must remain valid until
+ * the merger is destroyed.
+ * @param n_sources The number of sources.
+ * @param dedup Non-zero to write each distinct ID only once, even if it appears
+ * in multiple sources or multiple times in a source.
+ * @return Zero on success or a non-zero integer if memory allocation or a
+ * `pull` call fails, in which case the merger does not need to be destroyed.
+ */
+static inline int scru128_merger_init(Scru128Merger *m,
+                                      const Scru128MergeSource *sources,
+                                      size_t n_sources, int dedup) {
+  size_t k = n_sources > 0 ? n_sources : 1;
+  size_t buffer_size = SCRU128_LEN * SCRU128_MERGE_BUFFER_LEN;
+  if (k > ((size_t)-1 / 2) /
+              (buffer_size + sizeof(Scru128MergeRun) + sizeof(size_t))) {
+    return -1;
+  }
+  m->_memory = (uint8_t *)malloc(
+      k * (sizeof(Scru128MergeRun) + sizeof(size_t) + buffer_size));
+  if (m->_memory == NULL) {
+    return -1;
+  }
+  m->_runs = (Scru128MergeRun *)m->_memory;
+  m->_tree = (size_t *)(m->_memory + k * sizeof(Scru128MergeRun));
+  uint8_t *buffers =
+      m->_memory + k * (sizeof(Scru128MergeRun) + sizeof(size_t));
+
+  m->_sources = sources;
+  m->_n_sources = n_sources;
+  m->_dedup = dedup;
+  m->_has_last = 0;
+  m->_last_hi = 0;
+  m->_last_lo = 0;
+  m->_has_error = 0;
+  m->_tree[0] = 0;
+  for (size_t i = 0; i < n_sources; i++) {
+    Scru128MergeRun *run = &m->_runs[i];
+    run->_buffer = buffers + buffer_size * i;
+    run->_pos = 0;
+    run->_len = 0;
+    run->_is_exhausted = 0;
+    if (scru128_merge_run_advance(run, &sources[i]) != 0) {
+      free(m->_memory);
+      return -1;
+    }
+  }
+  if (n_sources > 0) {
+    m->_tree[0] = scru128_merger_build(m, 1);
+  }
+  return 0;
+}
+
+/** Releases the resources held by a merger. */
+static inline void scru128_merger_destroy(Scru128Merger *m) {
+  free(m->_memory);
+  m->_memory = NULL;
+}
+
+/**
+ * Writes up to `n` next IDs of the merged stream in ascending order.
+ *
+ * @param m A merger object.
+ * @param ids_out A byte array of at least `n * SCRU128_LEN` bytes where the
+ * merged IDs are stored.
+ * @param n The maximum number of IDs to write.
+ * @return The number of IDs written, which is less than `n` only at the end of
+ * the merged stream, or a negative integer if a `pull` call of a source has
+ * failed (in which case the merger is no longer usable).
+ */
+static inline ptrdiff_t scru128_merger_read(Scru128Merger *m, uint8_t *ids_out,
+                                            size_t n) {
+  if (m->_has_error) {
+    return -1;
+  } else if (m->_n_sources == 0) {
+    return 0;
+  }
+
+  Scru128MergeRun *runs = m->_runs;
+  size_t count = 0;
+  while (count < n) {
+    size_t winner = m->_tree[0];
+    Scru128MergeRun *run = &runs[winner];
+    if (run->_is_exhausted) {
+      break; // all sources are exhausted
+    }
+
+    if (!m->_dedup || !m->_has_last || run->_hi != m->_last_hi ||
+        run->_lo != m->_last_lo) {
+      memcpy(ids_out + SCRU128_LEN * count,
+             run->_buffer + SCRU128_LEN * run->_pos, SCRU128_LEN);
+      count++;
+      m->_has_last = 1;
+      m->_last_hi = run->_hi;
+      m->_last_lo = run->_lo;
+    }
+
+    if (scru128_merge_run_advance(run, &m->_sources[winner]) != 0) {
+      m->_has_error = 1;
+      return -1;
+    }
+
+    // replay the matches on the path from the leaf of the winner to the root
+    for (size_t node = (winner + m->_n_sources) / 2; node > 0; node /= 2) {
+      if (scru128_merge_precedes(runs, m->_tree[node], winner)) {
+        size_t tmp = m->_tree[node];
+        m->_tree[node] = winner;
+        winner = tmp;
+      }
+    }
+    m->_tree[0] = winner;
+  }
+  return (ptrdiff_t)count;
+}
+
+#ifdef SCRU128_ENABLE_THREADS
+/**
+ * Represents a subrange of IDs sorted by a thread of `scru128_sort_parallel()`.
+ *
+ * @private
+ */
+typedef struct Scru128SortTask {
+  uint8_t *ids;
+  uint8_t *scratch;
+  size_t n;
+  int byte;
+} Scru128SortTask;
+
+/**
+ * Represents the list of tasks shared by the threads of
+ * `scru128_sort_parallel()`.
+ *
+ * @private
+ */
+typedef struct Scru128SortQueue {
+  Scru128SortTask *tasks;
+  size_t n_tasks;
+  size_t capacity;
+
+  /** The index of the next task to take, protected by `mutex`. */
+  size_t next;
+  pthread_mutex_t mutex;
+} Scru128SortQueue;
+
+/**
+ * Partitions the IDs serially until each subrange has at most `grain` IDs and
+ * adds the subranges to `queue`, or sorts a subrange immediately if the queue
+ * cannot grow.
+ *
+ * @private
+ */
+static inline void scru128_sort_split(Scru128SortQueue *queue, uint8_t *ids,
+                                      uint8_t *scratch, size_t n, int byte,
+                                      size_t grain) {
+  if (n <= grain || n <= SCRU128_SORT_INSERTION_THRESHOLD) {
+    if (queue->n_tasks == queue->capacity) {
+      size_t capacity = queue->capacity == 0 ? 256 : queue->capacity * 2;
+      Scru128SortTask *tasks = (Scru128SortTask *)realloc(
+          queue->tasks, capacity * sizeof(Scru128SortTask));
+      if (tasks == NULL) {
+        scru128_sort_core(ids, scratch, n, byte);
+        return;
+      }
+      queue->tasks = tasks;
+      queue->capacity = capacity;
+    }
+    Scru128SortTask task = {ids, scratch, n, byte};
+    queue->tasks[queue->n_tasks++] = task;
+    return;
+  }
+
+  size_t counts[256];
+  byte = scru128_sort_partition(ids, scratch, n, byte, counts);
+  if (byte < SCRU128_LEN - 1) {
+    for (size_t d = 0, start = 0; d < 256; start += counts[d++]) {
+      if (counts[d] > 1) {
+        scru128_sort_split(queue, ids + SCRU128_LEN * start,
+                           scratch == NULL ? NULL
+                                           : scratch + SCRU128_LEN * start,
+                           counts[d], byte + 1, grain);
+      }
+    }
+  }
+}
+
+/**
+ * Takes and runs tasks from the queue until it is exhausted.
+ *
+ * @private
+ */
+static inline void *scru128_sort_worker(void *arg) {
+  Scru128SortQueue *queue = (Scru128SortQueue *)arg;
+  for (;;) {
+    pthread_mutex_lock(&queue->mutex);
+    size_t i = queue->next++;
+    pthread_mutex_unlock(&queue->mutex);
+    if (i >= queue->n_tasks) {
+      return NULL;
+    }
+    Scru128SortTask *task = &queue->tasks[i];
+    scru128_sort_core(task->ids, task->scratch, task->n, task->byte);
+  }
+}
+
+/**
+ * Sorts an array of SCRU128 IDs in ascending order using multiple threads.
+ *
+ * The calling thread partitions the array by the leading varying bytes until
+ * each subrange is small enough, and then `n_threads` threads (including the
+ * calling thread) sort the subranges independently. Small arrays are sorted by
+ * the calling thread alone, and if a thread cannot be created, the remaining
+ * threads take over its share.
+ *
+ * This function is available if `SCRU128_ENABLE_THREADS` is defined before
+ * including this header.
+ *
+ * @param ids A byte array of `n` 16-byte SCRU128 IDs.
+ * @param n The number of IDs.
+ * @param scratch A byte array of at least `n * SCRU128_LEN` bytes that does not
+ * overlap `ids`, whose content is overwritten, or `NULL` to sort in place.
+ * @param n_threads The number of threads to use.
+ */
+static inline void scru128_sort_parallel(uint8_t *ids, size_t n,
+                                         uint8_t *scratch, int n_threads) {
+  if (n_threads <= 1 || n < ((size_t)1 << 16)) {
+    scru128_sort_core(ids, scratch, n, 0);
+    return;
+  }
+
+  Scru128SortQueue queue;
+  queue.tasks = NULL;
+  queue.n_tasks = 0;
+  queue.capacity = 0;
+  queue.next = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  // split into enough subranges so that threads finish at similar times
+  scru128_sort_split(&queue, ids, scratch, n, 0, n / ((size_t)n_threads * 8));
+
+  pthread_t *threads = (pthread_t *)malloc(
+      (size_t)(n_threads - 1) * sizeof(pthread_t));
+  int n_started = 0;
+  if (threads != NULL) {
+    for (; n_started < n_threads - 1; n_started++) {
+      if (pthread_create(&threads[n_started], NULL, &scru128_sort_worker,
+                         &queue) != 0) {
+        break;
+      }
+    }
+  }
+  scru128_sort_worker(&queue);
+  for (int i = 0; i < n_started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  free(threads);
+  free(queue.tasks);
+  pthread_mutex_destroy(&queue.mutex);
+}
+#endif /* #ifdef SCRU128_ENABLE_THREADS */
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* #ifndef SCRU128_SORT_H_TWQDHJVA */
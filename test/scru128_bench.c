@@ -0,0 +1,246 @@
+#include "scru128.h"
+#include "scru128_codec.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N_IDS 1024
+#define N_ROUNDS 15
+
+static uint8_t ids[N_IDS][SCRU128_LEN];
+static char strs[N_IDS][SCRU128_STR_LEN];
+static uint8_t ids_out[N_IDS][SCRU128_LEN];
+static char strs_out[N_IDS][SCRU128_STR_LEN];
+static struct Fields {
+  uint64_t timestamp;
+  uint32_t counter_hi, counter_lo, entropy;
+} fields[N_IDS];
+
+/** A sorted column of IDs generated at 10 IDs per millisecond for the codec */
+#define N_COLUMN (1 << 16)
+static uint8_t column[N_COLUMN][SCRU128_LEN];
+static uint8_t column_out[N_COLUMN][SCRU128_LEN];
+static uint8_t encoded[SCRU128_CODEC_MAX_ENCODED_SIZE(N_COLUMN)];
+static size_t encoded_len;
+
+/**
+ * The timestamp range of the scans, which covers every ID so that the
+ * compressed scan cannot skip any block
+ */
+static volatile uint64_t scan_min = 0, scan_max = SCRU128_MAX_TIMESTAMP;
+
+/** Accumulates results so that the compiler cannot eliminate the work */
+static volatile uint64_t sink;
+
+static Scru128Generator generator;
+
+/** Returns the value of a monotonic clock in nanoseconds */
+static uint64_t now_ns(void) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
+}
+
+/** Returns the CPU cycle counter, or zero if unavailable */
+static uint64_t now_cycles(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void run_to_str(size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    scru128_to_str(ids[i % N_IDS], strs_out[i % N_IDS]);
+  }
+  sink += (uint8_t)strs_out[0][0];
+}
+
+static void run_to_str_batch(size_t n) {
+  for (size_t i = 0; i < n; i += N_IDS) {
+    scru128_to_str_batch(ids[0], N_IDS, strs_out[0]);
+  }
+  sink += (uint8_t)strs_out[0][0];
+}
+
+static void run_from_str(size_t n) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += (uint64_t)scru128_from_str(ids_out[i % N_IDS], strs[i % N_IDS]);
+  }
+  sink += acc + ids_out[0][0];
+}
+
+static void run_from_str_batch(size_t n) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n; i += N_IDS) {
+    acc += scru128_from_str_batch(ids_out[0], strs[0], N_IDS, SCRU128_STR_LEN,
+                                  NULL);
+  }
+  sink += acc + ids_out[0][0];
+}
+
+static void run_compare(size_t n) {
+  int64_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += scru128_compare(ids[i % N_IDS], ids[(i + 1) % N_IDS]);
+  }
+  sink += (uint64_t)acc;
+}
+
+static void run_from_fields(size_t n) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    const struct Fields *f = &fields[i % N_IDS];
+    acc += (uint64_t)scru128_from_fields(ids_out[i % N_IDS], f->timestamp,
+                                         f->counter_hi, f->counter_lo,
+                                         f->entropy);
+  }
+  sink += acc + ids_out[0][0];
+}
+
+static void run_getters(size_t n) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *id = ids[i % N_IDS];
+    acc += scru128_timestamp(id) + scru128_counter_hi(id) +
+           scru128_counter_lo(id) + scru128_entropy(id);
+  }
+  sink += acc;
+}
+
+static void run_generate(size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    scru128_generate(&generator, ids_out[i % N_IDS]);
+  }
+  sink += ids_out[0][0];
+}
+
+static void run_generate_batch(size_t n) {
+  for (size_t i = 0; i < n; i += N_IDS) {
+    scru128_generate_batch(&generator, ids_out[0], N_IDS);
+  }
+  sink += ids_out[0][0];
+}
+
+static void run_scan_raw(size_t n) {
+  uint64_t ts_min = scan_min, ts_max = scan_max, acc = 0;
+  for (size_t i = 0; i < n; i += N_COLUMN) {
+    for (size_t j = 0; j < N_COLUMN; j++) {
+      uint64_t timestamp = scru128_timestamp(column[j]);
+      acc += timestamp >= ts_min && timestamp <= ts_max;
+    }
+  }
+  sink += acc;
+}
+
+static void run_scan_codec(size_t n) {
+  uint64_t ts_min = scan_min, ts_max = scan_max, acc = 0;
+  for (size_t i = 0; i < n; i += N_COLUMN) {
+    acc += (uint64_t)scru128_codec_count_range(encoded, encoded_len, ts_min,
+                                               ts_max);
+  }
+  sink += acc;
+}
+
+static void run_decode_codec(size_t n) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < n; i += N_COLUMN) {
+    acc += (uint64_t)scru128_codec_decode(encoded, encoded_len, column_out[0],
+                                          N_COLUMN);
+  }
+  sink += acc + column_out[0][0];
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+/**
+ * Measures `fn` for `N_ROUNDS` rounds of `n_ops` operations after a warmup
+ * round and reports the median, minimum, and standard deviation of ns/op and
+ * the median cycles/op.
+ */
+static void bench(const char *name, void (*fn)(size_t), size_t n_ops) {
+  double ns[N_ROUNDS], cycles[N_ROUNDS];
+  fn(n_ops); // warmup
+  for (int r = 0; r < N_ROUNDS; r++) {
+    uint64_t t0 = now_ns(), c0 = now_cycles();
+    fn(n_ops);
+    uint64_t c1 = now_cycles(), t1 = now_ns();
+    ns[r] = (double)(t1 - t0) / (double)n_ops;
+    cycles[r] = (double)(c1 - c0) / (double)n_ops;
+  }
+
+  double mean = 0, var = 0;
+  for (int r = 0; r < N_ROUNDS; r++) {
+    mean += ns[r] / N_ROUNDS;
+  }
+  for (int r = 0; r < N_ROUNDS; r++) {
+    var += (ns[r] - mean) * (ns[r] - mean) / (N_ROUNDS - 1);
+  }
+  qsort(ns, N_ROUNDS, sizeof(double), &compare_doubles);
+  qsort(cycles, N_ROUNDS, sizeof(double), &compare_doubles);
+
+  printf("  %-24s %9.2f %9.2f %8.2f", name, ns[N_ROUNDS / 2], ns[0], sqrt(var));
+  if (cycles[N_ROUNDS / 2] > 0) {
+    printf(" %10.1f\n", cycles[N_ROUNDS / 2]);
+  } else {
+    printf(" %10s\n", "-");
+  }
+}
+
+int main(int argc, char *argv[]) {
+#ifdef __cplusplus
+  const char *lang = "C++";
+#else
+  const char *lang = "C";
+#endif
+  printf("%s (%s, %s):\n", __FILE__, lang, argc > 1 ? argv[1] : "");
+
+  scru128_generator_init(&generator);
+  for (int i = 0; i < N_IDS; i++) {
+    if (scru128_generate(&generator, ids[i]) < 0) {
+      fprintf(stderr, "error: failed to generate IDs\n");
+      return 1;
+    }
+    scru128_to_str(ids[i], strs[i]);
+    fields[i].timestamp = scru128_timestamp(ids[i]);
+    fields[i].counter_hi = scru128_counter_hi(ids[i]);
+    fields[i].counter_lo = scru128_counter_lo(ids[i]);
+    fields[i].entropy = scru128_entropy(ids[i]);
+  }
+
+  Scru128Generator column_generator;
+  scru128_generator_init(&column_generator);
+  for (int i = 0; i < N_COLUMN; i++) {
+    if (scru128_generate_or_reset_core(&column_generator, column[i],
+                                       0x0123456789ab + (uint64_t)i / 10,
+                                       &arc4random, 10000) < 0) {
+      fprintf(stderr, "error: failed to generate IDs\n");
+      return 1;
+    }
+  }
+  encoded_len = scru128_codec_encode(column[0], N_COLUMN, encoded, NULL);
+
+  printf("  %-24s %9s %9s %8s %10s\n", "operation", "ns/op", "min", "stddev",
+         "cycles/op");
+  bench("scru128_to_str", &run_to_str, 1 << 20);
+  bench("scru128_to_str_batch", &run_to_str_batch, 1 << 20);
+  bench("scru128_from_str", &run_from_str, 1 << 20);
+  bench("scru128_from_str_batch", &run_from_str_batch, 1 << 20);
+  bench("scru128_compare", &run_compare, 1 << 24);
+  bench("scru128_from_fields", &run_from_fields, 1 << 22);
+  bench("field getters", &run_getters, 1 << 22);
+  bench("timestamp scan (raw)", &run_scan_raw, 1 << 24);
+  bench("timestamp scan (codec)", &run_scan_codec, 1 << 24);
+  bench("scru128_codec_decode", &run_decode_codec, 1 << 22);
+  bench("scru128_generate", &run_generate, 1 << 20);
+  bench("scru128_generate_batch", &run_generate_batch, 1 << 20);
+  return 0;
+}
@@ -0,0 +1,255 @@
+#include "scru128.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_THREADS 256
+
+/** The number of sub-buckets per power of two in latency histograms */
+#define HIST_SUB_BITS 4
+#define HIST_N_BUCKETS 1024
+
+typedef struct Worker Worker;
+
+/** Mints one ID through the generator under test */
+typedef int (*GenerateFn)(Worker *w, uint8_t *id_out);
+
+struct Worker {
+  pthread_t thread;
+  GenerateFn generate;
+  Scru128Generator generator;
+  uint8_t (*results)[SCRU128_LEN];
+  uint64_t histogram[HIST_N_BUCKETS];
+  int n_errors;
+};
+
+static int n_threads = 8;
+static int n_per_thread = 200000;
+
+static Worker workers[MAX_THREADS];
+static uint8_t (*all_results)[SCRU128_LEN];
+static pthread_barrier_t start_barrier;
+
+static Scru128Generator mutex_generator;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static Scru128AtomicGenerator atomic_generator;
+static __thread Scru128CounterBlock thread_block;
+
+/** Returns the value of a monotonic clock in nanoseconds */
+static uint64_t now_ns(void) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
+}
+
+/**
+ * Returns the log-linear histogram bucket of `ns`: values below 32 have their
+ * own buckets, and each power of two above is split into 16 sub-buckets, so
+ * the relative error of reported percentiles is at most 1/16.
+ */
+static int bucket_of(uint64_t ns) {
+  if (ns < 2u << HIST_SUB_BITS) {
+    return (int)ns;
+  }
+  int shift = 63 - __builtin_clzll(ns) - HIST_SUB_BITS;
+  return (shift + 1) * (1 << HIST_SUB_BITS) +
+         (int)(ns >> shift) - (1 << HIST_SUB_BITS);
+}
+
+/** Returns the smallest value that falls into `bucket` */
+static uint64_t bucket_floor(int bucket) {
+  if (bucket < 2 << HIST_SUB_BITS) {
+    return (uint64_t)bucket;
+  }
+  int shift = bucket / (1 << HIST_SUB_BITS) - 1;
+  int sub = bucket % (1 << HIST_SUB_BITS) + (1 << HIST_SUB_BITS);
+  return (uint64_t)sub << shift;
+}
+
+/** Returns the value at quantile `q` of merged histogram `hist` */
+static uint64_t percentile(const uint64_t *hist, uint64_t total, double q) {
+  uint64_t rank = (uint64_t)(q * (double)total), seen = 0;
+  for (int i = 0; i < HIST_N_BUCKETS; i++) {
+    seen += hist[i];
+    if (seen > rank) {
+      return bucket_floor(i);
+    }
+  }
+  return bucket_floor(HIST_N_BUCKETS - 1);
+}
+
+static int generate_mutex(Worker *w, uint8_t *id_out) {
+  (void)w;
+  pthread_mutex_lock(&mutex);
+  int status = scru128_generate(&mutex_generator, id_out);
+  pthread_mutex_unlock(&mutex);
+  return status;
+}
+
+static int generate_per_thread(Worker *w, uint8_t *id_out) {
+  return scru128_generate(&w->generator, id_out);
+}
+
+static int generate_atomic(Worker *w, uint8_t *id_out) {
+  (void)w;
+  return scru128_atomic_generate(&atomic_generator, id_out);
+}
+
+static int generate_block(Worker *w, uint8_t *id_out) {
+  (void)w;
+  if (scru128_counter_block_generate(&thread_block, id_out, &arc4random) == 0) {
+    return SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+  }
+  int status =
+      scru128_atomic_generator_reserve(&atomic_generator, 64, &thread_block);
+  if (status >= 0) {
+    scru128_counter_block_generate(&thread_block, id_out, &arc4random);
+  }
+  return status;
+}
+
+static int generate_tls(Worker *w, uint8_t *id_out) {
+  (void)w;
+  return scru128_generate_tls(id_out);
+}
+
+static int generate_tls_ordered(Worker *w, uint8_t *id_out) {
+  (void)w;
+  return scru128_generate_tls_ordered(id_out);
+}
+
+static void *run_worker(void *arg) {
+  Worker *w = (Worker *)arg;
+  pthread_barrier_wait(&start_barrier);
+  uint64_t prev = now_ns();
+  for (int i = 0; i < n_per_thread; i++) {
+    if ((*w->generate)(w, w->results[i]) < 0) {
+      w->n_errors++;
+    }
+    uint64_t curr = now_ns();
+    w->histogram[bucket_of(curr - prev)]++;
+    prev = curr;
+  }
+  return NULL;
+}
+
+static int compare_ids(const void *lft, const void *rgt) {
+  return scru128_compare((const uint8_t *)lft, (const uint8_t *)rgt);
+}
+
+/**
+ * Checks that each thread received increasing IDs and that no ID was minted
+ * twice across threads, returning the number of violations found.
+ */
+static long check_results(void) {
+  long n_violations = 0;
+  for (int t = 0; t < n_threads; t++) {
+    n_violations += workers[t].n_errors;
+    for (int i = 1; i < n_per_thread; i++) {
+      if (scru128_compare(workers[t].results[i - 1], workers[t].results[i]) >=
+          0) {
+        n_violations++;
+      }
+    }
+  }
+
+  size_t n = (size_t)n_threads * (size_t)n_per_thread;
+  qsort(all_results, n, SCRU128_LEN, &compare_ids);
+  for (size_t i = 1; i < n; i++) {
+    if (scru128_compare(all_results[i - 1], all_results[i]) == 0) {
+      n_violations++;
+    }
+  }
+  return n_violations;
+}
+
+/** Mints IDs with `generate` from all threads and reports the results */
+static long run(const char *name, GenerateFn generate) {
+  pthread_barrier_init(&start_barrier, NULL, (unsigned)n_threads + 1);
+  for (int t = 0; t < n_threads; t++) {
+    Worker *w = &workers[t];
+    memset(w->histogram, 0, sizeof(w->histogram));
+    w->n_errors = 0;
+    w->generate = generate;
+    w->results = all_results + (size_t)t * (size_t)n_per_thread;
+    scru128_generator_init(&w->generator);
+    if (pthread_create(&w->thread, NULL, &run_worker, w) != 0) {
+      fprintf(stderr, "error: failed to create thread\n");
+      exit(1);
+    }
+  }
+
+  pthread_barrier_wait(&start_barrier);
+  uint64_t start = now_ns();
+  for (int t = 0; t < n_threads; t++) {
+    pthread_join(workers[t].thread, NULL);
+  }
+  uint64_t elapsed = now_ns() - start;
+  pthread_barrier_destroy(&start_barrier);
+
+  static uint64_t merged[HIST_N_BUCKETS];
+  memset(merged, 0, sizeof(merged));
+  for (int t = 0; t < n_threads; t++) {
+    for (int i = 0; i < HIST_N_BUCKETS; i++) {
+      merged[i] += workers[t].histogram[i];
+    }
+  }
+
+  uint64_t total = (uint64_t)n_threads * (uint64_t)n_per_thread;
+  long n_violations = check_results();
+  printf("  %-20s %10.2f %8.0f %8.0f %8.0f %6s\n", name,
+         (double)total * 1e3 / (double)elapsed,
+         (double)percentile(merged, total, 0.5),
+         (double)percentile(merged, total, 0.99),
+         (double)percentile(merged, total, 0.999),
+         n_violations == 0 ? "ok" : "FAILED");
+  return n_violations;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    n_threads = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    n_per_thread = atoi(argv[2]);
+  }
+  if (n_threads < 1 || n_threads > MAX_THREADS || n_per_thread < 1) {
+    fprintf(stderr, "usage: %s [n_threads] [n_per_thread]\n", argv[0]);
+    return 1;
+  }
+
+#ifdef __cplusplus
+  const char *lang = "C++";
+#else
+  const char *lang = "C";
+#endif
+  printf("%s (%s, %d threads x %d IDs):\n", __FILE__, lang, n_threads,
+         n_per_thread);
+
+  all_results = (uint8_t(*)[SCRU128_LEN])malloc(
+      (size_t)n_threads * (size_t)n_per_thread * SCRU128_LEN);
+  if (all_results == NULL) {
+    fprintf(stderr, "error: failed to allocate memory\n");
+    return 1;
+  }
+
+  scru128_generator_init(&mutex_generator);
+  scru128_atomic_generator_init(&atomic_generator);
+
+  // latencies include the overhead of a `clock_gettime()` call per ID
+  printf("  %-20s %10s %8s %8s %8s %6s\n", "generator", "Mops/s", "p50 ns",
+         "p99 ns", "p999 ns", "check");
+  long n_violations = 0;
+  n_violations += run("mutex", &generate_mutex);
+  n_violations += run("per-thread", &generate_per_thread);
+  n_violations += run("atomic", &generate_atomic);
+  n_violations += run("atomic+block", &generate_block);
+  n_violations += run("tls", &generate_tls);
+  n_violations += run("tls_ordered", &generate_tls_ordered);
+
+  free(all_results);
+  return n_violations == 0 ? 0 : 1;
+}
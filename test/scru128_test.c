@@ -1,8 +1,14 @@
 #include "scru128.h"
+#include "scru128_clock.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define N_SAMPLES 100000
 static char samples[N_SAMPLES][32];
@@ -50,6 +56,236 @@ void test_timestamp_and_counters(void) {
   }
 }
 
+/** Generates increasing IDs in batch */
+void test_batch(void) {
+  static uint8_t ids[N_SAMPLES][SCRU128_LEN];
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  int status = scru128_generate_batch(&g, ids[0], N_SAMPLES / 2);
+  assert(status >= 0);
+  status = scru128_generate_batch(&g, ids[N_SAMPLES / 2], N_SAMPLES / 2);
+  assert(status >= 0);
+  for (int i = 1; i < N_SAMPLES; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+
+  uint8_t next[SCRU128_LEN];
+  status = scru128_generate(&g, next);
+  assert(status >= 0);
+  assert(scru128_compare(ids[N_SAMPLES - 1], next) < 0);
+}
+
+#define N_THREADS 4
+#define N_PER_THREAD 50000
+static uint8_t thread_results[N_THREADS][N_PER_THREAD][SCRU128_LEN];
+
+struct Worker {
+  pthread_t thread;
+  int (*generate)(uint8_t *);
+  uint8_t (*results)[SCRU128_LEN];
+};
+
+void *run_worker(void *arg) {
+  struct Worker *w = (struct Worker *)arg;
+  for (int i = 0; i < N_PER_THREAD; i++) {
+    int status = (*w->generate)(w->results[i]);
+    assert(status >= 0);
+  }
+  return NULL;
+}
+
+int compare_ids(const void *lft, const void *rgt) {
+  return scru128_compare((const uint8_t *)lft, (const uint8_t *)rgt);
+}
+
+void check_results(void);
+
+/** Runs `generate` concurrently and checks the monotonicity and uniqueness */
+void run_threads(int (*generate)(uint8_t *)) {
+  struct Worker workers[N_THREADS];
+  for (int i = 0; i < N_THREADS; i++) {
+    workers[i].generate = generate;
+    workers[i].results = thread_results[i];
+    int err =
+        pthread_create(&workers[i].thread, NULL, &run_worker, &workers[i]);
+    assert(err == 0);
+  }
+  for (int i = 0; i < N_THREADS; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  check_results();
+}
+
+/** Checks the monotonicity and uniqueness of `thread_results` */
+void check_results(void) {
+  for (int i = 0; i < N_THREADS; i++) {
+    for (int j = 1; j < N_PER_THREAD; j++) {
+      assert(scru128_compare(thread_results[i][j - 1], thread_results[i][j]) <
+             0);
+    }
+  }
+
+  qsort(thread_results, N_THREADS * N_PER_THREAD, SCRU128_LEN, &compare_ids);
+  uint8_t(*all)[SCRU128_LEN] = thread_results[0];
+  for (int i = 1; i < N_THREADS * N_PER_THREAD; i++) {
+    assert(scru128_compare(all[i - 1], all[i]) < 0);
+  }
+}
+
+static Scru128AtomicGenerator shared_generator;
+
+int generate_shared(uint8_t *id_out) {
+  return scru128_atomic_generate(&shared_generator, id_out);
+}
+
+/** Generates unique, increasing IDs concurrently with lock-free generator */
+void test_atomic_generator(void) {
+  scru128_atomic_generator_init(&shared_generator);
+  run_threads(&generate_shared);
+
+  uint8_t(*all)[SCRU128_LEN] = thread_results[0];
+  for (int i = 1; i < N_THREADS * N_PER_THREAD; i++) {
+    uint8_t *prev = all[i - 1], *curr = all[i];
+    // timestamp and counters are unique even without entropy
+    assert(scru128_timestamp(prev) < scru128_timestamp(curr) ||
+           scru128_counter_hi(prev) < scru128_counter_hi(curr) ||
+           scru128_counter_lo(prev) < scru128_counter_lo(curr));
+  }
+}
+
+static __thread Scru128CounterBlock thread_block;
+
+static uint32_t zero_entropy(void) { return 0; }
+
+int generate_from_block(uint8_t *id_out) {
+  if (scru128_counter_block_generate(&thread_block, id_out, &zero_entropy) ==
+      0) {
+    return SCRU128_GENERATOR_STATUS_COUNTER_LO_INC;
+  }
+  int status =
+      scru128_atomic_generator_reserve(&shared_generator, 64, &thread_block);
+  if (status >= 0) {
+    scru128_counter_block_generate(&thread_block, id_out, &zero_entropy);
+  }
+  return status;
+}
+
+/** Generates unique IDs concurrently from blocks reserved by each thread */
+void test_counter_block(void) {
+  scru128_atomic_generator_init(&shared_generator);
+  run_threads(&generate_from_block);
+
+  uint8_t(*all)[SCRU128_LEN] = thread_results[0];
+  for (int i = 0; i < N_THREADS * N_PER_THREAD; i++) {
+    assert(scru128_entropy(all[i]) == 0);
+  }
+}
+
+/** Generates unique IDs concurrently with per-thread generators */
+void test_tls_generator(void) {
+  run_threads(&scru128_generate_tls);
+  run_threads(&scru128_generate_tls_ordered);
+
+  // IDs generated later never have smaller timestamp in ordered mode
+  uint8_t before[SCRU128_LEN], after[SCRU128_LEN];
+  int status = scru128_generate_tls_ordered(before);
+  assert(status >= 0);
+  struct Worker w;
+  w.generate = &scru128_generate_tls_ordered;
+  w.results = thread_results[0];
+  pthread_create(&w.thread, NULL, &run_worker, &w);
+  pthread_join(w.thread, NULL);
+  status = scru128_generate_tls_ordered(after);
+  assert(status >= 0);
+  for (int i = 0; i < N_PER_THREAD; i++) {
+    uint64_t timestamp = scru128_timestamp(thread_results[0][i]);
+    assert(scru128_timestamp(before) <= timestamp);
+    assert(timestamp <= scru128_timestamp(after));
+  }
+
+#ifdef SCRU128_ENABLE_STATS
+  // the generator of the calling thread counts its own calls only
+  Scru128GeneratorStats stats;
+  scru128_tls_generator_stats(&stats);
+  assert(stats.n_new_timestamp + stats.n_counter_lo_inc +
+             stats.n_counter_hi_inc + stats.n_timestamp_inc +
+             stats.n_rollback_reset ==
+         2);
+  assert(stats.n_rng_calls >= 2);
+#endif
+}
+
+/** Generates unique, increasing IDs across processes with shared generator */
+void test_shared_generator(void) {
+  char name[64];
+  sprintf(name, "/scru128-test-%d", (int)getpid());
+  shm_unlink(name);
+
+  // let child processes write results to shared memory
+  void *addr = mmap(NULL, sizeof(thread_results), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  assert(addr != MAP_FAILED);
+  uint8_t(*results)[N_PER_THREAD][SCRU128_LEN] =
+      (uint8_t(*)[N_PER_THREAD][SCRU128_LEN])addr;
+
+  pid_t children[N_THREADS];
+  for (int i = 0; i < N_THREADS; i++) {
+    children[i] = fork();
+    assert(children[i] >= 0);
+    if (children[i] == 0) {
+      Scru128AtomicGenerator *g = scru128_shared_generator_open(name);
+      for (int j = 0; g != NULL && j < N_PER_THREAD; j++) {
+        if (scru128_atomic_generate(g, results[i][j]) < 0) {
+          _exit(1);
+        }
+      }
+      _exit(g == NULL ? 1 : 0);
+    }
+  }
+  for (int i = 0; i < N_THREADS; i++) {
+    int wstatus;
+    waitpid(children[i], &wstatus, 0);
+    assert(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0);
+  }
+
+  // the shared generator goes on after the children exit
+  Scru128AtomicGenerator *g = scru128_shared_generator_open(name);
+  assert(g != NULL);
+  uint8_t next[SCRU128_LEN];
+  int status = scru128_atomic_generate(g, next);
+  assert(status >= 0);
+  for (int i = 0; i < N_THREADS; i++) {
+    assert(scru128_compare(results[i][N_PER_THREAD - 1], next) < 0);
+  }
+  scru128_shared_generator_close(g);
+  shm_unlink(name);
+
+  memcpy(thread_results, results, sizeof(thread_results));
+  munmap(addr, sizeof(thread_results));
+  check_results();
+}
+
+static uint64_t fixed_clock_now(void *ctx) { return *(uint64_t *)ctx; }
+
+/** Obtains timestamp from clock set by scru128_set_clock() */
+void test_clock_hook(void) {
+  uint64_t ts = 0x0123456789ab;
+  Scru128Clock fixed = {&ts, &fixed_clock_now};
+  scru128_set_clock(&fixed);
+
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  uint8_t id[SCRU128_LEN];
+  assert(scru128_generate(&g, id) >= 0);
+  assert(scru128_timestamp(id) == ts);
+
+  Scru128Clock realtime = {NULL, &scru128_clock_realtime};
+  scru128_set_clock(&realtime);
+  uint64_t now = scru128_clock_realtime(NULL);
+  assert(scru128_generate(&g, id) >= 0);
+  assert(scru128_timestamp(id) >= now && scru128_timestamp(id) - now < 1000);
+}
+
 #define run_test(NAME)                                                         \
   do {                                                                         \
     (NAME)();                                                                  \
@@ -62,5 +298,11 @@ int main(void) {
   run_test(test_format);
   run_test(test_order);
   run_test(test_timestamp_and_counters);
+  run_test(test_batch);
+  run_test(test_atomic_generator);
+  run_test(test_counter_block);
+  run_test(test_tls_generator);
+  run_test(test_shared_generator);
+  run_test(test_clock_hook);
   return 0;
 }
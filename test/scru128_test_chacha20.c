@@ -0,0 +1,105 @@
+#include "scru128_chacha20.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static int n_getentropy_calls = 0;
+
+/** Returns a fixed seed */
+int getentropy_mock(void *buf, size_t nbytes) {
+  n_getentropy_calls++;
+  memset(buf, 0x42, nbytes);
+  return 0;
+}
+
+/** Returns an error */
+int getentropy_error(void *buf, size_t nbytes) {
+  (void)buf;
+  (void)nbytes;
+  return -1;
+}
+
+/** Computes test vector of RFC 8439 section 2.3.2 */
+void test_block_function(void) {
+  static const uint8_t expected[64] = {
+      0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd,
+      0x1f, 0xa3, 0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0,
+      0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2,
+      0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05,
+      0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e,
+      0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e,
+  };
+  const uint32_t key[8] = {0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c,
+                           0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c};
+  const uint32_t nonce[3] = {0x09000000, 0x4a000000, 0x00000000};
+
+  uint8_t out[64 * SCRU128_CHACHA20_LANES];
+  scru128_chacha20_blocks(out, key, 1, nonce);
+  assert(memcmp(out, expected, 64) == 0);
+
+  // subsequent lanes compute subsequent blocks
+  uint8_t next[64 * SCRU128_CHACHA20_LANES];
+  scru128_chacha20_blocks(next, key, 2, nonce);
+  assert(memcmp(out + 64, next, 64) == 0);
+}
+
+/** Produces the same stream regardless of read sizes */
+void test_read_sizes(void) {
+  static uint8_t a[5000], b[5000];
+  Scru128ChaCha20 rng;
+
+  scru128_chacha20_init(&rng);
+  int err = scru128_chacha20_buf(&rng, a, sizeof(a), &getentropy_mock);
+  assert(err == 0);
+
+  scru128_chacha20_init(&rng);
+  for (size_t i = 0; i < sizeof(b); i += 7) {
+    size_t n = sizeof(b) - i < 7 ? sizeof(b) - i : 7;
+    err = scru128_chacha20_buf(&rng, b + i, n, &getentropy_mock);
+    assert(err == 0);
+  }
+  assert(memcmp(a, b, sizeof(a)) == 0);
+
+  // keystream does not repeat itself across buffer refills
+  for (size_t i = 0; i + SCRU128_CHACHA20_BUF_LEN + 16 <= sizeof(a);
+       i += SCRU128_CHACHA20_BUF_LEN) {
+    assert(memcmp(a + i, a + i + SCRU128_CHACHA20_BUF_LEN, 16) != 0);
+  }
+}
+
+/** Reseeds itself periodically */
+void test_reseed(void) {
+  static uint8_t buf[SCRU128_CHACHA20_RESEED_INTERVAL / 4];
+  Scru128ChaCha20 rng;
+  scru128_chacha20_init(&rng);
+
+  n_getentropy_calls = 0;
+  for (int i = 0; i < 4; i++) {
+    int err = scru128_chacha20_buf(&rng, buf, sizeof(buf), &getentropy_mock);
+    assert(err == 0);
+  }
+  assert(n_getentropy_calls == 1);
+
+  int err = scru128_chacha20_buf(&rng, buf, 1, &getentropy_mock);
+  assert(err == 0);
+  assert(n_getentropy_calls == 2);
+
+  scru128_chacha20_init(&rng);
+  err = scru128_chacha20_buf(&rng, buf, 1, &getentropy_error);
+  assert(err != 0);
+}
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s:\n", __FILE__);
+  run_test(test_block_function);
+  run_test(test_read_sizes);
+  run_test(test_reseed);
+  return 0;
+}
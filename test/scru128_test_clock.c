@@ -0,0 +1,122 @@
+#include "scru128_clock.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+/** Returns the absolute difference between two timestamps */
+uint64_t distance(uint64_t a, uint64_t b) { return a > b ? a - b : b - a; }
+
+/** Sleeps for `ms` milliseconds */
+void sleep_ms(long ms) {
+  struct timespec tp;
+  tp.tv_sec = ms / 1000;
+  tp.tv_nsec = (ms % 1000) * 1000000;
+  nanosleep(&tp, NULL);
+}
+
+/** Reads the coarse clock close to the precise one */
+void test_realtime_coarse(void) {
+  Scru128Clock precise = {NULL, &scru128_clock_realtime};
+  Scru128Clock coarse = {NULL, &scru128_clock_realtime_coarse};
+  for (int i = 0; i < 1000; i++) {
+    uint64_t a = scru128_clock_now(&coarse);
+    uint64_t b = scru128_clock_now(&precise);
+    assert(a > 0 && b > 0);
+    assert(distance(a, b) < 50);
+  }
+}
+
+#ifdef SCRU128_HAS_ATOMIC_CLOCK
+/** Publishes the current time from a ticker thread */
+void test_ticker(void) {
+  Scru128Ticker ticker;
+  assert(scru128_ticker_start(&ticker) == 0);
+  Scru128Clock clock = {&ticker, &scru128_ticker_now};
+
+  uint64_t prev = scru128_clock_now(&clock);
+  assert(distance(prev, scru128_clock_realtime(NULL)) < 50);
+  for (int i = 0; i < 10; i++) {
+    sleep_ms(5);
+    uint64_t curr = scru128_clock_now(&clock);
+    assert(curr >= prev);
+    assert(distance(curr, scru128_clock_realtime(NULL)) < 50);
+    prev = curr;
+  }
+  assert(prev > 0);
+  scru128_ticker_stop(&ticker);
+}
+
+/** Follows the system clock without going backward */
+void test_anchored_clock(void) {
+  Scru128AnchoredClock anchored;
+  assert(scru128_anchored_clock_init(&anchored, 500) == 0);
+  Scru128Clock clock = {&anchored, &scru128_anchored_clock_now};
+
+  uint64_t prev = scru128_clock_now(&clock);
+  for (int i = 0; i < 1000; i++) {
+    uint64_t curr = scru128_clock_now(&clock);
+    assert(curr >= prev);
+    assert(distance(curr, scru128_clock_realtime(NULL)) < 50);
+    prev = curr;
+  }
+}
+
+/** Slews out a backward step and catches up with a forward step at once */
+void test_anchored_clock_sync(void) {
+  Scru128AnchoredClock anchored;
+  assert(scru128_anchored_clock_init(&anchored, 500) == 0);
+  int64_t offset = anchored._offset_ns;
+  uint64_t mono_ns = anchored._last_sync_ns;
+
+  // system clock stepped back by 1 s: reduce offset by 500 us per second
+  for (int i = 1; i <= 10; i++) {
+    mono_ns += 1000000000;
+    scru128_anchored_clock_sync(&anchored, mono_ns,
+                                mono_ns + offset - 1000000000);
+    assert(anchored._offset_ns == offset - 500000 * i);
+  }
+
+  // system clock stepped forward: follow immediately
+  mono_ns += 1000000000;
+  scru128_anchored_clock_sync(&anchored, mono_ns, mono_ns + offset + 5000000);
+  assert(anchored._offset_ns == offset + 5000000);
+}
+#endif /* #ifdef SCRU128_HAS_ATOMIC_CLOCK */
+
+#ifdef SCRU128_HAS_TSC_CLOCK
+/** Extrapolates the current time from the time-stamp counter */
+void test_tsc_clock(void) {
+  Scru128TscClock tsc;
+  assert(scru128_tsc_clock_init(&tsc, 10) == 0);
+  Scru128Clock clock = {&tsc, &scru128_tsc_clock_now};
+
+  uint64_t prev = scru128_clock_now(&clock);
+  for (int i = 0; i < 10; i++) {
+    sleep_ms(5);
+    uint64_t curr = scru128_clock_now(&clock);
+    assert(curr >= prev);
+    assert(distance(curr, scru128_clock_realtime(NULL)) < 50);
+    prev = curr;
+  }
+}
+#endif /* #ifdef SCRU128_HAS_TSC_CLOCK */
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s:\n", __FILE__);
+  run_test(test_realtime_coarse);
+#ifdef SCRU128_HAS_ATOMIC_CLOCK
+  run_test(test_ticker);
+  run_test(test_anchored_clock);
+  run_test(test_anchored_clock_sync);
+#endif
+#ifdef SCRU128_HAS_TSC_CLOCK
+  run_test(test_tsc_clock);
+#endif
+  return 0;
+}
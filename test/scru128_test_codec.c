@@ -0,0 +1,251 @@
+#include "scru128_codec.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_IDS 100000
+
+static uint8_t ids[N_IDS * SCRU128_LEN];
+static uint8_t decoded[N_IDS * SCRU128_LEN];
+static uint8_t encoded[SCRU128_CODEC_MAX_ENCODED_SIZE(N_IDS)];
+static size_t offsets[N_IDS / SCRU128_CODEC_BLOCK_LEN + 1];
+
+int compare_ids(const void *lft, const void *rgt) {
+  return scru128_compare((const uint8_t *)lft, (const uint8_t *)rgt);
+}
+
+/**
+ * Generates `N_IDS` sorted IDs with `n_per_ms` IDs per millisecond from a
+ * single generator
+ */
+void generate_ids(uint64_t n_per_ms) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  uint64_t timestamp = 0x0123456789ab;
+  for (size_t i = 0; i < N_IDS; i++) {
+    if (i % n_per_ms == 0) {
+      timestamp++;
+    }
+    int status = scru128_generate_or_reset_core(&g, ids + SCRU128_LEN * i,
+                                                timestamp, &arc4random, 10000);
+    assert(status >= 0);
+  }
+}
+
+/** Returns a random timestamp near that of a random ID in `ids` */
+uint64_t pick_timestamp(void) {
+  uint64_t timestamp =
+      scru128_timestamp(ids + SCRU128_LEN * arc4random_uniform(N_IDS));
+  return timestamp + arc4random_uniform(5) - 2;
+}
+
+/** Filters `size` bytes of encoded `ids` by random ranges of timestamp */
+void check_scan(size_t size) {
+  for (int k = 0; k < 20; k++) {
+    uint64_t ts_min = pick_timestamp(), ts_max = pick_timestamp();
+    if (k == 0) {
+      ts_min = 0;
+      ts_max = SCRU128_MAX_TIMESTAMP;
+    }
+
+    size_t expected = 0;
+    for (size_t i = 0; i < N_IDS; i++) {
+      uint64_t timestamp = scru128_timestamp(ids + SCRU128_LEN * i);
+      expected += timestamp >= ts_min && timestamp <= ts_max;
+    }
+    assert(scru128_codec_count_range(encoded, size, ts_min, ts_max) ==
+           (ptrdiff_t)expected);
+
+    // each block selects the IDs in the range without the other blocks
+    for (size_t i = 0; i * SCRU128_CODEC_BLOCK_LEN < N_IDS; i++) {
+      uint8_t matches[SCRU128_CODEC_BLOCK_LEN / 8];
+      const uint8_t *block = encoded + offsets[i];
+      ptrdiff_t count = scru128_codec_filter_block(block, size - offsets[i],
+                                                   ts_min, ts_max, matches);
+      ptrdiff_t n_set = 0;
+      for (size_t j = 0; j < SCRU128_CODEC_BLOCK_LEN; j++) {
+        size_t index = SCRU128_CODEC_BLOCK_LEN * i + j;
+        int match = index < N_IDS &&
+                    j < scru128_codec_block_len(block) &&
+                    scru128_timestamp(ids + SCRU128_LEN * index) >= ts_min &&
+                    scru128_timestamp(ids + SCRU128_LEN * index) <= ts_max;
+        assert(((matches[j / 8] >> (j % 8)) & 1) == match);
+        n_set += match;
+      }
+      assert(count == n_set);
+    }
+  }
+}
+
+/** Encodes and decodes `N_IDS` IDs and returns the encoded size */
+size_t check_round_trip(void) {
+  size_t size = scru128_codec_encode(ids, N_IDS, encoded, offsets);
+  assert(size > 0 && size <= sizeof(encoded));
+
+  memset(decoded, 0, sizeof(decoded));
+  assert(scru128_codec_decode(encoded, size, decoded, N_IDS) == N_IDS);
+  assert(memcmp(decoded, ids, sizeof(ids)) == 0);
+
+  // each block is decodable on its own
+  for (size_t i = 0; i * SCRU128_CODEC_BLOCK_LEN < N_IDS; i++) {
+    const uint8_t *block = encoded + offsets[i];
+    const uint8_t *first = ids + SCRU128_LEN * SCRU128_CODEC_BLOCK_LEN * i;
+    size_t n = N_IDS - i * SCRU128_CODEC_BLOCK_LEN;
+    n = n < SCRU128_CODEC_BLOCK_LEN ? n : SCRU128_CODEC_BLOCK_LEN;
+    assert(scru128_codec_block_len(block) == n);
+    assert(memcmp(scru128_codec_block_first(block), first, SCRU128_LEN) == 0);
+    assert(scru128_codec_decode_block(block, size - offsets[i], decoded) ==
+           (ptrdiff_t)n);
+    assert(memcmp(decoded, first, SCRU128_LEN * n) == 0);
+  }
+
+  check_scan(size);
+  return size;
+}
+
+/** Compresses IDs generated at a high rate to about four bytes per ID */
+void test_high_rate(void) {
+  generate_ids(1000);
+  assert(check_round_trip() < (size_t)N_IDS * 5);
+}
+
+/** Compresses IDs generated at a low rate to about seven bytes per ID */
+void test_low_rate(void) {
+  generate_ids(1);
+  assert(check_round_trip() < (size_t)N_IDS * 8);
+}
+
+/** Round-trips sorted random IDs without compression */
+void test_random(void) {
+  arc4random_buf(ids, sizeof(ids));
+  qsort(ids, N_IDS, SCRU128_LEN, &compare_ids);
+  assert(check_round_trip() <= (size_t)N_IDS * SCRU128_LEN);
+}
+
+/** Round-trips edge cases of field values and block lengths */
+void test_edge_cases(void) {
+  uint8_t block[SCRU128_CODEC_MAX_BLOCK_SIZE];
+  uint8_t out[SCRU128_LEN * SCRU128_CODEC_BLOCK_LEN];
+
+  // counters wrapping around and maximum timestamp delta
+  scru128_from_fields(ids, 0, 0xffffff, 0xffffff, 0);
+  scru128_from_fields(ids + 16, 0, 0, 0, 1);
+  scru128_from_fields(ids + 32, SCRU128_MAX_TIMESTAMP, 0xffffff, 0, 2);
+  scru128_from_fields(ids + 48, SCRU128_MAX_TIMESTAMP, 0xffffff, 0, 2);
+  for (size_t n = 1; n <= 4; n++) {
+    size_t size = scru128_codec_encode_block(ids, n, block);
+    assert(size > 0 && size == scru128_codec_block_size(block));
+    assert(scru128_codec_decode_block(block, size, out) == (ptrdiff_t)n);
+    assert(memcmp(out, ids, SCRU128_LEN * n) == 0);
+  }
+
+  // fails if the output buffer is too short
+  size_t size = scru128_codec_encode(ids, 4, encoded, NULL);
+  assert(scru128_codec_decode(encoded, size, decoded, 4) == 4);
+  assert(scru128_codec_decode(encoded, size, decoded, 3) < 0);
+  assert(scru128_codec_decode(encoded, 0, decoded, 3) == 0);
+}
+
+/** Rejects invalid input */
+void test_errors(void) {
+  uint8_t block[SCRU128_CODEC_MAX_BLOCK_SIZE];
+  uint8_t out[SCRU128_LEN * SCRU128_CODEC_BLOCK_LEN];
+
+  // empty, too long, and unsorted input
+  generate_ids(10);
+  assert(scru128_codec_encode_block(ids, 0, block) == 0);
+  assert(scru128_codec_encode_block(ids, SCRU128_CODEC_BLOCK_LEN + 1, block) ==
+         0);
+  uint8_t unsorted[SCRU128_LEN * 2];
+  memcpy(unsorted, ids + SCRU128_LEN * 100, SCRU128_LEN);
+  memcpy(unsorted + SCRU128_LEN, ids, SCRU128_LEN);
+  assert(scru128_codec_encode_block(unsorted, 2, block) == 0);
+  memcpy(encoded, ids, sizeof(ids));
+  memcpy(encoded + SCRU128_LEN * 128, ids, SCRU128_LEN);
+  assert(scru128_codec_encode(encoded, 129, encoded + sizeof(ids), NULL) == 0);
+
+  // truncated blocks
+  size_t size = scru128_codec_encode_block(ids, SCRU128_CODEC_BLOCK_LEN, block);
+  for (size_t len = 0; len < size; len++) {
+    assert(scru128_codec_decode_block(block, len, out) < 0);
+    assert(len == 0 ||
+           scru128_codec_decode(block, len, out, SCRU128_CODEC_BLOCK_LEN) < 0);
+  }
+  assert(scru128_codec_decode_block(block, size, out) ==
+         SCRU128_CODEC_BLOCK_LEN);
+
+  // corrupted blocks never read out of bounds
+  for (int i = 0; i < 10000; i++) {
+    uint8_t corrupted[SCRU128_CODEC_MAX_BLOCK_SIZE];
+    memcpy(corrupted, block, size);
+    corrupted[arc4random_uniform((uint32_t)size)] ^=
+        (uint8_t)(1 + arc4random_uniform(255));
+    scru128_codec_decode_block(corrupted, size, out);
+  }
+}
+
+#ifdef SCRU128_HAS_X86_SIMD
+/** Matches the SSE2 kernels against the scalar ones on random input */
+void test_sse2_kernels(void) {
+  uint8_t packed[16 * 32];
+  uint32_t expected[SCRU128_CODEC_BLOCK_LEN], actual[SCRU128_CODEC_BLOCK_LEN];
+  for (int k = 0; k < 100; k++) {
+    arc4random_buf(packed, sizeof(packed));
+    for (int width = 1; width <= 32; width++) {
+      scru128_codec_unpack_scalar(packed, width, expected);
+      scru128_codec_unpack_sse2(packed, width, actual);
+      assert(memcmp(actual, expected, sizeof(expected)) == 0);
+    }
+
+    uint32_t base = arc4random(), init = arc4random();
+    uint32_t deltas[SCRU128_CODEC_BLOCK_LEN];
+    memcpy(deltas, expected, sizeof(expected));
+    memcpy(actual, expected, sizeof(expected));
+    scru128_codec_prefix_sum_scalar(expected, base, init);
+    scru128_codec_prefix_sum_sse2(actual, base, init);
+    assert(memcmp(actual, expected, sizeof(expected)) == 0);
+
+    uint64_t expected_bits[2], actual_bits[2];
+    uint32_t min = expected[arc4random_uniform(128)];
+    uint32_t max = expected[arc4random_uniform(128)];
+    scru128_codec_scan_scalar(deltas, base, init, min, max, expected_bits);
+    scru128_codec_scan_sse2(deltas, base, init, min, max, actual_bits);
+    assert(memcmp(actual_bits, expected_bits, sizeof(expected_bits)) == 0);
+
+    // few distinct upper halves to exercise the comparisons of lower halves
+    uint32_t hi[SCRU128_CODEC_BLOCK_LEN], lo[SCRU128_CODEC_BLOCK_LEN];
+    for (int i = 0; i < SCRU128_CODEC_BLOCK_LEN; i++) {
+      hi[i] = k % 2 == 0 ? arc4random_uniform(3) : arc4random();
+      lo[i] = k % 4 < 2 ? arc4random_uniform(3) - 1 : arc4random();
+    }
+    uint64_t ts_min = (uint64_t)hi[arc4random_uniform(128)] << 32 |
+                      lo[arc4random_uniform(128)];
+    uint64_t ts_max = (uint64_t)hi[arc4random_uniform(128)] << 32 |
+                      lo[arc4random_uniform(128)];
+    scru128_codec_match_scalar(hi, lo, ts_min, ts_max, expected_bits);
+    scru128_codec_match_sse2(hi, lo, ts_min, ts_max, actual_bits);
+    assert(memcmp(actual_bits, expected_bits, sizeof(expected_bits)) == 0);
+  }
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s:\n", __FILE__);
+  run_test(test_high_rate);
+  run_test(test_low_rate);
+  run_test(test_random);
+  run_test(test_edge_cases);
+  run_test(test_errors);
+#ifdef SCRU128_HAS_X86_SIMD
+  run_test(test_sse2_kernels);
+#endif
+  return 0;
+}
@@ -210,6 +210,295 @@ void test_comparison_methods(void) {
   }
 }
 
+/** Encodes a SCRU128 ID by naive repeated division by 36 over bytes */
+void to_str_reference(const uint8_t *id, char *str_out) {
+  static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  uint8_t n[SCRU128_LEN];
+  memcpy(n, id, SCRU128_LEN);
+  for (int i = 24; i >= 0; i--) {
+    unsigned rem = 0;
+    for (int j = 0; j < SCRU128_LEN; j++) {
+      unsigned cur = rem << 8 | n[j];
+      n[j] = (uint8_t)(cur / 36);
+      rem = cur % 36;
+    }
+    str_out[i] = DIGITS[rem];
+  }
+  str_out[25] = 0;
+}
+
+/** Decodes a SCRU128 ID by naive repeated multiplication by 36 over bytes */
+int from_str_reference(uint8_t *id_out, const char *str) {
+  static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  memset(id_out, 0, SCRU128_LEN);
+  for (int i = 0; i < 25; i++) {
+    const char *p = strchr(DIGITS, tolower(str[i]));
+    if (str[i] == 0 || p == NULL) {
+      return -1;
+    }
+    unsigned carry = (unsigned)(p - DIGITS);
+    for (int j = SCRU128_LEN - 1; j >= 0; j--) {
+      carry += id_out[j] * 36u;
+      id_out[j] = (uint8_t)carry;
+      carry >>= 8;
+    }
+    if (carry > 0) {
+      return -1;
+    }
+  }
+  return str[25] == 0 ? 0 : -1;
+}
+
+/** Encodes and decodes random values identically to naive implementation */
+void test_random_values_against_reference(void) {
+  uint32_t state = 0x42;
+  for (int i = 0; i < 100000; i++) {
+    uint8_t id[SCRU128_LEN], id_expected[SCRU128_LEN], id_actual[SCRU128_LEN];
+    char text[TEXT_BUFFER_SIZE], text_expected[TEXT_BUFFER_SIZE];
+    for (int j = 0; j < SCRU128_LEN; j++) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      // bias some bytes to extremes to cover carries
+      id[j] = (uint8_t)(state % 7 == 0 ? 0xff : state % 7 == 1 ? 0 : state);
+      text[j] = "0123456789abcdefghijklmnopqrstuvwxyzZ"[state % 37];
+    }
+    for (int j = SCRU128_LEN; j < 25; j++) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      text[j] = "0123456789abcdefghijklmnopqrstuvwxyz-"[state % 37];
+    }
+    text[0] = "0123456789abcdefgf"[state % 18];
+    text[25] = 0;
+
+    char text_actual[TEXT_BUFFER_SIZE];
+    to_str_reference(id, text_expected);
+    scru128_to_str(id, text_actual);
+    assert(strcmp(text_expected, text_actual) == 0);
+
+    int err_expected = from_str_reference(id_expected, text);
+    int err_actual = scru128_from_str(id_actual, text);
+    assert(err_expected == err_actual);
+    if (err_actual == 0) {
+      assert(memcmp(id_expected, id_actual, SCRU128_LEN) == 0);
+    }
+  }
+}
+
+/** Encodes multiple IDs in batch identically to scalar encoder */
+void test_to_str_batch(void) {
+  int n_cases = 0;
+  uint8_t cases[75][SCRU128_LEN];
+  scru128_from_fields(cases[n_cases++], 0, 0, 0, 0);
+  scru128_from_fields(cases[n_cases++], MAX_UINT48, 0, 0, 0);
+  scru128_from_fields(cases[n_cases++], 0, MAX_UINT24, 0, 0);
+  scru128_from_fields(cases[n_cases++], 0, 0, MAX_UINT24, 0);
+  scru128_from_fields(cases[n_cases++], 0, 0, 0, MAX_UINT32);
+  scru128_from_fields(cases[n_cases++], MAX_UINT48, MAX_UINT24, MAX_UINT24,
+                      MAX_UINT32);
+  scru128_from_fields(cases[n_cases++], 1, 1, 1, 1);
+
+  for (int i = 0; i < n_generated_strings; i++) {
+    scru128_from_str(cases[n_cases++], generated_strings[i]);
+  }
+
+  // test every length to cover remainders of lanes
+  for (int n = 0; n <= n_cases; n++) {
+    char batch[75][SCRU128_STR_LEN];
+    memset(batch, 0x7f, sizeof(batch));
+    scru128_to_str_batch(cases[0], n, batch[0]);
+    for (int i = 0; i < n_cases; i++) {
+      if (i < n) {
+        char text_buffer[SCRU128_STR_LEN];
+        scru128_to_str(cases[i], text_buffer);
+        assert(memcmp(batch[i], text_buffer, SCRU128_STR_LEN) == 0);
+      } else {
+        assert(batch[i][0] == 0x7f); // untouched
+      }
+    }
+  }
+}
+
+#ifdef SCRU128_HAS_X86_SIMD
+/** Encodes IDs with each SIMD kernel identically to scalar encoder */
+void test_to_str_batch_kernels(void) {
+  enum { N_IDS = 1001 };
+  static uint8_t ids[N_IDS][SCRU128_LEN];
+  uint32_t state = 0x42;
+  for (int i = 0; i < N_IDS; i++) {
+    for (int j = 0; j < SCRU128_LEN; j++) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      // bias some bytes to extremes to cover carries
+      ids[i][j] = (uint8_t)(state % 7 == 0 ? 0xff : state % 7 == 1 ? 0 : state);
+    }
+  }
+  memset(ids[0], 0, SCRU128_LEN);
+  memset(ids[1], 0xff, SCRU128_LEN);
+  scru128_from_fields(ids[2], 1, 1, 1, 1);
+
+  int level = scru128_x86_simd_level();
+  for (int k = 1; k <= level; k++) {
+    static char strs[N_IDS][SCRU128_STR_LEN];
+    memset(strs, 0x7f, sizeof(strs));
+    size_t n_done =
+        k == 3   ? scru128_to_str_batch_avx512(ids[0], N_IDS, strs[0])
+        : k == 2 ? scru128_to_str_batch_avx2(ids[0], N_IDS, strs[0])
+                 : scru128_to_str_batch_sse41(ids[0], N_IDS, strs[0]);
+    size_t width = k == 3 ? 16 : k == 2 ? 8 : 4;
+    assert(n_done == N_IDS - N_IDS % width);
+    for (size_t i = 0; i < N_IDS; i++) {
+      if (i < n_done) {
+        char text_buffer[SCRU128_STR_LEN];
+        scru128_to_str(ids[i], text_buffer);
+        assert(memcmp(strs[i], text_buffer, SCRU128_STR_LEN) == 0);
+      } else {
+        assert(strs[i][0] == 0x7f); // left to scalar encoder
+      }
+    }
+  }
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
+/** Decodes multiple records in batch identically to scalar decoder */
+void test_from_str_batch(void) {
+  static const char invalid[][26] = {
+      "036z8puq5a7j0t_08p2cdz28v", "036z8pu-5a7j0ti08p3ol8ool",
+      "036z8puq5a7j0ti08p4j 6cya", "f5lxx1zz5pnorynqglhzmsp34",
+      "zzzzzzzzzzzzzzzzzzzzzzzzz",
+  };
+  const int n_invalid = sizeof(invalid) / sizeof(invalid[0]);
+
+  // lay out valid and invalid records in CRLF-terminated lines
+  enum { STRIDE = 27, N_RECORDS = 64 + 5 };
+  char lines[STRIDE * N_RECORDS];
+  int is_invalid[N_RECORDS];
+  for (int i = 0; i < N_RECORDS; i++) {
+    is_invalid[i] = i % 14 == 3;
+    const char *text = is_invalid[i] ? invalid[i / 14]
+                                     : generated_strings[i - (i + 10) / 14];
+    memcpy(lines + STRIDE * i, text, 25);
+    lines[STRIDE * i + 25] = '\r';
+    lines[STRIDE * i + 26] = '\n';
+    if (i % 2 == 1) {
+      for (int j = 0; j < 25; j++) {
+        lines[STRIDE * i + j] = (char)toupper(lines[STRIDE * i + j]);
+      }
+    }
+  }
+  assert(n_invalid == (N_RECORDS + 10) / 14);
+
+  // test every length to cover remainders of lanes
+  for (int n = 0; n <= N_RECORDS; n++) {
+    uint8_t ids[N_RECORDS][SCRU128_LEN];
+    uint8_t errors[(N_RECORDS + 7) / 8];
+    memset(errors, 0xff, sizeof(errors));
+    size_t n_errors = scru128_from_str_batch(ids[0], lines, n, STRIDE, errors);
+
+    size_t n_expected_errors = 0;
+    for (int i = 0; i < n; i++) {
+      int error_bit = errors[i / 8] >> (i % 8) & 1;
+      assert(error_bit == is_invalid[i]);
+      if (is_invalid[i]) {
+        n_expected_errors++;
+        uint8_t zero[SCRU128_LEN] = {0};
+        assert(memcmp(ids[i], zero, SCRU128_LEN) == 0);
+      } else {
+        char text[TEXT_BUFFER_SIZE];
+        memcpy(text, lines + STRIDE * i, 25);
+        text[25] = 0;
+        uint8_t expected[SCRU128_LEN];
+        int err = scru128_from_str(expected, text);
+        assert(err == 0);
+        assert(memcmp(ids[i], expected, SCRU128_LEN) == 0);
+      }
+    }
+    assert(n_errors == n_expected_errors);
+    assert(scru128_from_str_batch(ids[0], lines, n, STRIDE, NULL) ==
+           n_expected_errors);
+  }
+}
+
+#ifdef SCRU128_HAS_X86_SIMD
+/** Decodes records with each SIMD kernel identically to naive decoder */
+void test_from_str_batch_kernels(void) {
+  static const char CHARS[] =
+      "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  enum { STRIDE = 26, N_RECORDS = 1001 };
+  static char lines[STRIDE * N_RECORDS];
+  uint32_t state = 0x42;
+  for (int i = 0; i < N_RECORDS; i++) {
+    uint32_t r[28];
+    for (int j = 0; j < 28; j++) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      r[j] = state;
+    }
+
+    // mix valid records in both cases with invalid characters, overflowing
+    // values, and random letters
+    char *line = lines + STRIDE * i;
+    uint8_t id[SCRU128_LEN];
+    for (int j = 0; j < SCRU128_LEN; j++) {
+      id[j] = (uint8_t)r[j];
+    }
+    char text[TEXT_BUFFER_SIZE];
+    scru128_to_str(id, text);
+    for (int j = 0; j < 25; j++) {
+      line[j] = (char)(r[j] & 0x100 ? toupper(text[j]) : text[j]);
+    }
+    if (r[25] % 16 == 0) {
+      line[r[26] % 25] = (char)r[27];
+    } else if (r[25] % 16 == 1) {
+      line[0] = CHARS[r[26] % 62];
+    } else if (r[25] % 16 == 2) {
+      memcpy(line, "f5lxx1zz5pnorynqglhzmsp3", 24);
+      line[24] = CHARS[r[26] % 62];
+    }
+    line[25] = '\n';
+  }
+
+  int level = scru128_x86_simd_level();
+  for (int k = 1; k <= level && k <= 2; k++) {
+    static uint8_t ids[N_RECORDS][SCRU128_LEN];
+    uint8_t errors[(N_RECORDS + 7) / 8];
+    memset(ids, 0x7f, sizeof(ids));
+    memset(errors, 0x7f, sizeof(errors));
+    size_t n_errors = 0;
+    size_t n_done =
+        k == 2 ? scru128_from_str_batch_avx2(ids[0], lines, N_RECORDS, STRIDE,
+                                             errors, &n_errors)
+               : scru128_from_str_batch_sse41(ids[0], lines, N_RECORDS, STRIDE,
+                                              errors, &n_errors);
+    assert(n_done == N_RECORDS - N_RECORDS % 8);
+
+    size_t n_expected_errors = 0;
+    for (size_t i = 0; i < N_RECORDS; i++) {
+      if (i < n_done) {
+        char text[TEXT_BUFFER_SIZE];
+        memcpy(text, lines + STRIDE * i, 25);
+        text[25] = 0;
+        uint8_t expected[SCRU128_LEN] = {0};
+        int is_invalid = from_str_reference(expected, text) != 0;
+        if (is_invalid) {
+          n_expected_errors++;
+          memset(expected, 0, SCRU128_LEN);
+        }
+        assert((errors[i / 8] >> (i % 8) & 1) == is_invalid);
+        assert(memcmp(ids[i], expected, SCRU128_LEN) == 0);
+      } else {
+        assert(ids[i][0] == 0x7f); // left to scalar decoder
+      }
+    }
+    assert(n_errors == n_expected_errors);
+    assert(n_errors > N_RECORDS / 16); // some invalid records are tested
+  }
+}
+#endif /* #ifdef SCRU128_HAS_X86_SIMD */
+
 static uint32_t arc4random_mock_state = 0x42;
 
 /** A naive xorshift random number generator */
@@ -342,6 +631,471 @@ void test_timestamp_rollback_abort(void) {
   assert(memcmp(prev, curr, SCRU128_LEN) == 0); // untouched
 }
 
+/** Generates increasing IDs with lock-free generator as with normal one */
+void test_atomic_decreasing_or_constant_timestamp(void) {
+  Scru128AtomicGenerator g;
+  uint8_t prev[SCRU128_LEN], curr[SCRU128_LEN];
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_atomic_generator_init(&g);
+  int status = scru128_atomic_generate_or_abort_core(&g, prev, ts,
+                                                     &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  assert(scru128_timestamp(prev) == ts);
+
+  for (uint64_t i = 0; i < 100000; i++) {
+    status = scru128_atomic_generate_or_reset_core(
+        &g, curr, ts - (i < 9999 ? i : 9999), &arc4random_mock, 10000);
+    assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+           status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC ||
+           status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+    assert(scru128_compare(prev, curr) < 0);
+    assert(scru128_counter_hi(prev) == scru128_counter_hi(curr) ||
+           scru128_counter_lo(curr) == 0);
+    memcpy(prev, curr, SCRU128_LEN);
+  }
+  assert(scru128_timestamp(prev) >= ts);
+
+  // renews counter_hi every second
+  uint32_t counter_hi = scru128_counter_hi(prev);
+  status = scru128_atomic_generate_or_abort_core(&g, curr, ts + 999,
+                                                 &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  assert(scru128_counter_hi(curr) == counter_hi);
+  status = scru128_atomic_generate_or_abort_core(&g, curr, ts + 1000,
+                                                 &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  assert(scru128_counter_hi(curr) != counter_hi);
+}
+
+/** Aborts or resets lock-free generator if timestamp goes backwards a lot */
+void test_atomic_timestamp_rollback(void) {
+  Scru128AtomicGenerator g;
+  uint8_t prev[SCRU128_LEN], curr[SCRU128_LEN];
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_atomic_generator_init(&g);
+  int status = scru128_atomic_generate_or_abort_core(&g, prev, ts,
+                                                     &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+
+  memcpy(curr, prev, SCRU128_LEN);
+  status = scru128_atomic_generate_or_abort_core(&g, curr, ts - 10001,
+                                                 &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+  assert(memcmp(prev, curr, SCRU128_LEN) == 0); // untouched
+
+  status = scru128_atomic_generate_or_reset_core(&g, curr, ts - 10001,
+                                                 &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_RESET);
+  assert(scru128_compare(prev, curr) > 0);
+  assert(scru128_timestamp(curr) == ts - 10001);
+
+  memcpy(prev, curr, SCRU128_LEN);
+  status = scru128_atomic_generate_or_reset_core(&g, curr, ts - 10002,
+                                                 &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  assert(scru128_compare(prev, curr) < 0);
+}
+
+/** Creates increasing IDs from reserved blocks interleaved with generation */
+void test_reserve(void) {
+  static uint8_t ids[1002][SCRU128_LEN];
+  Scru128Generator g;
+  Scru128CounterBlock block;
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  int status = scru128_generate_or_reset_core(&g, ids[0], ts,
+                                              &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+
+  status = scru128_generator_reserve_or_reset_core(&g, 1000, &block, ts - 9999,
+                                                   &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  for (int i = 1; i <= 1000; i++) {
+    assert(scru128_counter_block_generate(&block, ids[i], &arc4random_mock) ==
+           0);
+  }
+  assert(scru128_counter_block_generate(&block, ids[0], &arc4random_mock) !=
+         0); // exhausted
+
+  status = scru128_generate_or_reset_core(&g, ids[1001], ts,
+                                          &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  for (int i = 1; i < 1002; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+    assert(scru128_timestamp(ids[i]) == ts);
+  }
+
+  // abort without touching the generator or block
+  Scru128CounterBlock copy = block;
+  status = scru128_generator_reserve_or_abort_core(&g, 10, &block, ts - 10001,
+                                                   &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+  assert(memcmp(&copy, &block, sizeof(block)) == 0);
+  status = scru128_generator_reserve_or_abort_core(&g, 0, &block, ts,
+                                                   &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ERROR);
+}
+
+/** Carries counter overflow within a reserved block */
+void test_reserve_counter_overflow(void) {
+  uint8_t prev[SCRU128_LEN], curr[SCRU128_LEN];
+  Scru128Generator g;
+  Scru128CounterBlock block;
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  g._timestamp = ts;
+  g._ts_counter_hi = ts;
+  g._counter_hi = MAX_UINT24;
+  g._counter_lo = MAX_UINT24 - 2;
+
+  int status = scru128_generator_reserve_or_abort_core(
+      &g, 5, &block, ts, &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+  scru128_counter_block_generate(&block, prev, &arc4random_mock);
+  assert(scru128_counter_lo(prev) == MAX_UINT24 - 1);
+  for (int i = 1; i < 5; i++) {
+    scru128_counter_block_generate(&block, curr, &arc4random_mock);
+    assert(scru128_compare(prev, curr) < 0);
+    memcpy(prev, curr, SCRU128_LEN);
+  }
+  assert(scru128_timestamp(curr) == ts + 1);
+  assert(scru128_counter_hi(curr) == 0);
+  assert(scru128_counter_lo(curr) == 2);
+  assert(g._timestamp == ts + 1);
+
+  // reject blocks that exceed the maximum timestamp
+  g._timestamp = MAX_UINT48;
+  g._ts_counter_hi = MAX_UINT48;
+  g._counter_hi = MAX_UINT24;
+  g._counter_lo = MAX_UINT24 - 2;
+  status = scru128_generator_reserve_or_abort_core(&g, 3, &block, MAX_UINT48,
+                                                   &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ERROR);
+  assert(g._counter_lo == MAX_UINT24 - 2);
+}
+
+/** Reserves blocks from a lock-free generator in increasing order */
+void test_atomic_reserve(void) {
+  uint8_t prev[SCRU128_LEN], curr[SCRU128_LEN];
+  Scru128AtomicGenerator g;
+  Scru128CounterBlock block;
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_atomic_generator_init(&g);
+  int status = scru128_atomic_generate_or_abort_core(&g, prev, ts,
+                                                     &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+
+  for (int i = 0; i < 100; i++) {
+    status = scru128_atomic_generator_reserve_or_abort_core(
+        &g, 1000, &block, ts - 9999, &arc4random_mock, 10000);
+    assert(status >= 0);
+    while (scru128_counter_block_generate(&block, curr, &arc4random_mock) ==
+           0) {
+      assert(scru128_compare(prev, curr) < 0);
+      memcpy(prev, curr, SCRU128_LEN);
+    }
+    status = scru128_atomic_generate_or_abort_core(&g, curr, ts,
+                                                   &arc4random_mock, 10000);
+    assert(status >= 0);
+    assert(scru128_compare(prev, curr) < 0);
+    memcpy(prev, curr, SCRU128_LEN);
+  }
+
+  status = scru128_atomic_generator_reserve_or_abort_core(
+      &g, 10, &block, ts - 10001, &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+  status = scru128_atomic_generator_reserve_or_reset_core(
+      &g, 10, &block, ts - 10001, &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_RESET);
+  scru128_counter_block_generate(&block, curr, &arc4random_mock);
+  assert(scru128_timestamp(curr) == ts - 10001);
+}
+
+/** Fills a buffer using the naive xorshift random number generator */
+void arc4random_buf_mock(void *buf, size_t nbytes) {
+  for (size_t i = 0; i < nbytes; i++) {
+    ((uint8_t *)buf)[i] = (uint8_t)arc4random_mock();
+  }
+}
+
+/** Generates increasing IDs in batch even with decreasing timestamp */
+void test_batch_decreasing_or_constant_timestamp(void) {
+  static uint8_t ids[1000][SCRU128_LEN];
+  Scru128Generator g;
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  int status = scru128_generate_batch_or_reset_core(
+      &g, ids[0], 1, ts, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  assert(scru128_timestamp(ids[0]) == ts);
+
+  status = scru128_generate_batch_or_reset_core(
+      &g, ids[1], 999, ts - 9999, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  for (int i = 1; i < 1000; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+    assert(memcmp(ids[i - 1], ids[i], SCRU128_LEN) < 0);
+    assert(scru128_timestamp(ids[i]) == ts);
+  }
+
+  uint8_t next[SCRU128_LEN];
+  status =
+      scru128_generate_or_abort_core(&g, next, ts, &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  assert(scru128_compare(ids[999], next) < 0);
+
+  status = scru128_generate_batch_or_abort_core(
+      &g, ids[0], 1000, ts + 1, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  assert(scru128_compare(next, ids[0]) < 0);
+  assert(scru128_timestamp(ids[0]) == ts + 1);
+  for (int i = 1; i < 1000; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+}
+
+/** Aborts or resets batch generation if timestamp goes backwards a lot */
+void test_batch_timestamp_rollback(void) {
+  static uint8_t ids[100][SCRU128_LEN];
+  Scru128Generator g;
+  uint8_t prev[SCRU128_LEN];
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  int status =
+      scru128_generate_or_abort_core(&g, prev, ts, &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+
+  memset(ids, 0, sizeof(ids));
+  status = scru128_generate_batch_or_abort_core(
+      &g, ids[0], 100, ts - 10001, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+  for (int i = 0; i < 100; i++) {
+    assert(scru128_timestamp(ids[i]) == 0); // untouched
+  }
+
+  status = scru128_generate_batch_or_reset_core(
+      &g, ids[0], 100, ts - 10001, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_RESET);
+  assert(scru128_compare(prev, ids[0]) > 0);
+  assert(scru128_timestamp(ids[0]) == ts - 10001);
+  for (int i = 1; i < 100; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+
+  status = scru128_generate_batch_or_abort_core(
+      &g, ids[0], 0, ts, &arc4random_buf_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ERROR);
+}
+
+/** A naive xorshift random source that counts the calls */
+struct XorshiftSource {
+  uint32_t state;
+  int n_calls;
+};
+
+void xorshift_source_fill(void *ctx, void *buf, size_t nbytes) {
+  struct XorshiftSource *x = (struct XorshiftSource *)ctx;
+  x->n_calls++;
+  for (size_t i = 0; i < nbytes; i++) {
+    x->state ^= x->state << 3;
+    x->state ^= x->state >> 13;
+    x->state ^= x->state << 7;
+    ((uint8_t *)buf)[i] = (uint8_t)x->state;
+  }
+}
+
+/** Generates increasing IDs from random source with one call per ID */
+void test_random_source(void) {
+  struct XorshiftSource x = {0x42, 0};
+  Scru128RandomSource src = {&x, &xorshift_source_fill};
+  Scru128Generator g;
+  uint8_t prev[SCRU128_LEN], curr[SCRU128_LEN];
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  int status = scru128_generate_or_abort_core_src(&g, prev, ts, &src, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  assert(scru128_timestamp(prev) == ts);
+  assert(x.n_calls == 1);
+
+  for (uint64_t i = 0; i < 100000; i++) {
+    status = scru128_generate_or_abort_core_src(
+        &g, curr, ts - (i < 9999 ? i : 9999), &src, 10000);
+    assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+           status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC ||
+           status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+    assert(scru128_compare(prev, curr) < 0);
+    memcpy(prev, curr, SCRU128_LEN);
+  }
+  assert(x.n_calls == 100001);
+
+  status = scru128_generate_or_abort_core_src(&g, curr, ts - 10001, &src,
+                                              10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_ABORT);
+  assert(memcmp(prev, curr, SCRU128_LEN) == 0); // untouched
+
+  status = scru128_generate_or_reset_core_src(&g, curr, ts - 10001, &src,
+                                              10000);
+  assert(status == SCRU128_GENERATOR_STATUS_ROLLBACK_RESET);
+  assert(scru128_compare(prev, curr) > 0);
+  assert(scru128_timestamp(curr) == ts - 10001);
+
+  static uint8_t ids[1000][SCRU128_LEN];
+  x.n_calls = 0;
+  status = scru128_generate_batch_or_reset_core_src(&g, ids[0], 1000,
+                                                    ts - 10001, &src, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_COUNTER_LO_INC ||
+         status == SCRU128_GENERATOR_STATUS_COUNTER_HI_INC);
+  assert(x.n_calls == 1);
+  assert(scru128_compare(curr, ids[0]) < 0);
+  for (int i = 1; i < 1000; i++) {
+    assert(scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+}
+
+/** Fixes the upper bits of counter_hi in the partitioned mode */
+void test_sharded_generator(void) {
+  static uint8_t ids[1000][SCRU128_LEN];
+  Scru128Generator g;
+  Scru128CounterBlock block;
+
+  assert(scru128_generator_init_sharded(&g, 0x100, 8) != 0);
+  assert(scru128_generator_init_sharded(&g, 0, 25) != 0);
+  assert(scru128_generator_init_sharded(&g, 0xab, 8) == 0);
+
+  uint64_t ts = 0x0123456789ab;
+  int status = scru128_generate_or_reset_core(&g, ids[0], ts,
+                                              &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_NEW_TIMESTAMP);
+  status = scru128_generate_batch_or_reset_core(&g, ids[1], 499, ts,
+                                                &arc4random_buf_mock, 10000);
+  assert(status >= 0);
+  status = scru128_generator_reserve_or_reset_core(&g, 500, &block, ts,
+                                                   &arc4random_mock, 10000);
+  assert(status >= 0);
+  for (int i = 500; i < 1000; i++) {
+    scru128_counter_block_generate(&block, ids[i], &arc4random_mock);
+  }
+  for (int i = 0; i < 1000; i++) {
+    assert(scru128_shard(ids[i], 8) == 0xab);
+    assert(i == 0 || scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+
+  // carry counter overflow into timestamp without touching shard bits
+  g._counter_hi = 0xabffff;
+  g._counter_lo = MAX_UINT24;
+  status = scru128_generate_or_abort_core(&g, ids[0], ts, &arc4random_mock,
+                                          10000);
+  assert(status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+  assert(scru128_counter_hi(ids[0]) == 0xab0000);
+  assert(scru128_timestamp(ids[0]) == g._timestamp);
+
+  g._counter_hi = 0xabffff;
+  g._counter_lo = MAX_UINT24 - 1;
+  status = scru128_generator_reserve_or_abort_core(&g, 3, &block, ts,
+                                                   &arc4random_mock, 10000);
+  assert(status == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+  for (int i = 0; i < 3; i++) {
+    scru128_counter_block_generate(&block, ids[i], &arc4random_mock);
+    assert(scru128_shard(ids[i], 8) == 0xab);
+    assert(i == 0 || scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+  assert(scru128_counter_hi(ids[2]) == 0xab0000);
+
+  // reserve all bits of counter_hi
+  assert(scru128_generator_init_sharded(&g, 0x123456, 24) == 0);
+  for (int i = 0; i < 1000; i++) {
+    scru128_generate_or_abort_core(&g, ids[i], ts, &arc4random_mock, 10000);
+    assert(scru128_counter_hi(ids[i]) == 0x123456);
+    assert(scru128_shard(ids[i], 24) == 0x123456);
+    assert(i == 0 || scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+  assert(scru128_shard(ids[0], 0) == 0);
+
+  Scru128AtomicGenerator ag;
+  assert(scru128_atomic_generator_init_sharded(&ag, 0x2a, 6) == 0);
+  for (int i = 0; i < 1000; i++) {
+    scru128_atomic_generate_or_abort_core(&ag, ids[i], ts, &arc4random_mock,
+                                          10000);
+    assert(scru128_shard(ids[i], 6) == 0x2a);
+    assert(i == 0 || scru128_compare(ids[i - 1], ids[i]) < 0);
+  }
+}
+
+#ifdef SCRU128_ENABLE_STATS
+/** Collects statistics of generator functions */
+void test_generator_stats(void) {
+  uint8_t ids[4][SCRU128_LEN];
+  Scru128Generator g;
+  Scru128GeneratorStats stats;
+  Scru128CounterBlock block;
+
+  uint64_t ts = 0x0123456789ab;
+  scru128_generator_init(&g);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.n_new_timestamp == 0 && stats.n_rng_calls == 0);
+
+  scru128_generate_or_abort_core(&g, ids[0], ts, &arc4random_mock, 10000);
+  scru128_generate_or_abort_core(&g, ids[0], ts - 5, &arc4random_mock, 10000);
+  scru128_generate_batch_or_abort_core(&g, ids[0], 4, ts, &arc4random_buf_mock,
+                                       10000);
+  scru128_generator_reserve_or_abort_core(&g, 10, &block, ts, &arc4random_mock,
+                                          10000);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.n_new_timestamp == 1);
+  assert(stats.n_counter_lo_inc + stats.n_counter_hi_inc == 3);
+  assert(stats.n_rng_calls == 3 + 1 + 1 + 0);
+  assert(stats.max_drift == 5);
+
+  // timestamp_inc and drift ahead of the clock
+  g._counter_hi = MAX_UINT24;
+  g._counter_lo = MAX_UINT24;
+  scru128_generate_or_abort_core(&g, ids[0], ts, &arc4random_mock, 10000);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.n_timestamp_inc == 1);
+  assert(stats.max_drift == 5);
+  scru128_generate_or_abort_core(&g, ids[0], ts - 9, &arc4random_mock, 10000);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.max_drift == 10);
+
+  // rollback and errors
+  scru128_generate_or_abort_core(&g, ids[0], ts - 10011, &arc4random_mock,
+                                 10000);
+  scru128_generate_or_reset_core(&g, ids[0], ts - 10011, &arc4random_mock,
+                                 10000);
+  scru128_generate_or_abort_core(&g, ids[0], 0, &arc4random_mock, 10000);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.n_rollback_abort == 1);
+  assert(stats.n_rollback_reset == 1);
+  assert(stats.n_new_timestamp == 1);
+  assert(stats.n_error == 1);
+
+  // each call is counted once, including the one that reset the generator
+  assert(stats.n_new_timestamp + stats.n_counter_lo_inc +
+             stats.n_counter_hi_inc + stats.n_timestamp_inc +
+             stats.n_rollback_reset + stats.n_rollback_abort + stats.n_error ==
+         9);
+
+  scru128_generator_reset_stats(&g);
+  scru128_generator_stats(&g, &stats);
+  assert(stats.n_new_timestamp == 0 && stats.n_error == 0 &&
+         stats.max_drift == 0 && stats.n_rng_calls == 0);
+}
+#endif /* #ifdef SCRU128_ENABLE_STATS */
+
 #define run_test(NAME)                                                         \
   do {                                                                         \
     (NAME)();                                                                  \
@@ -357,9 +1111,30 @@ int main(void) {
   run_test(test_string_validation);
   run_test(test_symmetric_converters);
   run_test(test_comparison_methods);
+  run_test(test_random_values_against_reference);
+  run_test(test_to_str_batch);
+#ifdef SCRU128_HAS_X86_SIMD
+  run_test(test_to_str_batch_kernels);
+#endif
+  run_test(test_from_str_batch);
+#ifdef SCRU128_HAS_X86_SIMD
+  run_test(test_from_str_batch_kernels);
+#endif
   run_test(test_decreasing_or_constant_timestamp_reset);
   run_test(test_timestamp_rollback_reset);
   run_test(test_decreasing_or_constant_timestamp_abort);
   run_test(test_timestamp_rollback_abort);
+  run_test(test_batch_decreasing_or_constant_timestamp);
+  run_test(test_batch_timestamp_rollback);
+  run_test(test_random_source);
+  run_test(test_atomic_decreasing_or_constant_timestamp);
+  run_test(test_atomic_timestamp_rollback);
+  run_test(test_reserve);
+  run_test(test_reserve_counter_overflow);
+  run_test(test_atomic_reserve);
+  run_test(test_sharded_generator);
+#ifdef SCRU128_ENABLE_STATS
+  run_test(test_generator_stats);
+#endif
   return 0;
 }
@@ -0,0 +1,331 @@
+#include "scru128.hpp"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+using namespace scru128::literals;
+
+static constexpr std::uint64_t MAX_UINT48 = (std::uint64_t{1} << 48) - 1;
+static constexpr std::uint32_t MAX_UINT24 = (std::uint32_t{1} << 24) - 1;
+static constexpr std::uint32_t MAX_UINT32 = UINT32_MAX;
+
+// literals and conversions are evaluated at compile time
+static constexpr scru128::id MAX_ID = "F5LXX1ZZ5PNORYNQGLHZMSP33"_scru128;
+static_assert(MAX_ID.hi() == UINT64_MAX && MAX_ID.lo() == UINT64_MAX);
+static_assert(MAX_ID.timestamp() == MAX_UINT48);
+static_assert(MAX_ID.to_str()[0] == 'f' && MAX_ID.to_str()[24] == '3');
+static_assert("0000000005gv2r2kjwr7n8xs0"_scru128.counter_hi() == MAX_UINT24);
+static_assert("00000000000000jpia7ql4hs0"_scru128.counter_lo() == MAX_UINT24);
+static_assert("0000000000000000001z141z3"_scru128.entropy() == MAX_UINT32);
+static_assert("036zi0h673abdqnmscasjw0zr"_scru128 <
+              "036zi0h673abdqnmsce4evop9"_scru128);
+static_assert(scru128::id::from_fields(1, 2, 3, 4) ==
+              scru128::id::from_u64_pair(0x10000, 0x0200000300000004));
+static_assert(std::is_trivially_copyable<scru128::id>::value);
+static_assert(sizeof(scru128::id) == SCRU128_LEN);
+
+/** Encodes and decodes prepared cases correctly */
+void test_encode_decode(void) {
+  struct Case {
+    std::uint64_t timestamp;
+    std::uint32_t counter_hi;
+    std::uint32_t counter_lo;
+    std::uint32_t entropy;
+    const char *text;
+  };
+
+  const Case cases[] = {
+      {0, 0, 0, 0, "0000000000000000000000000"},
+      {MAX_UINT48, 0, 0, 0, "F5LXX1ZZ5K6TP71GEEH2DB7K0"},
+      {MAX_UINT48, 0, 0, 0, "f5lxx1zz5k6tp71geeh2db7k0"},
+      {0, MAX_UINT24, 0, 0, "0000000005gv2r2kjwr7n8xs0"},
+      {0, 0, MAX_UINT24, 0, "00000000000000jpia7ql4hs0"},
+      {0, 0, 0, MAX_UINT32, "0000000000000000001z141z3"},
+      {MAX_UINT48, MAX_UINT24, MAX_UINT24, MAX_UINT32,
+       "f5lxx1zz5pnorynqglhzmsp33"},
+  };
+
+  for (const Case &e : cases) {
+    scru128::id from_fields = scru128::id::from_fields(
+        e.timestamp, e.counter_hi, e.counter_lo, e.entropy);
+    scru128::id from_string = scru128::id::from_str(e.text);
+    assert(from_fields == from_string);
+    assert(from_string.timestamp() == e.timestamp);
+    assert(from_string.counter_hi() == e.counter_hi);
+    assert(from_string.counter_lo() == e.counter_lo);
+    assert(from_string.entropy() == e.entropy);
+
+    std::string text = from_string.to_string();
+    assert(text.size() == 25);
+    for (std::size_t j = 0; j < text.size(); j++) {
+      assert(text[j] == tolower(e.text[j]));
+    }
+  }
+}
+
+/** Agrees with the C API on generated IDs */
+void test_c_interop(void) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  for (int i = 0; i < 1000; i++) {
+    scru128::id x;
+    int status = scru128_generate_or_reset_core(&g, x.data(), 0x0123456789ab,
+                                                &arc4random, 10000);
+    assert(status >= 0);
+
+    char text[SCRU128_STR_LEN];
+    scru128_to_str(x.data(), text);
+    assert(strcmp(x.to_str().data(), text) == 0);
+    assert(scru128::id::from_str(text) == x);
+    assert(scru128::id::from_bytes(x.data()) == x);
+    assert(x.timestamp() == scru128_timestamp(x.data()));
+    assert(x.counter_hi() == scru128_counter_hi(x.data()));
+    assert(x.counter_lo() == scru128_counter_lo(x.data()));
+    assert(x.entropy() == scru128_entropy(x.data()));
+  }
+}
+
+/** Raises error if an invalid string representation is supplied */
+void test_string_validation(void) {
+  const char *cases[] = {
+      "",
+      " 036z8puq4tsxsigk6o19y164q",
+      "036z8puq54qny1vq3hcbrkweb ",
+      "+36z8puq54qny1vq3hjq48d9p",
+      "036z8puq5a7j0t_08p2cdz28v",
+      "036z8puq5a7j0ti08p4j 6cya",
+      "f5lxx1zz5pnorynqglhzmsp34",
+      "zzzzzzzzzzzzzzzzzzzzzzzzz",
+  };
+
+  for (const char *e : cases) {
+    scru128::id x;
+    assert(scru128::id::try_from_str(x, e) != 0);
+    bool thrown = false;
+    try {
+      scru128::id::from_str(e);
+    } catch (const std::invalid_argument &) {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+
+  scru128::id x;
+  assert(scru128::id::try_from_fields(x, MAX_UINT48 + 1, 0, 0, 0) != 0);
+  assert(scru128::id::try_from_fields(x, 0, MAX_UINT24 + 1, 0, 0) != 0);
+  assert(scru128::id::try_from_fields(x, 0, 0, MAX_UINT24 + 1, 0) != 0);
+}
+
+/** Orders, hashes, and prints IDs consistently with the C API */
+void test_comparison_and_hash(void) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  std::vector<scru128::id> ids(1000);
+  for (scru128::id &x : ids) {
+    scru128_generate_or_reset_core(&g, x.data(), 0x0123456789ab, &arc4random,
+                                   10000);
+  }
+  std::vector<scru128::id> shuffled(ids.rbegin(), ids.rend());
+  std::sort(shuffled.begin(), shuffled.end());
+  assert(shuffled == ids);
+
+  for (std::size_t i = 1; i < ids.size(); i++) {
+    const scru128::id &prev = ids[i - 1], &curr = ids[i];
+    assert(prev < curr && prev <= curr && curr > prev && curr >= prev);
+    assert(prev != curr && !(prev == curr));
+    assert(scru128_compare(prev.data(), curr.data()) < 0);
+#ifdef SCRU128_HAS_THREE_WAY_COMPARISON
+    assert((prev <=> curr) < 0 && (curr <=> curr) == 0);
+#endif
+  }
+
+  std::unordered_set<scru128::id> set(ids.begin(), ids.end());
+  assert(set.size() == ids.size());
+  assert(set.count(ids[0]) == 1);
+
+  std::ostringstream os;
+  os << MAX_ID;
+  assert(os.str() == "f5lxx1zz5pnorynqglhzmsp33");
+#ifdef SCRU128_HAS_STD_FORMAT
+  assert(std::format("{:>27}", MAX_ID) == "  f5lxx1zz5pnorynqglhzmsp33");
+#endif
+}
+
+/** Returns a deterministic sequence of pseudo-random numbers */
+static std::uint32_t xorshift32_state = 2463534242;
+static std::uint32_t xorshift32(void) {
+  xorshift32_state ^= xorshift32_state << 13;
+  xorshift32_state ^= xorshift32_state >> 17;
+  xorshift32_state ^= xorshift32_state << 5;
+  return xorshift32_state;
+}
+
+struct FakeClock {
+  const std::uint64_t *now;
+  std::uint64_t operator()() const { return *now; }
+};
+
+struct FakeRng {
+  std::uint32_t operator()() const { return xorshift32(); }
+};
+
+/**
+ * Replays timestamps through a generator and the C core functions with the
+ * same random numbers and checks that they generate the same IDs
+ */
+template <class Generator>
+void check_matches_core(Generator &g, Scru128Generator &c, std::uint64_t &now) {
+  // steady, constant, slightly decreasing, and significantly decreasing
+  // timestamps exercise every status
+  const std::uint64_t steps[] = {1, 0, 0, 1000, static_cast<std::uint64_t>(-5),
+                                 0, static_cast<std::uint64_t>(-20000), 1};
+  for (int i = 0; i < 10000; i++) {
+    now += steps[i % 8];
+    std::uint32_t seed = xorshift32_state;
+    scru128::id x;
+    int status = g.generate_or_reset(x);
+    xorshift32_state = seed;
+    uint8_t y[SCRU128_LEN];
+    int expected = scru128_generate_or_reset_core(&c, y, now, &xorshift32,
+                                                  10000);
+    assert(status == expected);
+    assert(x == scru128::id::from_bytes(y));
+  }
+}
+
+/** Generates the same IDs as the C core functions */
+void test_basic_generator_matches_core(void) {
+  std::uint64_t now = 0x0123456789ab;
+  scru128::basic_generator<FakeClock, FakeRng, 10000> g(FakeClock{&now},
+                                                        FakeRng{});
+  Scru128Generator c;
+  scru128_generator_init(&c);
+  check_matches_core(g, c, now);
+
+  now = 0;
+  scru128::id x;
+  assert(g.generate_or_abort(x) == SCRU128_GENERATOR_STATUS_ERROR);
+  bool thrown = false;
+  try {
+    g.generate();
+  } catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+/** Generates the same IDs as the C core functions in the partitioned mode */
+void test_basic_generator_sharded(void) {
+  std::uint64_t now = 0x0123456789ab;
+  scru128::basic_generator<FakeClock, FakeRng, 10000> g(FakeClock{&now},
+                                                        FakeRng{}, 0x2a, 6);
+  Scru128Generator c;
+  scru128_generator_init_sharded(&c, 0x2a, 6);
+  check_matches_core(g, c, now);
+  assert(scru128_shard(g.generate().data(), 6) == 0x2a);
+
+  const std::uint32_t invalid[][2] = {{0, 25}, {64, 6}, {1, 0}};
+  for (const auto &args : invalid) {
+    bool thrown = false;
+    try {
+      scru128::basic_generator<FakeClock, FakeRng, 10000> h(
+          FakeClock{&now}, FakeRng{}, args[0], args[1]);
+    } catch (const std::out_of_range &) {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+}
+
+/** Increments timestamp at counter overflow like the C core functions */
+void test_basic_generator_counter_overflow(void) {
+  struct MaxRng {
+    std::uint32_t operator()() const { return UINT32_MAX; }
+  };
+  std::uint64_t now = 0x0123456789ab;
+  scru128::basic_generator<FakeClock, MaxRng, 10000> g(FakeClock{&now},
+                                                       MaxRng{});
+  scru128::id prev = g.generate();
+  assert(prev.counter_hi() == MAX_UINT24 && prev.counter_lo() == MAX_UINT24);
+  scru128::id curr;
+  assert(g.generate_or_abort(curr) == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+  assert(curr.timestamp() == now + 1 && curr.counter_hi() == 0);
+  assert(prev < curr);
+
+  // the lower bits of counter_hi wrap around within the shard
+  scru128::basic_generator<FakeClock, MaxRng, 10000> h(FakeClock{&now},
+                                                       MaxRng{}, 0x2a, 6);
+  prev = h.generate();
+  assert(prev.counter_hi() == (0x2a << 18 | MAX_UINT24 >> 6));
+  assert(h.generate_or_abort(curr) == SCRU128_GENERATOR_STATUS_TIMESTAMP_INC);
+  assert(curr.timestamp() == now + 1 && curr.counter_hi() == 0x2a << 18);
+  assert(prev < curr);
+}
+
+/** Generates increasing IDs with the default clock and random device */
+void test_default_generator(void) {
+  scru128::basic_generator<> g;
+  scru128::id prev = g.generate();
+  for (int i = 0; i < 10000; i++) {
+    scru128::id curr = g.generate();
+    assert(prev < curr);
+    prev = curr;
+  }
+}
+
+/** Draws unbiased 32-bit integers from engines of various ranges */
+void test_urbg_adaptor(void) {
+  // 32 bits per call
+  scru128::urbg_adaptor<std::mt19937> mt(std::mt19937(42));
+  std::mt19937 mt_ref(42);
+  assert(mt() == mt_ref());
+
+  // lower 32 bits of a 64-bit output
+  scru128::urbg_adaptor<std::mt19937_64> mt64(std::mt19937_64(42));
+  std::mt19937_64 mt64_ref(42);
+  assert(mt64() == static_cast<std::uint32_t>(mt64_ref()));
+
+  // two 30-bit draws from [1, 2^31 - 2] with rejection
+  scru128::urbg_adaptor<std::minstd_rand> minstd;
+  std::uint32_t ored = 0, anded = UINT32_MAX;
+  for (int i = 0; i < 1000; i++) {
+    std::uint32_t n = minstd();
+    ored |= n;
+    anded &= n;
+  }
+  assert(ored == UINT32_MAX && anded == 0);
+
+  scru128::basic_generator<scru128::system_clock,
+                           scru128::urbg_adaptor<std::mt19937_64>, 0>
+      g;
+  scru128::id first = g.generate();
+  assert(first < g.generate());
+}
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s (C++%ld):\n", __FILE__, __cplusplus / 100 % 100);
+  run_test(test_encode_decode);
+  run_test(test_c_interop);
+  run_test(test_string_validation);
+  run_test(test_comparison_and_hash);
+  run_test(test_basic_generator_matches_core);
+  run_test(test_basic_generator_sharded);
+  run_test(test_basic_generator_counter_overflow);
+  run_test(test_default_generator);
+  run_test(test_urbg_adaptor);
+  return 0;
+}
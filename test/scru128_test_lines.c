@@ -0,0 +1,249 @@
+#define SCRU128_ENABLE_MMAP
+#include "scru128_lines.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_IDS 10000
+
+static uint8_t ids[N_IDS * SCRU128_LEN];
+static uint8_t decoded[N_IDS * SCRU128_LEN];
+static char text[SCRU128_LINES_MAX_ENCODED_SIZE(N_IDS) + 4096];
+
+/** Fills `ids` with `N_IDS` generated IDs */
+void generate_ids(void) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  for (size_t i = 0; i < N_IDS; i++) {
+    int status = scru128_generate_or_reset_core(&g, ids + SCRU128_LEN * i,
+                                                0x0123456789ab + i / 100,
+                                                &arc4random, 10000);
+    assert(status >= 0);
+  }
+}
+
+/**
+ * Decodes `len` bytes of `text` fed in chunks of random sizes up to
+ * `max_chunk` bytes and returns the number of IDs decoded, or the negated line
+ * number of the first invalid line
+ */
+ptrdiff_t decode_in_chunks(size_t len, size_t max_chunk) {
+  Scru128LineDecoder d;
+  scru128_line_decoder_init(&d);
+  size_t count = 0, pos = 0;
+  while (pos < len) {
+    size_t chunk = 1 + arc4random_uniform((uint32_t)max_chunk);
+    chunk = chunk < len - pos ? chunk : len - pos;
+    size_t max_n = 1 + arc4random_uniform(64);
+    max_n = max_n < N_IDS - count ? max_n : N_IDS - count;
+    size_t consumed;
+    ptrdiff_t n = scru128_line_decoder_feed(&d, text + pos, chunk, &consumed,
+                                            decoded + SCRU128_LEN * count,
+                                            max_n);
+    if (n < 0) {
+      return -(ptrdiff_t)d.line;
+    }
+    assert(consumed <= chunk && (consumed > 0 || max_n == 0));
+    count += (size_t)n;
+    pos += consumed;
+  }
+  int status = scru128_line_decoder_finish(&d, decoded + SCRU128_LEN * count);
+  if (status < 0) {
+    return -(ptrdiff_t)d.line;
+  }
+  return (ptrdiff_t)count + status;
+}
+
+/** Decodes lines encoded with LF and CRLF from chunks of various sizes */
+void test_round_trip(void) {
+  generate_ids();
+  for (int crlf = 0; crlf <= 1; crlf++) {
+    size_t len = scru128_lines_encode(ids, N_IDS, crlf, text);
+    assert(len == (crlf ? 27 : 26) * (size_t)N_IDS);
+    for (size_t i = 0; i < N_IDS; i++) {
+      char str[SCRU128_STR_LEN];
+      scru128_to_str(ids + SCRU128_LEN * i, str);
+      const char *line = text + (crlf ? 27 : 26) * i;
+      assert(memcmp(line, str, 25) == 0);
+      assert(crlf ? line[25] == '\r' && line[26] == '\n' : line[25] == '\n');
+    }
+
+    size_t max_chunks[] = {1, 7, 30, 1000, sizeof(text)};
+    for (size_t j = 0; j < sizeof(max_chunks) / sizeof(max_chunks[0]); j++) {
+      memset(decoded, 0, sizeof(decoded));
+      assert(decode_in_chunks(len, max_chunks[j]) == N_IDS);
+      assert(memcmp(decoded, ids, sizeof(ids)) == 0);
+
+      // without the last newline
+      memset(decoded, 0, sizeof(decoded));
+      assert(decode_in_chunks(len - 1, max_chunks[j]) == N_IDS);
+      assert(memcmp(decoded, ids, sizeof(ids)) == 0);
+    }
+  }
+}
+
+/** Decodes mixed line endings and uppercase digits */
+void test_mixed_lines(void) {
+  generate_ids();
+  size_t len = 0;
+  for (size_t i = 0; i < N_IDS; i++) {
+    scru128_to_str(ids + SCRU128_LEN * i, text + len);
+    if (i % 3 == 0) {
+      for (size_t j = 0; j < 25; j++) {
+        text[len + j] = (char)toupper(text[len + j]);
+      }
+    }
+    len += 25;
+    if (i % 7 == 0) {
+      text[len++] = '\r';
+    }
+    text[len++] = '\n';
+  }
+  memset(decoded, 0, sizeof(decoded));
+  assert(decode_in_chunks(len, 1000) == N_IDS);
+  assert(memcmp(decoded, ids, sizeof(ids)) == 0);
+}
+
+/** Reports the line numbers of invalid lines and resumes after them */
+void test_invalid_lines(void) {
+  generate_ids();
+  size_t len = scru128_lines_encode(ids, N_IDS, 0, text);
+
+  const char *cases[] = {
+      "",
+      "\r",
+      "036z8puq4tsxsigk6o19y164",
+      "036z8puq4tsxsigk6o19y164qq",
+      "036z8puq4tsxsigk6o19y164q ",
+      " 036z8puq4tsxsigk6o19y164q",
+      "036z8puq4tsxsigk6o19y164q\r\r",
+      "036z8puq5a7j0t_08p2cdz28v",
+      "f5lxx1zz5pnorynqglhzmsp34",
+      "036z8puq4tsxsigk6o19y164q036z8puq4tsxsigk6o19y164q",
+  };
+  const size_t lines[] = {1, 2, 9, 10, 100, 1000, 5000, N_IDS};
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    for (size_t j = 0; j < sizeof(lines) / sizeof(lines[0]); j++) {
+      // replace the line with the invalid one
+      size_t at = 26 * (lines[j] - 1), bad_len = strlen(cases[i]);
+      char *tmp = (char *)malloc(len + bad_len);
+      memcpy(tmp, text, at);
+      memcpy(tmp + at, cases[i], bad_len);
+      memcpy(tmp + at + bad_len, text + at + 25, len - at - 25);
+      size_t tmp_len = len - 25 + bad_len;
+
+      for (size_t k = 0; k < 3; k++) {
+        size_t chunk_size = k == 0 ? 1 : k == 1 ? 100 : tmp_len;
+        Scru128LineDecoder d;
+        scru128_line_decoder_init(&d);
+        size_t count = 0, pos = 0, n_errors = 0;
+        while (pos < tmp_len) {
+          size_t chunk = tmp_len - pos;
+          chunk = chunk_size < chunk ? chunk_size : chunk;
+          size_t max_n = N_IDS - count < 64 ? N_IDS - count : 64;
+          size_t consumed;
+          ptrdiff_t n =
+              scru128_line_decoder_feed(&d, tmp + pos, chunk, &consumed,
+                                        decoded + SCRU128_LEN * count, max_n);
+          if (n < 0) {
+            assert(n == SCRU128_LINES_ERROR_SYNTAX && d.line == lines[j]);
+            n_errors++;
+          } else {
+            count += (size_t)n;
+          }
+          pos += consumed;
+        }
+        uint8_t *last = decoded + SCRU128_LEN * count;
+        if (scru128_line_decoder_finish(&d, last) < 0) {
+          assert(d.line == lines[j]);
+          n_errors++;
+        }
+        assert(n_errors == 1 && d.line == N_IDS);
+
+        // the valid lines are decoded around the invalid one
+        assert(count == N_IDS - 1);
+        size_t skip = SCRU128_LEN * (lines[j] - 1);
+        assert(memcmp(decoded, ids, skip) == 0);
+        assert(memcmp(decoded + skip, ids + skip + SCRU128_LEN,
+                      sizeof(ids) - skip - SCRU128_LEN) == 0);
+      }
+      free(tmp);
+    }
+  }
+}
+
+/** Reads and writes lines through streams and memory-mapped files */
+void test_streams(void) {
+  generate_ids();
+  char path[] = "/tmp/scru128_test_lines_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  FILE *fp = fdopen(fd, "w+");
+  assert(fp != NULL);
+
+  static Scru128LineWriter w;
+  scru128_line_writer_init(&w, fp, 1);
+  for (size_t i = 0; i < N_IDS;) {
+    size_t n = 1 + arc4random_uniform(1000);
+    n = n < N_IDS - i ? n : N_IDS - i;
+    assert(scru128_line_writer_write(&w, ids + SCRU128_LEN * i, n) == 0);
+    i += n;
+  }
+  assert(scru128_line_writer_flush(&w) == 0);
+  fputs("bad line\n", fp);
+  assert(fflush(fp) == 0);
+
+  static Scru128LineReader r;
+  rewind(fp);
+  scru128_line_reader_init(&r, fp);
+  memset(decoded, 0, sizeof(decoded));
+  size_t count = 0;
+  ptrdiff_t n;
+  while (count < N_IDS &&
+         (n = scru128_line_reader_read(&r, decoded + SCRU128_LEN * count,
+                                       N_IDS - count)) > 0) {
+    count += (size_t)n;
+  }
+  assert(count == N_IDS && memcmp(decoded, ids, sizeof(ids)) == 0);
+  n = scru128_line_reader_read(&r, decoded, N_IDS);
+  assert(n == SCRU128_LINES_ERROR_SYNTAX && r.decoder.line == N_IDS + 1);
+  assert(scru128_line_reader_read(&r, decoded, N_IDS) == 0);
+
+  const char *data;
+  size_t len;
+  assert(scru128_lines_map(path, &data, &len) == 0);
+  assert(len == 27 * (size_t)N_IDS + 9);
+  Scru128LineDecoder d;
+  scru128_line_decoder_init(&d);
+  size_t consumed;
+  memset(decoded, 0, sizeof(decoded));
+  assert(scru128_line_decoder_feed(&d, data, len, &consumed, decoded, N_IDS) ==
+         N_IDS);
+  assert(memcmp(decoded, ids, sizeof(ids)) == 0);
+  assert(scru128_line_decoder_feed(&d, data + consumed, len - consumed,
+                                   &consumed, decoded, N_IDS) ==
+         SCRU128_LINES_ERROR_SYNTAX);
+  scru128_lines_unmap(data, len);
+
+  fclose(fp);
+  remove(path);
+  assert(scru128_lines_map(path, &data, &len) == SCRU128_LINES_ERROR_IO);
+}
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s:\n", __FILE__);
+  run_test(test_round_trip);
+  run_test(test_mixed_lines);
+  run_test(test_invalid_lines);
+  run_test(test_streams);
+  return 0;
+}
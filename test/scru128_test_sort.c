@@ -0,0 +1,336 @@
+#define SCRU128_ENABLE_THREADS
+#include "scru128_sort.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_IDS 300000
+
+static const uint64_t MAX_UINT48 = ((uint64_t)1 << 48) - 1;
+
+static uint8_t input[N_IDS * SCRU128_LEN];
+static uint8_t expected[N_IDS * SCRU128_LEN];
+static uint8_t actual[N_IDS * SCRU128_LEN];
+static uint8_t scratch[N_IDS * SCRU128_LEN];
+
+int compare_ids(const void *lft, const void *rgt) {
+  return scru128_compare((const uint8_t *)lft, (const uint8_t *)rgt);
+}
+
+/** Shuffles `n` IDs in `ids` */
+void shuffle(uint8_t *ids, size_t n) {
+  uint8_t tmp[SCRU128_LEN];
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = arc4random_uniform((uint32_t)i + 1);
+    memcpy(tmp, ids + SCRU128_LEN * i, SCRU128_LEN);
+    memcpy(ids + SCRU128_LEN * i, ids + SCRU128_LEN * j, SCRU128_LEN);
+    memcpy(ids + SCRU128_LEN * j, tmp, SCRU128_LEN);
+  }
+}
+
+/** Sorts the first `n` IDs of `input` in every mode and checks the results */
+void check_all_modes(size_t n) {
+  memcpy(expected, input, SCRU128_LEN * n);
+  qsort(expected, n, SCRU128_LEN, &compare_ids);
+
+  memcpy(actual, input, SCRU128_LEN * n);
+  scru128_sort(actual, n);
+  assert(memcmp(actual, expected, SCRU128_LEN * n) == 0);
+
+  memcpy(actual, input, SCRU128_LEN * n);
+  scru128_sort_with_scratch(actual, n, scratch);
+  assert(memcmp(actual, expected, SCRU128_LEN * n) == 0);
+
+  memcpy(actual, input, SCRU128_LEN * n);
+  scru128_sort_parallel(actual, n, scratch, 4);
+  assert(memcmp(actual, expected, SCRU128_LEN * n) == 0);
+
+  memcpy(actual, input, SCRU128_LEN * n);
+  scru128_sort_parallel(actual, n, NULL, 4);
+  assert(memcmp(actual, expected, SCRU128_LEN * n) == 0);
+}
+
+/** Sorts uniformly random byte strings */
+void test_random_bytes(void) {
+  arc4random_buf(input, sizeof(input));
+  check_all_modes(N_IDS);
+}
+
+/** Sorts shuffled IDs generated within a short time window */
+void test_generated_ids(void) {
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  uint64_t ts = 0x0123456789ab;
+  for (size_t i = 0; i < N_IDS; i++) {
+    int status = scru128_generate_or_reset_core(
+        &g, input + SCRU128_LEN * i, ts + i / 1000, &arc4random, 10000);
+    assert(status >= 0);
+  }
+  shuffle(input, N_IDS);
+  check_all_modes(N_IDS);
+}
+
+/** Sorts IDs with many duplicates and varying common prefixes */
+void test_duplicates(void) {
+  for (size_t i = 0; i < N_IDS; i++) {
+    uint8_t *id = input + SCRU128_LEN * i;
+    memset(id, 0x5a, SCRU128_LEN);
+    id[3] = (uint8_t)(i % 3);
+    id[15] = (uint8_t)arc4random_uniform(4);
+  }
+  check_all_modes(N_IDS);
+
+  memset(input, 0xff, SCRU128_LEN * N_IDS);
+  check_all_modes(N_IDS);
+}
+
+/** Sorts arrays around the insertion sort threshold */
+void test_small_arrays(void) {
+  size_t sizes[] = {0, 1, 2, 3, 31, 32, 33, 100, 1000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    arc4random_buf(input, SCRU128_LEN * sizes[i]);
+    check_all_modes(sizes[i]);
+  }
+}
+
+/** Returns the first index whose timestamp is not less than `ts` by scan */
+size_t scan_lower_bound(const uint8_t *ids, size_t n, uint64_t ts) {
+  size_t i = 0;
+  while (i < n && scru128_timestamp(ids + SCRU128_LEN * i) < ts) {
+    i++;
+  }
+  return i;
+}
+
+/** Checks the search functions against linear scans around each timestamp */
+void check_search(const uint8_t *ids, size_t n) {
+  uint64_t lo = n > 0 ? scru128_timestamp(ids) : 1000;
+  uint64_t hi = n > 0 ? scru128_timestamp(ids + SCRU128_LEN * (n - 1)) : 1000;
+  for (int i = 0; i < 100; i++) {
+    // pick a timestamp in the array or around it
+    uint64_t ts = (uint64_t)arc4random() << 32 | arc4random();
+    if (n > 0 && i % 2 == 0) {
+      ts = scru128_timestamp(ids + SCRU128_LEN * (ts % n));
+    } else {
+      ts = lo - 5 + ts % (hi - lo + 10);
+    }
+    size_t lower = scru128_lower_bound_timestamp(ids, n, ts);
+    assert(lower == scan_lower_bound(ids, n, ts));
+    size_t upper = scru128_upper_bound_timestamp(ids, n, ts);
+    assert(upper == scan_lower_bound(ids, n, ts + 1));
+
+    uint64_t ts_to = ts + arc4random_uniform(100);
+    size_t start;
+    size_t len = scru128_find_timestamp_range(ids, n, ts, ts_to, &start);
+    assert(start == lower);
+    assert(start + len == scan_lower_bound(ids, n, ts_to + 1));
+  }
+}
+
+/** Finds time ranges in sorted arrays of various distributions */
+void test_search_timestamp(void) {
+  Scru128Generator g;
+  uint64_t ts;
+
+  // evenly spread
+  scru128_generator_init(&g);
+  ts = 0x0123456789ab;
+  for (size_t i = 0; i < N_IDS; i++) {
+    ts += arc4random_uniform(3);
+    scru128_generate_or_abort_core(&g, input + SCRU128_LEN * i, ts,
+                                   &arc4random, 10000);
+  }
+  check_search(input, N_IDS);
+  check_search(input, 1);
+  check_search(input, 0);
+
+  // bursts separated by long gaps
+  scru128_generator_init(&g);
+  ts = 0x0123456789ab;
+  for (size_t i = 0; i < N_IDS; i++) {
+    ts += i % 1000 == 0 ? arc4random_uniform(1 << 20) : 0;
+    ts += i % 100000 == 0 ? (uint64_t)1 << 40 : 0;
+    scru128_generate_or_abort_core(&g, input + SCRU128_LEN * i, ts,
+                                   &arc4random, 10000);
+  }
+  check_search(input, N_IDS);
+
+  // single timestamp
+  scru128_generator_init(&g);
+  for (size_t i = 0; i < 1000; i++) {
+    scru128_generate_or_abort_core(&g, input + SCRU128_LEN * i, 42,
+                                   &arc4random, 10000);
+  }
+  check_search(input, 1000);
+  assert(scru128_upper_bound_timestamp(input, 1000, MAX_UINT48) == 1000);
+}
+
+/** Builds the smallest and largest IDs of a timestamp */
+void test_min_max_for_timestamp(void) {
+  uint8_t min[SCRU128_LEN], max[SCRU128_LEN], x[SCRU128_LEN];
+  assert(scru128_min_for_timestamp(min, 0x0123456789ab) == 0);
+  assert(scru128_max_for_timestamp(max, 0x0123456789ab) == 0);
+  assert(scru128_timestamp(min) == 0x0123456789ab);
+  assert(scru128_timestamp(max) == 0x0123456789ab);
+
+  Scru128Generator g;
+  scru128_generator_init(&g);
+  for (int i = 0; i < 1000; i++) {
+    scru128_generate_or_abort_core(&g, x, 0x0123456789ab, &arc4random, 10000);
+    assert(scru128_compare(min, x) <= 0 && scru128_compare(x, max) <= 0);
+  }
+
+  assert(scru128_max_for_timestamp(x, 0x0123456789aa) == 0);
+  assert(scru128_compare(x, min) < 0);
+  assert(scru128_min_for_timestamp(x, 0x0123456789ac) == 0);
+  assert(scru128_compare(max, x) < 0);
+
+  assert(scru128_min_for_timestamp(x, MAX_UINT48 + 1) != 0);
+  assert(scru128_max_for_timestamp(x, MAX_UINT48 + 1) != 0);
+}
+
+/** Represents a run of IDs read in small random chunks */
+struct Cursor {
+  const uint8_t *ids;
+  size_t n;
+  size_t pos;
+  int fail_at_end;
+};
+
+ptrdiff_t pull_cursor(void *ctx, uint8_t *ids_out, size_t max_n) {
+  struct Cursor *c = (struct Cursor *)ctx;
+  if (c->pos == c->n && c->fail_at_end) {
+    return -1;
+  }
+  size_t n = arc4random_uniform((uint32_t)max_n) + 1;
+  n = n < c->n - c->pos ? n : c->n - c->pos;
+  memcpy(ids_out, c->ids + SCRU128_LEN * c->pos, SCRU128_LEN * n);
+  c->pos += n;
+  return (ptrdiff_t)n;
+}
+
+#define N_RUNS 37
+
+/**
+ * Merges the runs of `input` bounded by `bounds` and checks the result against
+ * `expected` of length `n_expected`
+ */
+void check_merge(const size_t *bounds, size_t n_runs, int dedup,
+                 size_t n_expected) {
+  struct Cursor cursors[N_RUNS];
+  Scru128MergeSource sources[N_RUNS];
+  for (size_t i = 0; i < n_runs; i++) {
+    cursors[i].ids = input + SCRU128_LEN * bounds[i];
+    cursors[i].n = bounds[i + 1] - bounds[i];
+    cursors[i].pos = 0;
+    cursors[i].fail_at_end = 0;
+    sources[i].ctx = &cursors[i];
+    sources[i].pull = &pull_cursor;
+  }
+
+  Scru128Merger m;
+  int err = scru128_merger_init(&m, sources, n_runs, dedup);
+  assert(err == 0);
+  size_t n_merged = 0;
+  for (;;) {
+    size_t chunk = arc4random_uniform(1000) + 1;
+    ptrdiff_t n = scru128_merger_read(&m, actual + SCRU128_LEN * n_merged,
+                                      chunk);
+    assert(n >= 0 && (size_t)n <= chunk);
+    n_merged += (size_t)n;
+    if ((size_t)n < chunk) {
+      break;
+    }
+  }
+  assert(scru128_merger_read(&m, actual, 1) == 0);
+  scru128_merger_destroy(&m);
+
+  assert(n_merged == n_expected);
+  assert(memcmp(actual, expected, SCRU128_LEN * n_expected) == 0);
+}
+
+/** Merges sorted runs with and without duplicates */
+void test_merge(void) {
+  // runs of various lengths (including empty ones) from distinct generators
+  size_t bounds[N_RUNS + 1] = {0};
+  for (size_t i = 0; i < N_RUNS; i++) {
+    size_t len = i % 5 == 0 ? 0 : arc4random_uniform(N_IDS / N_RUNS);
+    bounds[i + 1] = bounds[i] + len;
+    Scru128Generator g;
+    scru128_generator_init(&g);
+    for (size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+      scru128_generate_or_abort_core(&g, input + SCRU128_LEN * j,
+                                     0x0123456789ab + j % 1000 + j / 1000,
+                                     &arc4random, 10000);
+    }
+  }
+  size_t n = bounds[N_RUNS];
+  memcpy(expected, input, SCRU128_LEN * n);
+  qsort(expected, n, SCRU128_LEN, &compare_ids);
+  check_merge(bounds, N_RUNS, 0, n);
+  check_merge(bounds, N_RUNS, 1, n);
+  check_merge(bounds, 1, 0, bounds[1]);
+  check_merge(bounds, 0, 0, 0);
+
+  // runs sharing many IDs
+  for (size_t i = 0; i < N_RUNS; i++) {
+    bounds[i + 1] = bounds[i] + 1000;
+    for (size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+      scru128_from_fields(input + SCRU128_LEN * j, 42, 0, 0,
+                          (uint32_t)((j - bounds[i]) * (i % 4 + 1) / 2));
+    }
+  }
+  memcpy(expected, input, SCRU128_LEN * bounds[N_RUNS]);
+  qsort(expected, bounds[N_RUNS], SCRU128_LEN, &compare_ids);
+  check_merge(bounds, N_RUNS, 0, bounds[N_RUNS]);
+
+  n = 1;
+  for (size_t i = 1; i < bounds[N_RUNS]; i++) {
+    if (scru128_compare(expected + SCRU128_LEN * (n - 1),
+                        expected + SCRU128_LEN * i) != 0) {
+      memcpy(expected + SCRU128_LEN * n++, expected + SCRU128_LEN * i,
+             SCRU128_LEN);
+    }
+  }
+  check_merge(bounds, N_RUNS, 1, n);
+}
+
+/** Reports errors of sources */
+void test_merge_error(void) {
+  struct Cursor cursors[2] = {{input, 300, 0, 0}, {input, 300, 0, 1}};
+  Scru128MergeSource sources[2] = {{&cursors[0], &pull_cursor},
+                                   {&cursors[1], &pull_cursor}};
+  Scru128Merger m;
+  int err = scru128_merger_init(&m, sources, 2, 0);
+  assert(err == 0);
+  ptrdiff_t n = scru128_merger_read(&m, actual, 1000);
+  assert(n < 0);
+  assert(scru128_merger_read(&m, actual, 1000) < 0);
+  scru128_merger_destroy(&m);
+
+  cursors[1].n = 0;
+  cursors[1].pos = 0;
+  err = scru128_merger_init(&m, sources, 2, 0);
+  assert(err != 0);
+}
+
+#define run_test(NAME)                                                         \
+  do {                                                                         \
+    (NAME)();                                                                  \
+    printf("  %s: ok\n", #NAME);                                               \
+  } while (0)
+
+int main(void) {
+  printf("%s:\n", __FILE__);
+  run_test(test_random_bytes);
+  run_test(test_generated_ids);
+  run_test(test_duplicates);
+  run_test(test_small_arrays);
+  run_test(test_search_timestamp);
+  run_test(test_min_max_for_timestamp);
+  run_test(test_merge);
+  run_test(test_merge_error);
+  return 0;
+}